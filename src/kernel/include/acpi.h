@@ -0,0 +1,194 @@
+/**
+ * \file acpi.h
+ * \brief Functions, definitions and structures for reading the ACPI tables. The multiple APIC
+ * description table (MADT) is used to find the CPUs, the local APIC address, the I/O APICs and how
+ * the ISA IRQs are wired to them. The HPET table gives the address of the HPET.
+ */
+#ifndef INCLUDE_ACPI_H
+#define INCLUDE_ACPI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The maximum number of CPUs recorded from the MADT.
+ */
+#define ACPI_MAX_CPUS				16
+
+/**
+ * \brief The maximum number of I/O APICs recorded from the MADT.
+ */
+#define ACPI_MAX_IOAPICS			4
+
+/**
+ * \brief The maximum number of ISA IRQ overrides recorded from the MADT.
+ */
+#define ACPI_MAX_IRQ_OVERRIDES		16
+
+/**
+ * \brief The MADT entry type for a CPU and its local APIC.
+ */
+#define ACPI_MADT_LAPIC				0
+
+/**
+ * \brief The MADT entry type for an I/O APIC.
+ */
+#define ACPI_MADT_IOAPIC			1
+
+/**
+ * \brief The MADT entry type for an ISA IRQ that isn't wired to the I/O APIC input of the same
+ * number.
+ */
+#define ACPI_MADT_IRQ_OVERRIDE		2
+
+/**
+ * \brief The flag in a MADT CPU entry for whether the CPU can be used.
+ */
+#define ACPI_MADT_LAPIC_ENABLED		0x01
+
+/**
+ * \struct acpi_rsdp_t
+ * 
+ * \brief The root system description pointer, found by searching the BIOS memory.
+ */
+typedef struct {
+	char signature[8];			/**< "RSD PTR ". */
+	uint8_t checksum;			/**< Makes the bytes of the structure add up to zero. */
+	char oem_id[6];				/**< The OEM. */
+	uint8_t revision;			/**< 0 for ACPI 1.0, 2 for the extended version. */
+	uint32_t rsdt_address;		/**< The physical address of the RSDT. */
+} __attribute__((__packed__)) acpi_rsdp_t;
+
+/**
+ * \struct acpi_header_t
+ * 
+ * \brief The header at the start of every ACPI table.
+ */
+typedef struct {
+	char signature[4];			/**< The table type, such as "APIC" for the MADT. */
+	uint32_t length;			/**< The length of the table including the header. */
+	uint8_t revision;			/**< The table revision. */
+	uint8_t checksum;			/**< Makes the bytes of the table add up to zero. */
+	char oem_id[6];				/**< The OEM. */
+	char oem_table_id[8];		/**< The OEM table ID. */
+	uint32_t oem_revision;		/**< The OEM revision. */
+	uint32_t creator_id;		/**< The vendor of the tool that made the table. */
+	uint32_t creator_revision;	/**< The version of the tool that made the table. */
+} __attribute__((__packed__)) acpi_header_t;
+
+/**
+ * \struct acpi_madt_t
+ * 
+ * \brief The multiple APIC description table. Is followed by the variable length entries.
+ */
+typedef struct {
+	acpi_header_t header;		/**< The table header. */
+	uint32_t lapic_address;		/**< The physical address of the local APIC of each CPU. */
+	uint32_t flags;				/**< Bit 0 is set if there are also legacy PICs. */
+} __attribute__((__packed__)) acpi_madt_t;
+
+/**
+ * \struct acpi_hpet_t
+ * 
+ * \brief The HPET description table.
+ */
+typedef struct {
+	acpi_header_t header;		/**< The table header. */
+	uint32_t block_id;			/**< The hardware ID of the timer block. */
+	uint8_t space_id;			/**< The address space of the registers, 0 for memory. */
+	uint8_t bit_width;			/**< The register width. */
+	uint8_t bit_offset;			/**< The register offset. */
+	uint8_t access_size;		/**< The access size. */
+	uint64_t address;			/**< The physical address of the registers. */
+	uint8_t number;				/**< The sequence number of the HPET. */
+	uint16_t min_tick;			/**< The fewest counts a periodic timer can be set to without losing interrupts. */
+	uint8_t page_protection;	/**< The page protection of the registers. */
+} __attribute__((__packed__)) acpi_hpet_t;
+
+/**
+ * \struct acpi_ioapic_t
+ * 
+ * \brief An I/O APIC from the MADT.
+ */
+typedef struct {
+	uint8_t id;					/**< The I/O APIC ID. */
+	uint32_t address;			/**< The physical address of its registers. */
+	uint32_t gsi_base;			/**< The global system interrupt of its first input. */
+} acpi_ioapic_t;
+
+/**
+ * \struct acpi_irq_override_t
+ * 
+ * \brief An ISA IRQ that is wired to a different I/O APIC input, or isn't edge triggered active
+ * high.
+ */
+typedef struct {
+	uint8_t irq;				/**< The ISA IRQ. */
+	uint32_t gsi;				/**< The global system interrupt it is wired to. */
+	uint16_t flags;				/**< The polarity in bits 0-1 and trigger mode in bits 2-3. */
+} acpi_irq_override_t;
+
+/**
+ * \brief Find and read the MADT and the HPET table. The tables are identity mapped as they are
+ * read.
+ * 
+ * \return Whether the MADT was found.
+ */
+bool acpi_init(void);
+
+/**
+ * \brief Get the number of usable CPUs in the MADT.
+ * 
+ * \return The number of CPUs, 0 if there is no MADT.
+ */
+uint32_t acpi_get_cpu_count(void);
+
+/**
+ * \brief Get the local APIC ID of a CPU from the MADT.
+ * 
+ * \param [in] index The index of the CPU, less than \ref acpi_get_cpu_count.
+ * 
+ * \return The local APIC ID.
+ */
+uint8_t acpi_get_lapic_id(uint32_t index);
+
+/**
+ * \brief Get the physical address of the local APIC.
+ * 
+ * \return The address, 0 if there is no MADT.
+ */
+uint32_t acpi_get_lapic_address(void);
+
+/**
+ * \brief Get the number of I/O APICs in the MADT.
+ * 
+ * \return The number of I/O APICs.
+ */
+uint32_t acpi_get_ioapic_count(void);
+
+/**
+ * \brief Get an I/O APIC from the MADT.
+ * 
+ * \param [in] index The index of the I/O APIC, less than \ref acpi_get_ioapic_count.
+ * 
+ * \return The I/O APIC.
+ */
+const acpi_ioapic_t * acpi_get_ioapic(uint32_t index);
+
+/**
+ * \brief Find the override for an ISA IRQ.
+ * 
+ * \param [in] irq The ISA IRQ.
+ * 
+ * \return The override. NULL if the IRQ is wired to the I/O APIC input of the same number.
+ */
+const acpi_irq_override_t * acpi_get_irq_override(uint8_t irq);
+
+/**
+ * \brief Get the physical address of the HPET registers.
+ * 
+ * \return The address, 0 if there is no HPET table or the HPET is above 4GB or not in memory.
+ */
+uint32_t acpi_get_hpet_address(void);
+
+#endif /* INCLUDE_ACPI_H */
@@ -0,0 +1,73 @@
+/**
+ * \file alloc_trace.h
+ * \brief Functions, definitions and structures for the allocation tracker. Counts the number of
+ * allocations, bytes and live objects for each call site that allocates memory. Only built in when
+ * the kernel is compiled with ALLOC_TRACE defined (make ALLOC_TRACE=1), else the hooks are empty.
+ */
+#ifndef INCLUDE_ALLOC_TRACE_H
+#define INCLUDE_ALLOC_TRACE_H
+
+#include <stdint.h>
+
+/**
+ * \brief The number of call sites that can be tracked. Must be a power of 2.
+ */
+#define ALLOC_TRACE_SITES		128
+
+/**
+ * \brief The number of live allocations that can be tracked. Must be a power of 2.
+ */
+#define ALLOC_TRACE_LIVE		1024
+
+/**
+ * \struct alloc_trace_site_t
+ * 
+ * \brief The counters for a single call site.
+ */
+typedef struct {
+	uint32_t call_site;		/**< The return address of the call to the allocator, 0 if the entry is unused. */
+	uint32_t count;			/**< The number of allocations made from this call site. */
+	uint32_t bytes;			/**< The total number of bytes allocated from this call site. */
+	uint32_t live;			/**< The number of allocations from this call site not yet freed. */
+} alloc_trace_site_t;
+
+#ifdef ALLOC_TRACE
+
+/**
+ * \brief Record an allocation. Call with __builtin_return_address(0) from the allocator.
+ * 
+ * \param [in] call_site The address the allocator was called from.
+ * \param [in] ptr The allocated memory. If NULL, then only the count and bytes are recorded and the
+ * allocation isn't tracked as live, used for allocations that can't be freed on their own.
+ * \param [in] size The number of bytes allocated.
+ */
+void alloc_trace_alloc(void * call_site, void * ptr, uint32_t size);
+
+/**
+ * \brief Record that an allocation was freed.
+ * 
+ * \param [in] ptr The memory that was freed.
+ */
+void alloc_trace_free(void * ptr);
+
+#else
+
+static inline void alloc_trace_alloc(void * call_site, void * ptr, uint32_t size) {
+	(void) call_site;
+	(void) ptr;
+	(void) size;
+}
+
+static inline void alloc_trace_free(void * ptr) {
+	(void) ptr;
+}
+
+#endif /* ALLOC_TRACE */
+
+/**
+ * \brief Print the call sites sorted by the number of bytes allocated, with the symbol from the
+ * kernel map each call site is in.
+ */
+void alloc_trace_dump(void);
+
+#endif /* INCLUDE_ALLOC_TRACE_H */
@@ -0,0 +1,89 @@
+/**
+ * \file arena.h
+ * \brief Functions, definitions and structures for a region (arena) allocator. Memory is handed
+ * out by bumping a pointer through blocks from the physical memory manager and is all given back
+ * at once when the arena is reset or destroyed, so there is no per-object free.
+ */
+#ifndef INCLUDE_ARENA_H
+#define INCLUDE_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \brief The alignment of every allocation from an arena in bytes.
+ */
+#define ARENA_ALIGNMENT		8
+
+/**
+ * \struct arena_chunk_t
+ * 
+ * \brief The header at the start of each set of continues blocks that an arena bumps through.
+ */
+typedef struct arena_chunk {
+	struct arena_chunk * next;		/**< The next chunk in the arena, NULL if the last chunk. */
+	uint32_t num_blocks;			/**< The number of physical blocks this chunk is made of. */
+	uint32_t size;					/**< The total size of the chunk in bytes including this header. */
+} arena_chunk_t;
+
+/**
+ * \struct arena_t
+ * 
+ * \brief The arena structure. This lives at the start of the first chunk so creating an arena
+ * doesn't need any other memory.
+ */
+typedef struct {
+	arena_chunk_t * head;			/**< The first chunk. This is kept when the arena is reset. */
+	arena_chunk_t * current;		/**< The chunk currently being allocated from. */
+	uint32_t offset;				/**< The offset into the current chunk of the next free byte. */
+	uint32_t chunk_blocks;			/**< The number of blocks to allocate each time the arena grows. */
+	uint32_t used;					/**< The number of bytes handed out since created or last reset. */
+} arena_t;
+
+/**
+ * \brief Create an arena backed by \p num_blocks continues physical blocks. More blocks are
+ * allocated if the arena runs out of space.
+ * 
+ * \param [in] num_blocks The number of physical blocks for the first chunk and each time the arena
+ * grows. Must be at least 1.
+ * 
+ * \return The arena. If there isn't enough physical memory, then returns NULL.
+ */
+arena_t * arena_create(uint32_t num_blocks);
+
+/**
+ * \brief Allocate \p size bytes from the arena, aligned to \ref ARENA_ALIGNMENT. If the current
+ * chunk is full, then a new chunk is allocated that is big enough for \p size.
+ * 
+ * \param [in] arena The arena to allocate from.
+ * \param [in] size The number of bytes to allocate.
+ * 
+ * \return The pointer to the allocated memory. If no more physical memory, then returns NULL.
+ */
+void * arena_alloc(arena_t * arena, size_t size);
+
+/**
+ * \brief Free everything that was allocated from the arena. The first chunk is kept so the arena
+ * can be used again, any extra chunks are given back to the physical memory manager.
+ * 
+ * \param [in] arena The arena to reset.
+ */
+void arena_reset(arena_t * arena);
+
+/**
+ * \brief Free the arena and all the physical blocks it uses. The arena can't be used after this.
+ * 
+ * \param [in] arena The arena to destroy.
+ */
+void arena_destroy(arena_t * arena);
+
+/**
+ * \brief Get the total number of bytes the arena has handed out since it was created or reset.
+ * 
+ * \param [in] arena The arena.
+ * 
+ * \return The number of bytes used.
+ */
+uint32_t arena_get_used(arena_t * arena);
+
+#endif /* INCLUDE_ARENA_H */
@@ -0,0 +1,172 @@
+/**
+ * \file async.h
+ * \brief Functions, definitions and structures for stackless coroutines. A coroutine is a function
+ * that returns where it would wait, and is called again from where it left off once a timer, the
+ * keyboard or an IRQ handler wakes it. The resume point is the line of the wait, so switching in
+ * and out is a function call and a jump, with no stack or thread of its own.
+ * 
+ * The woken coroutines are run as deferred work, so they run with interrupts enabled but mustn't
+ * block, and never at the same time as each other. Locals aren't kept between waits, so anything
+ * that lives across a wait must be in the argument or a static.
+ */
+#ifndef INCLUDE_ASYNC_H
+#define INCLUDE_ASYNC_H
+
+#include <timer.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief What a coroutine returns.
+ */
+typedef enum {
+	ASYNC_WAITING,			/**< The coroutine is waiting to be woken. */
+	ASYNC_DONE				/**< The coroutine has finished. */
+} async_status_t;
+
+struct async;
+
+/**
+ * \typedef typedef async_status_t (*async_func_t)(struct async * task)
+ * \brief The type of a coroutine. Must start with \ref ASYNC_BEGIN and end with \ref ASYNC_END.
+ * \param [in] task The coroutine being run.
+ * \return Whether the coroutine is waiting or done.
+ */
+typedef async_status_t (*async_func_t)(struct async * task);
+
+/**
+ * \struct async_t
+ * 
+ * \brief A coroutine. Owned by the caller, so can be woken from an IRQ handler without allocating
+ * memory.
+ */
+typedef struct async {
+	uint32_t resume;				/**< The line to resume from, 0 to start at the top. */
+	async_func_t func;				/**< The function of the coroutine. */
+	void * arg;						/**< The argument for \ref func. */
+	bool active;					/**< Whether the coroutine has started and not finished. */
+	bool ready;						/**< Whether the coroutine is in the ready queue. */
+	struct async * next;			/**< The next coroutine in the ready queue. */
+	struct async_event * event;		/**< The event the coroutine is waiting for. NULL if none. */
+	struct async * wait_next;		/**< The next coroutine waiting for the same event. */
+	timer_t timer;					/**< The timer of \ref ASYNC_SLEEP. */
+} async_t;
+
+/**
+ * \struct async_event_t
+ * 
+ * \brief Something coroutines can wait for, signalled by an IRQ handler or a thread. A signal with
+ * no one waiting is kept, so a coroutine that checks a condition then waits can't miss it.
+ */
+typedef struct async_event {
+	async_t * waiters;				/**< The coroutines waiting for the event. */
+	bool pending;					/**< Whether there was a signal with no one waiting. */
+} async_event_t;
+
+/**
+ * \brief Start the body of a coroutine, jumping to where it left off.
+ */
+#define ASYNC_BEGIN(task)			switch((task)->resume) { case 0:
+
+/**
+ * \brief End the body of a coroutine. Returning from here finishes the coroutine.
+ */
+#define ASYNC_END(task)				} (task)->resume = 0; return ASYNC_DONE
+
+/**
+ * \brief Return from the coroutine, to carry on from the line after once woken. Only one on a line.
+ */
+#define ASYNC_WAIT(task)			do { (task)->resume = __LINE__; return ASYNC_WAITING; case __LINE__:; } while(0)
+
+/**
+ * \brief Let the other ready coroutines run, then carry on.
+ */
+#define ASYNC_YIELD(task)			do { async_wake(task); ASYNC_WAIT(task); } while(0)
+
+/**
+ * \brief Wait for a number of milliseconds.
+ */
+#define ASYNC_SLEEP(task, ms)		do { async_sleep(task, ms); ASYNC_WAIT(task); } while(0)
+
+/**
+ * \brief Wait for an event to be signalled.
+ */
+#define ASYNC_WAIT_EVENT(task, e)	do { async_event_wait(e, task); ASYNC_WAIT(task); } while(0)
+
+/**
+ * \brief Wait on an event until a condition is true.
+ */
+#define ASYNC_WAIT_UNTIL(task, e, condition)	while(!(condition)) { ASYNC_WAIT_EVENT(task, e); }
+
+/**
+ * \brief Set up the deferred work that runs the coroutines.
+ */
+void async_init(void);
+
+/**
+ * \brief Start a coroutine from the top. It runs on the next deferred work.
+ * 
+ * \param [in] task The coroutine.
+ * \param [in] func The function of the coroutine.
+ * \param [in] arg The argument for \p func.
+ * 
+ * \return Whether it was started. False if it is already active.
+ */
+bool async_start(async_t * task, async_func_t func, void * arg);
+
+/**
+ * \brief Stop a coroutine wherever it is waiting.
+ * 
+ * \param [in] task The coroutine.
+ */
+void async_cancel(async_t * task);
+
+/**
+ * \brief Whether a coroutine has started and not finished.
+ * 
+ * \param [in] task The coroutine.
+ * 
+ * \return Whether it is active.
+ */
+bool async_active(async_t * task);
+
+/**
+ * \brief Put a coroutine in the ready queue. Can be called from an IRQ handler.
+ * 
+ * \param [in] task The coroutine.
+ */
+void async_wake(async_t * task);
+
+/**
+ * \brief Wake a coroutine after a number of milliseconds. Used by \ref ASYNC_SLEEP.
+ * 
+ * \param [in] task The coroutine.
+ * \param [in] milliseconds How long to wait.
+ */
+void async_sleep(async_t * task, uint32_t milliseconds);
+
+/**
+ * \brief Set up an event that hasn't been signalled.
+ * 
+ * \param [in] event The event.
+ */
+void async_event_init(async_event_t * event);
+
+/**
+ * \brief Make a coroutine wait for an event. Used by \ref ASYNC_WAIT_EVENT. If the event was
+ * signalled with no one waiting, then the coroutine is woken straight away.
+ * 
+ * \param [in] event The event.
+ * \param [in] task The coroutine.
+ */
+void async_event_wait(async_event_t * event, async_t * task);
+
+/**
+ * \brief Wake every coroutine waiting for an event. Can be called from an IRQ handler.
+ * 
+ * \param [in] event The event.
+ */
+void async_event_signal(async_event_t * event);
+
+#endif /* INCLUDE_ASYNC_H */
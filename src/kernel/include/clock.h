@@ -0,0 +1,97 @@
+/**
+ * \file clock.h
+ * \brief Functions, definitions and structures for the monotonic clock, the time since boot in
+ * nanoseconds. It is read from the best rated clock source, a free running counter that doesn't
+ * wrap, so is a read and a multiply. The TSC is timed against counter 2 of the PIT at boot to find
+ * its frequency, and is the first source. Without any source, the clock falls back to the tick.
+ * 
+ * A TSC that isn't invariant can change rate with the CPU frequency, so is rated below the HPET.
+ * This kernel doesn't change the CPU frequency or use deep sleep states, so it is still used when
+ * there is nothing better.
+ */
+#ifndef INCLUDE_CLOCK_H
+#define INCLUDE_CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The number of nanoseconds in a second.
+ */
+#define CLOCK_NS_PER_SEC			1000000000
+
+/**
+ * \brief The number of milliseconds counter 2 of the PIT counts for to time the TSC.
+ */
+#define CLOCK_CALIBRATE_MS			50
+
+/**
+ * \brief The number of bits of fraction in the multiplier from TSC cycles to nanoseconds.
+ */
+#define CLOCK_SHIFT					24
+
+/**
+ * \brief The lowest frequency of a clock source in kHz. Below it the multiplier from counts to
+ * nanoseconds, with \ref CLOCK_SHIFT bits of fraction, doesn't fit in 32 bits. 3907kHz.
+ */
+#define CLOCK_MIN_KHZ				((1000000 >> (32 - CLOCK_SHIFT)) + 1)
+
+/**
+ * \struct clock_source_t
+ * 
+ * \brief A clock source. Owned by the driver, so must stay valid once registered.
+ */
+typedef struct {
+	const char * name;			/**< The name of the source. */
+	uint32_t rating;			/**< How good the source is. The highest rated is used for the clock. */
+	uint32_t khz;				/**< The number of counts a millisecond. At least \ref CLOCK_MIN_KHZ. */
+	uint64_t (*read)(void);		/**< Read the counter, which must not wrap. */
+} clock_source_t;
+
+/**
+ * \brief Find the frequency of the TSC and start the clock from 0. Must be called after
+ * \ref cpu_features_init.
+ */
+void clock_init(void);
+
+/**
+ * \brief Register a clock source. If it is rated higher than the current source, then the clock
+ * is read from it, carrying on from the time now. A source slower than \ref CLOCK_MIN_KHZ is
+ * ignored.
+ * 
+ * \param [in] source The source to register.
+ */
+void clock_register(clock_source_t * source);
+
+/**
+ * \brief Get the time since \ref clock_init. Doesn't go back when the source changes.
+ * 
+ * \return The number of nanoseconds.
+ */
+uint64_t clock_monotonic_ns(void);
+
+/**
+ * \brief Convert a number of TSC cycles, such as the difference of two \ref cpu_rdtsc, to
+ * nanoseconds.
+ * 
+ * \param [in] cycles The number of cycles.
+ * 
+ * \return The number of nanoseconds. 0 if there is no TSC.
+ */
+uint64_t clock_cycles_to_ns(uint64_t cycles);
+
+/**
+ * \brief Get the frequency of the TSC.
+ * 
+ * \return The frequency in kHz. 0 if the clock isn't using the TSC.
+ */
+uint32_t clock_get_tsc_khz(void);
+
+/**
+ * \brief Get whether the TSC runs at a constant rate in all power states.
+ * 
+ * \return Whether the TSC is invariant.
+ */
+bool clock_tsc_is_invariant(void);
+
+#endif /* INCLUDE_CLOCK_H */
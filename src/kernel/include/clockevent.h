@@ -0,0 +1,101 @@
+/**
+ * \file clockevent.h
+ * \brief Functions, definitions and structures for the clock event devices, the timers that can
+ * raise an interrupt after a number of counts. The best device that can run periodically drives
+ * the kernel tick, and is put into one shot mode by the idle thread so the CPU isn't woken each
+ * tick while nothing is due.
+ * 
+ * Whichever device is the tick, it raises IRQ 0, so the IRQ counts, waking from idle and
+ * preemption at the end of the IRQ work the same for all of them.
+ */
+#ifndef INCLUDE_CLOCKEVENT_H
+#define INCLUDE_CLOCKEVENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The frequency of the kernel tick.
+ */
+#define CLOCKEVENT_HZ				1000
+
+/**
+ * \brief What a clock event device can do.
+ */
+typedef enum {
+	CLOCKEVENT_PERIODIC		= 0x01,	/**< Can interrupt every number of counts. */
+	CLOCKEVENT_ONESHOT		= 0x02,	/**< Can interrupt once after a number of counts. */
+	CLOCKEVENT_DEADLINE		= 0x04	/**< The one shot is programmed as a deadline, so doesn't drift. */
+} clockevent_feature_t;
+
+/**
+ * \struct clockevent_t
+ * 
+ * \brief A clock event device. Owned by the driver, so must stay valid once registered.
+ */
+typedef struct clockevent {
+	const char * name;						/**< The name of the device. */
+	uint32_t features;						/**< What the device can do, the clockevent_feature_t flags. */
+	uint32_t rating;						/**< How good the device is. The highest rated is used for the tick. */
+	uint32_t frequency;						/**< The number of counts a second. */
+	uint32_t max_count;						/**< The most counts a one shot can be programmed with. */
+	void (*set_periodic)(uint32_t count);	/**< Interrupt every \p count counts. */
+	void (*set_oneshot)(uint32_t count);	/**< Interrupt once after \p count counts. */
+	uint32_t (*get_count)(void);			/**< The counts left until the next interrupt. 0 if a one shot has passed. */
+	void (*stop)(void);						/**< Stop interrupting. */
+	struct clockevent * next;				/**< The next registered device. */
+} clockevent_t;
+
+/**
+ * \brief Register a clock event device. If it can run periodically and is rated higher than the
+ * current tick device, then the tick is moved onto it and the old device stopped.
+ * 
+ * \param [in] device The device to register.
+ */
+void clockevent_register(clockevent_t * device);
+
+/**
+ * \brief Get the device that drives the tick.
+ * 
+ * \return The tick device. NULL if none is registered.
+ */
+const clockevent_t * clockevent_get_device(void);
+
+/**
+ * \brief Get the number of ticks since the first device was registered.
+ * 
+ * \return The number of ticks.
+ */
+uint32_t clockevent_get_ticks(void);
+
+/**
+ * \brief Set whether the periodic tick is stopped while the CPU is idle.
+ * 
+ * \param [in] enable Whether to stop the tick while idle.
+ */
+void clockevent_set_tickless(bool enable);
+
+/**
+ * \brief Get whether the periodic tick is stopped while the CPU is idle.
+ * 
+ * \return Whether the tick is stopped while idle.
+ */
+bool clockevent_get_tickless(void);
+
+/**
+ * \brief Called by the idle thread, with interrupts disabled, before halting. Stops the periodic
+ * tick and puts the tick device into one shot mode to interrupt when the next thread is due to
+ * wake, up to the most the device can count. Does nothing if tickless is disabled or the wake is
+ * within a tick.
+ * 
+ * \param [in] ticks The number of ticks until the next thread is due to wake.
+ */
+void clockevent_idle_enter(uint32_t ticks);
+
+/**
+ * \brief Called at the start of every IRQ. If the tick device is in one shot mode, then adds the
+ * time passed onto the tick count and starts the periodic tick again.
+ */
+void clockevent_idle_exit(void);
+
+#endif /* INCLUDE_CLOCKEVENT_H */
@@ -76,4 +76,21 @@ uint8_t cmos_read(uint8_t reg);
  */
 void cmos_write(uint8_t reg, uint8_t val);
 
+/**
+ * \brief Read, change and write back a register in the CMOS chip in one go, so nothing else can
+ * change the register in between.
+ * 
+ * \param [in] reg The register to change.
+ * \param [in] mask The bits to clear.
+ * \param [in] bits The bits to set after clearing \p mask.
+ * 
+ * \return The value of the register from before.
+ */
+uint8_t cmos_modify(uint8_t reg, uint8_t mask, uint8_t bits);
+
+/**
+ * \brief Set up the lock for the CMOS registers.
+ */
+void cmos_init(void);
+
 #endif /* INCLUDED_CMOS_H */
@@ -0,0 +1,117 @@
+/**
+ * \file cpu.h
+ * \brief Inline assembly for CPU instructions that don't have a C equivalent.
+ */
+#ifndef INCLUDE_CPU_H
+#define INCLUDE_CPU_H
+
+#include <stdint.h>
+
+/**
+ * \brief Read the time stamp counter, the number of CPU cycles since reset.
+ * 
+ * \return The time stamp counter.
+ */
+static inline uint64_t cpu_rdtsc(void) {
+	uint32_t low;
+	uint32_t high;
+	__asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high));
+	return ((uint64_t) high << 32) | low;
+}
+
+/**
+ * \brief Run the CPUID instruction. The CPU must support CPUID.
+ * 
+ * \param [in] leaf The CPUID leaf to read.
+ * \param [out] regs The EAX, EBX, ECX and EDX values, in that order.
+ */
+static inline void cpu_cpuid(uint32_t leaf, uint32_t regs[4]) {
+	__asm__ __volatile__ ("cpuid" : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3]) : "a" (leaf), "c" (0));
+}
+
+/**
+ * \brief Read a model specific register. The CPU must support MSRs.
+ * 
+ * \param [in] msr The register to read.
+ * 
+ * \return The value of the register.
+ */
+static inline uint64_t cpu_rdmsr(uint32_t msr) {
+	uint32_t low;
+	uint32_t high;
+	__asm__ __volatile__ ("rdmsr" : "=a" (low), "=d" (high) : "c" (msr));
+	return ((uint64_t) high << 32) | low;
+}
+
+/**
+ * \brief Write a model specific register. The CPU must support MSRs.
+ * 
+ * \param [in] msr The register to write.
+ * \param [in] value The new value of the register.
+ */
+static inline void cpu_wrmsr(uint32_t msr, uint64_t value) {
+	__asm__ __volatile__ ("wrmsr" : : "c" (msr), "a" ((uint32_t) value), "d" ((uint32_t) (value >> 32)) : "memory");
+}
+
+/**
+ * \brief Find the index of the lowest set bit.
+ * 
+ * \param [in] value The value to search. Must not be zero, as the result is undefined.
+ * 
+ * \return The index of the lowest set bit.
+ */
+static inline uint32_t cpu_bsf(uint32_t value) {
+	uint32_t index;
+	__asm__ ("bsf %0, %1" : "=r" (index) : "rm" (value));
+	return index;
+}
+
+/**
+ * \brief Divide a 64 bit value by a 32 bit value with one instruction, as there is no library for
+ * 64 bit division.
+ * 
+ * \param [in] dividend The value to divide.
+ * \param [in] divisor The value to divide by. Must not be zero.
+ * 
+ * \return The quotient. UINT32_MAX if it doesn't fit in 32 bits.
+ */
+static inline uint32_t cpu_div64_32(uint64_t dividend, uint32_t divisor) {
+	uint32_t high = (uint32_t) (dividend >> 32);
+	if(high >= divisor) {
+		return UINT32_MAX;
+	}
+	
+	uint32_t quotient;
+	uint32_t remainder;
+	__asm__ ("div %2" : "=a" (quotient), "=d" (remainder) : "rm" (divisor), "a" ((uint32_t) dividend), "d" (high));
+	(void) remainder;
+	return quotient;
+}
+
+/**
+ * \brief Divide a 64 bit value by a 32 bit value for the whole 64 bit quotient, with two divide
+ * instructions.
+ * 
+ * \param [in] dividend The value to divide.
+ * \param [in] divisor The value to divide by. Must not be zero.
+ * 
+ * \return The quotient.
+ */
+static inline uint64_t cpu_div64(uint64_t dividend, uint32_t divisor) {
+	uint32_t high = (uint32_t) (dividend >> 32);
+	uint32_t high_quotient = high / divisor;
+	
+	// The remainder of the high half is less than the divisor, so the low quotient fits
+	uint64_t rest = ((uint64_t) (high % divisor) << 32) | (uint32_t) dividend;
+	return ((uint64_t) high_quotient << 32) | cpu_div64_32(rest, divisor);
+}
+
+/**
+ * \brief Tell the CPU this is a spin wait loop, which saves power and lets the other hyper-thread
+ * run.
+ */
+static inline void cpu_pause(void) {
+	__asm__ __volatile__ ("pause" : : : "memory");
+}
+
+#endif /* INCLUDE_CPU_H */
@@ -0,0 +1,102 @@
+/**
+ * \file cpu_features.h
+ * \brief Functions and definitions for finding what the CPU supports. The CPUID leaves are read
+ * once at boot and cached, so checking a feature is only a bit test.
+ * 
+ * A feature is the cached leaf, the register and the bit packed together with \ref CPU_FEATURE, so
+ * any CPUID bit can be checked with \ref cpu_has without a function for each.
+ */
+#ifndef INCLUDE_CPU_FEATURES_H
+#define INCLUDE_CPU_FEATURES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The cached CPUID leaves.
+ */
+enum cpu_leaf {
+	CPU_LEAF_BASIC		= 0,	/**< Leaf 1, the basic features. */
+	CPU_LEAF_EXTENDED	= 1,	/**< Leaf 7 sub-leaf 0, the structured extended features. */
+	CPU_LEAF_AMD		= 2,	/**< Leaf 0x80000001, the extended processor features. */
+	CPU_LEAF_POWER		= 3,	/**< Leaf 0x80000007, the advanced power management features. */
+	CPU_LEAVES			= 4		/**< The number of cached leaves. */
+};
+
+/**
+ * \brief The CPUID output registers.
+ */
+enum cpu_reg {
+	CPU_EAX = 0,	/**< The EAX register. */
+	CPU_EBX = 1,	/**< The EBX register. */
+	CPU_ECX = 2,	/**< The ECX register. */
+	CPU_EDX = 3		/**< The EDX register. */
+};
+
+/**
+ * \brief Pack the cached leaf, register and bit of a feature.
+ */
+#define CPU_FEATURE(leaf, reg, bit)		(((leaf) << 8) | ((reg) << 5) | (bit))
+
+#define CPU_FEATURE_FPU				CPU_FEATURE(CPU_LEAF_BASIC, CPU_EDX, 0)		/**< x87 FPU. */
+#define CPU_FEATURE_TSC				CPU_FEATURE(CPU_LEAF_BASIC, CPU_EDX, 4)		/**< Time stamp counter. */
+#define CPU_FEATURE_MSR				CPU_FEATURE(CPU_LEAF_BASIC, CPU_EDX, 5)		/**< RDMSR and WRMSR. */
+#define CPU_FEATURE_APIC			CPU_FEATURE(CPU_LEAF_BASIC, CPU_EDX, 9)		/**< Local APIC. */
+#define CPU_FEATURE_SEP				CPU_FEATURE(CPU_LEAF_BASIC, CPU_EDX, 11)	/**< SYSENTER and SYSEXIT. */
+#define CPU_FEATURE_PGE				CPU_FEATURE(CPU_LEAF_BASIC, CPU_EDX, 13)	/**< Global pages. */
+#define CPU_FEATURE_FXSR			CPU_FEATURE(CPU_LEAF_BASIC, CPU_EDX, 24)	/**< FXSAVE and FXRSTOR. */
+#define CPU_FEATURE_SSE				CPU_FEATURE(CPU_LEAF_BASIC, CPU_EDX, 25)	/**< SSE. */
+#define CPU_FEATURE_SSE2			CPU_FEATURE(CPU_LEAF_BASIC, CPU_EDX, 26)	/**< SSE2. */
+#define CPU_FEATURE_HTT				CPU_FEATURE(CPU_LEAF_BASIC, CPU_EDX, 28)	/**< Multiple logical CPUs per package. */
+#define CPU_FEATURE_SSE3			CPU_FEATURE(CPU_LEAF_BASIC, CPU_ECX, 0)		/**< SSE3. */
+#define CPU_FEATURE_SSSE3			CPU_FEATURE(CPU_LEAF_BASIC, CPU_ECX, 9)		/**< Supplemental SSE3. */
+#define CPU_FEATURE_SSE4_1			CPU_FEATURE(CPU_LEAF_BASIC, CPU_ECX, 19)	/**< SSE4.1. */
+#define CPU_FEATURE_SSE4_2			CPU_FEATURE(CPU_LEAF_BASIC, CPU_ECX, 20)	/**< SSE4.2. */
+#define CPU_FEATURE_X2APIC			CPU_FEATURE(CPU_LEAF_BASIC, CPU_ECX, 21)	/**< x2APIC. */
+#define CPU_FEATURE_POPCNT			CPU_FEATURE(CPU_LEAF_BASIC, CPU_ECX, 23)	/**< POPCNT. */
+#define CPU_FEATURE_TSC_DEADLINE	CPU_FEATURE(CPU_LEAF_BASIC, CPU_ECX, 24)	/**< Local APIC timer TSC deadline mode. */
+#define CPU_FEATURE_XSAVE			CPU_FEATURE(CPU_LEAF_BASIC, CPU_ECX, 26)	/**< XSAVE. */
+#define CPU_FEATURE_AVX				CPU_FEATURE(CPU_LEAF_BASIC, CPU_ECX, 28)	/**< AVX. */
+#define CPU_FEATURE_HYPERVISOR		CPU_FEATURE(CPU_LEAF_BASIC, CPU_ECX, 31)	/**< Running under a hypervisor. */
+#define CPU_FEATURE_BMI1			CPU_FEATURE(CPU_LEAF_EXTENDED, CPU_EBX, 3)	/**< Bit manipulation instructions 1. */
+#define CPU_FEATURE_AVX2			CPU_FEATURE(CPU_LEAF_EXTENDED, CPU_EBX, 5)	/**< AVX2. */
+#define CPU_FEATURE_SMEP			CPU_FEATURE(CPU_LEAF_EXTENDED, CPU_EBX, 7)	/**< Supervisor mode execution prevention. */
+#define CPU_FEATURE_ERMS			CPU_FEATURE(CPU_LEAF_EXTENDED, CPU_EBX, 9)	/**< Enhanced REP MOVSB and STOSB. */
+#define CPU_FEATURE_NX				CPU_FEATURE(CPU_LEAF_AMD, CPU_EDX, 20)		/**< No execute pages. */
+#define CPU_FEATURE_INVARIANT_TSC	CPU_FEATURE(CPU_LEAF_POWER, CPU_EDX, 8)		/**< The TSC runs at a constant rate in all power states. */
+
+/**
+ * \brief Read and cache the CPUID leaves of the boot CPU. Must be called before anything checks a
+ * feature. If the CPU has no CPUID, then it has no features.
+ */
+void cpu_features_init(void);
+
+/**
+ * \brief Check whether the CPU has a feature.
+ * 
+ * \param [in] feature The feature, one of the CPU_FEATURE_ defines.
+ * 
+ * \return Whether the CPU has the feature.
+ */
+bool cpu_has(uint32_t feature);
+
+/**
+ * \brief Get the vendor ID string, such as "GenuineIntel".
+ * 
+ * \return The vendor. Empty if the CPU has no CPUID.
+ */
+const char * cpu_get_vendor(void);
+
+/**
+ * \brief Get the brand string of the CPU.
+ * 
+ * \return The brand. Empty if the CPU doesn't have one.
+ */
+const char * cpu_get_brand(void);
+
+/**
+ * \brief Print the vendor, family, model and the features the CPU has.
+ */
+void cpu_features_dump(void);
+
+#endif /* INCLUDE_CPU_FEATURES_H */
@@ -0,0 +1,34 @@
+/**
+ * \file delay.h
+ * \brief Functions for busy waiting for short times, for hardware that needs a delay shorter than
+ * a tick. The TSC is spun on once it has been timed by \ref clock_init, else counter 2 of the PIT
+ * is polled, which has a resolution of about a microsecond from the port I/O.
+ * 
+ * These spin, so other threads don't run while waiting. Waits of milliseconds should sleep with
+ * \ref sleep_ms instead.
+ */
+#ifndef INCLUDE_DELAY_H
+#define INCLUDE_DELAY_H
+
+#include <stdint.h>
+
+/**
+ * \brief The largest count counter 2 of the PIT is loaded with in one go.
+ */
+#define DELAY_PIT_MAX_COUNT			0xFFFF
+
+/**
+ * \brief Wait for at least a number of microseconds.
+ * 
+ * \param [in] microseconds The number of microseconds.
+ */
+void udelay(uint32_t microseconds);
+
+/**
+ * \brief Wait for at least a number of nanoseconds.
+ * 
+ * \param [in] nanoseconds The number of nanoseconds.
+ */
+void ndelay(uint32_t nanoseconds);
+
+#endif /* INCLUDE_DELAY_H */
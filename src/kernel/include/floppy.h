@@ -14,6 +14,17 @@
  */
 #define FLOPPY_DMA_BUFFER					0x1000
 
+/**
+ * \brief The number of milliseconds the drive motor is left on after the last access, so reads
+ * close together don't each wait for the motor to spin up.
+ */
+#define FLOPPY_MOTOR_OFF_DELAY				2000
+
+/**
+ * \brief The number of microseconds the controller is held in reset by the digital output register.
+ */
+#define FLOPPY_RESET_DELAY					4
+
 /**
  * \brief The list of floppy drive controller 0 registers to control floppy drive 0.
  */
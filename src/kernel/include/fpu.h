@@ -0,0 +1,110 @@
+/**
+ * \file fpu.h
+ * \brief Functions and definitions for the FPU and SSE registers. The FPU state is switched lazily:
+ * switching to a thread that doesn't own the FPU sets CR0.TS, and the first FPU or SSE instruction
+ * the thread runs raises the device not available exception (\#NM). Only then is the owner's state
+ * saved and the thread's state loaded. So threads that never use the FPU never pay for saving it.
+ * 
+ * The kernel is not compiled to use the FPU, so kernel code can only use it between
+ * \ref kernel_fpu_begin and \ref kernel_fpu_end.
+ */
+#ifndef INCLUDE_FPU_H
+#define INCLUDE_FPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The size in bytes of the saved FPU and SSE state of a thread, as saved by FXSAVE.
+ */
+#define FPU_STATE_SIZE		512
+
+/**
+ * \brief The CR0 bit for the FPU being monitored, so WAIT also raises \#NM when TS is set.
+ */
+#define FPU_CR0_MP			0x00000002
+
+/**
+ * \brief The CR0 bit for there being no FPU, so every FPU instruction raises \#NM.
+ */
+#define FPU_CR0_EM			0x00000004
+
+/**
+ * \brief The CR0 bit set on a task switch, so the next FPU instruction raises \#NM.
+ */
+#define FPU_CR0_TS			0x00000008
+
+/**
+ * \brief The CR0 bit for reporting FPU errors with exception 16 instead of the PIC.
+ */
+#define FPU_CR0_NE			0x00000020
+
+/**
+ * \brief The CR4 bit for the OS supporting FXSAVE and FXRSTOR, which enables the SSE instructions.
+ */
+#define FPU_CR4_OSFXSR		0x00000200
+
+/**
+ * \brief The CR4 bit for the OS handling the SIMD floating point exception.
+ */
+#define FPU_CR4_OSXMMEXCPT	0x00000400
+
+struct thread;
+
+/**
+ * \brief Check what the CPU supports from \ref cpu_has, turn on the FPU and SSE, and install the \#NM handler. Must be
+ * called before the threads are started.
+ */
+void fpu_init(void);
+
+/**
+ * \brief Turn on the FPU and SSE on the calling CPU. Called by each application processor as it
+ * starts, as CR0 and CR4 are per CPU.
+ */
+void fpu_init_cpu(void);
+
+/**
+ * \brief Whether the CPU has a FPU that is in use.
+ * 
+ * \return Whether there is a FPU.
+ */
+bool fpu_present(void);
+
+/**
+ * \brief Whether the SSE and SSE2 instructions can be used between \ref kernel_fpu_begin and
+ * \ref kernel_fpu_end.
+ * 
+ * \return Whether SSE2 can be used.
+ */
+bool fpu_has_sse2(void);
+
+/**
+ * \brief Set CR0.TS when switching to a thread that doesn't own the FPU, so its first FPU
+ * instruction loads its state. Called by the scheduler with interrupts disabled.
+ * 
+ * \param [in] next The thread being switched to.
+ */
+void fpu_switch(struct thread * next);
+
+/**
+ * \brief Forget a thread that is exiting, so its state isn't saved once the thread is reused.
+ * 
+ * \param [in] thread The thread exiting.
+ */
+void fpu_thread_exit(struct thread * thread);
+
+/**
+ * \brief Start using the FPU and SSE registers in the kernel. In a kernel thread the registers are
+ * the thread's own and it can still be preempted. In a system call, an IRQ handler, deferred work or
+ * on an application processor, the owner's registers are saved and interrupts stay disabled until
+ * \ref kernel_fpu_end. A process's registers go back to ring 3, so are never used by the kernel.
+ * Can be nested.
+ */
+void kernel_fpu_begin(void);
+
+/**
+ * \brief Stop using the FPU and SSE registers in the kernel.
+ */
+void kernel_fpu_end(void);
+
+#endif /* INCLUDE_FPU_H */
@@ -9,10 +9,15 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+/**
+ * \brief The number of per-CPU data segment GDT entries, one for each CPU.
+ */
+#define GDT_PER_CPU_ENTRIES	0x08
+
 /**
  * \brief The total number of GDT entries.
  */
-#define GDT_ENTRIES			0x06
+#define GDT_ENTRIES			(0x06 + GDT_PER_CPU_ENTRIES)
 
 /**
  * \brief The total size of the GDT table in bytes.
@@ -38,7 +43,8 @@ enum gdt_segment_indexes {
 	GDT_KERNEL_DATA_INDEX   = 0x02,	/**< The index of the kernel data GDT entry. */
 	GDT_USER_CODE_INDEX		= 0x03,	/**< The index of the user code GDT entry. */
 	GDT_USER_DATA_INDEX		= 0x04,	/**< The index of the user data GDT entry. */
-	GDT_TSS_INDEX 			= 0x05	/**< The index of the task state segment GDT entry. */
+	GDT_TSS_INDEX 			= 0x05,	/**< The index of the task state segment GDT entry. */
+	GDT_PER_CPU_INDEX		= 0x06	/**< The index of the first per-CPU data GDT entry. */
 };
 
 /**
@@ -50,7 +56,8 @@ enum gdt_segment_offsets {
 	GDT_KERNEL_DATA_OFFSET	= 0x10, /**< The offset of the kernel data GDT entry. */
 	GDT_USER_CODE_OFFSET	= 0x18, /**< The offset of the user code GDT entry. */
 	GDT_USER_DATA_OFFSET	= 0x20, /**< The offset of the user data GDT entry. */
-	GDT_TSS_OFFSET			= 0x28 /**< The offset of the TTS GDT entry. */
+	GDT_TSS_OFFSET			= 0x28, /**< The offset of the TTS GDT entry. */
+	GDT_PER_CPU_OFFSET		= 0x30 /**< The offset of the first per-CPU data GDT entry. */
 };
 
 /**
@@ -145,8 +152,36 @@ typedef struct {
 
 /**
  * \brief Set up the GDT table with 6 entries. The NULL, kernel code, kernel data, user code, user
- * data, and TSS entries.
+ * data, and TSS entries. The per-CPU entries are left not present until \ref gdt_set_per_cpu.
  */
 void gdt_init(void);
 
+/**
+ * \brief Create the kernel data segment for a CPU's per-CPU data, so the data can be addressed
+ * from offset 0 of the segment.
+ * 
+ * \param [in] cpu The CPU ID, less than \ref GDT_PER_CPU_ENTRIES.
+ * \param [in] base The address of the per-CPU data.
+ * \param [in] size The size of the per-CPU data in bytes.
+ * 
+ * \return The segment selector to load into a segment register.
+ */
+uint16_t gdt_set_per_cpu(uint32_t cpu, uint32_t base, uint32_t size);
+
+/**
+ * \brief Set the stack the CPU switches to when ring 3 enters the kernel, the ESP0 of the TSS.
+ * Called when switching to a thread of a user process.
+ * 
+ * \param [in] esp The top of the kernel stack.
+ */
+void gdt_set_kernel_stack(uint32_t esp);
+
+/**
+ * \brief Get the address of the ESP0 field of the TSS, so SYSENTER can load the kernel stack from
+ * it.
+ * 
+ * \return The address of the kernel stack pointer in the TSS.
+ */
+uint32_t gdt_get_kernel_stack_address(void);
+
 #endif /* INCLUDE_GDT_H */
@@ -0,0 +1,115 @@
+/**
+ * \file hpet.h
+ * \brief Functions and definitions for the high precision event timer (HPET), found from the ACPI
+ * HPET table. Its main counter counts up at a fixed rate of at least 10MHz, so is a clock source
+ * that doesn't depend on the CPU frequency. A comparator that can be routed to the I/O APIC input of
+ * IRQ 0 is a clock event device, so raises the same IRQ as the other tick devices.
+ * 
+ * The legacy replacement mode isn't used, as it takes IRQ 8 from the RTC.
+ */
+#ifndef INCLUDE_HPET_H
+#define INCLUDE_HPET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The general capabilities register. Bits 32-63 are the period of the main counter in
+ * femtoseconds.
+ */
+#define HPET_REG_CAPABILITIES		0x000
+
+/**
+ * \brief The general configuration register.
+ */
+#define HPET_REG_CONFIG				0x010
+
+/**
+ * \brief The main counter.
+ */
+#define HPET_REG_COUNTER			0x0F0
+
+/**
+ * \brief The configuration and capabilities register of a comparator.
+ */
+#define HPET_REG_TIMER_CONFIG(n)	(0x100 + 0x20 * (n))
+
+/**
+ * \brief The comparator value register of a comparator.
+ */
+#define HPET_REG_TIMER_COMPARATOR(n)	(0x108 + 0x20 * (n))
+
+/**
+ * \brief The capabilities bit for a 64 bit main counter.
+ */
+#define HPET_CAP_COUNT_64			0x2000
+
+/**
+ * \brief Get the number of comparators from the capabilities.
+ */
+#define HPET_CAP_TIMERS(cap)		((((cap) >> 8) & 0x1F) + 1)
+
+/**
+ * \brief The longest period of the main counter allowed, 100ns.
+ */
+#define HPET_MAX_PERIOD_FS			100000000
+
+/**
+ * \brief The configuration bit that starts the main counter and lets the comparators interrupt.
+ */
+#define HPET_CONFIG_ENABLE			0x01
+
+/**
+ * \brief The configuration bit that routes comparators 0 and 1 to IRQ 0 and IRQ 8.
+ */
+#define HPET_CONFIG_LEGACY			0x02
+
+/**
+ * \brief The comparator configuration bit that lets it interrupt.
+ */
+#define HPET_TIMER_ENABLE			0x004
+
+/**
+ * \brief The comparator configuration bit for periodic mode.
+ */
+#define HPET_TIMER_PERIODIC			0x008
+
+/**
+ * \brief The comparator capabilities bit for whether it can run periodically.
+ */
+#define HPET_TIMER_PERIODIC_CAP		0x010
+
+/**
+ * \brief The comparator configuration bit that lets the next write to the comparator set the
+ * period, in periodic mode.
+ */
+#define HPET_TIMER_VALUE_SET		0x040
+
+/**
+ * \brief The comparator configuration bit that compares only the low 32 bits, so the comparator is
+ * written in one access.
+ */
+#define HPET_TIMER_32_MODE			0x100
+
+/**
+ * \brief The shift of the I/O APIC input in the comparator configuration.
+ */
+#define HPET_TIMER_ROUTE_SHIFT		9
+
+/**
+ * \brief Find the HPET from the ACPI tables, start the main counter and register it as a clock
+ * source. If it has a comparator that can raise IRQ 0, then that is registered as a clock event
+ * device. Must be called after \ref acpi_init, and \ref irq_enable_ioapic for the clock event.
+ * 
+ * \return Whether there is an HPET.
+ */
+bool hpet_init(void);
+
+/**
+ * \brief Read the main counter.
+ * 
+ * \return The count. 0 if there is no HPET.
+ */
+uint64_t hpet_read_counter(void);
+
+#endif /* INCLUDE_HPET_H */
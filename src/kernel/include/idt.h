@@ -71,6 +71,15 @@ typedef struct {
  */
 void idt_open_interrupt_gate(uint8_t index, uint32_t base);
 
+/**
+ * \brief Open a interrupt gate that ring 3 can call with the INT instruction, such as for system
+ * calls.
+ * 
+ * \param [in] index The index into the IDT for which the interrupt handler is to be loaded.
+ * \param [in] base The base address for the handler to be loaded at index.
+ */
+void idt_open_user_gate(uint8_t index, uint32_t base);
+
 /**
  * \brief Close a interrupt gate for a particular entry.
  * 
@@ -78,6 +87,12 @@ void idt_open_interrupt_gate(uint8_t index, uint32_t base);
  */
 void idt_close_interrupt_gate(uint8_t index);
 
+/**
+ * \brief Load the IDT into the CPU calling this, for the other CPUs to use the same IDT as the boot
+ * CPU.
+ */
+void idt_load_cpu(void);
+
 /**
  * \brief Initialise the IDT by first creating \ref IDT_ENTRIES blank entries and loading the
  * location and size of the IDT into the CPU.
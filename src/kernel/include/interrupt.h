@@ -1,14 +1,26 @@
 /**
  * \file interrupt.h
- * \brief Inline assembly for enabling and disabling interrupts.
+ * \brief Inline assembly for enabling and disabling interrupts. With IRQ_TRACE, the time between
+ * disabling and enabling them again is recorded by \ref irqstat_irqs_off and
+ * \ref irqstat_irqs_on.
  */
 #ifndef INCLUDE_INTERRUPT_H
 #define INCLUDE_INTERRUPT_H
 
+#include <irqstat.h>
+
+#include <stdint.h>
+
+/**
+ * \brief The interrupt enable flag in the EFLAGS register.
+ */
+#define INTERRUPT_FLAG		0x200
+
 /**
  * \brief Enable interrupts.
  */
 static inline void interrupt_enable(void) {
+	irqstat_irqs_on();
 	__asm__ __volatile__ ("sti");
 }
 
@@ -17,6 +29,36 @@ static inline void interrupt_enable(void) {
  */
 static inline void interrupt_disable(void) {
 	__asm__ __volatile__ ("cli");
+	irqstat_irqs_off();
+}
+
+/**
+ * \brief Disable interrupts and return the EFLAGS from before, so the interrupt state can be put
+ * back with \ref interrupt_restore. Unlike \ref interrupt_disable, these can be nested.
+ * 
+ * \return The EFLAGS register before interrupts were disabled.
+ */
+static inline uint32_t interrupt_save(void) {
+	uint32_t flags;
+	__asm__ __volatile__ ("pushfd\n\tpop %0\n\tcli" : "=r" (flags) : : "memory");
+	
+	// Only the outermost save starts a section
+	if(flags & INTERRUPT_FLAG) {
+		irqstat_irqs_off();
+	}
+	return flags;
+}
+
+/**
+ * \brief Enable interrupts if they were enabled when \ref interrupt_save was called.
+ * 
+ * \param [in] flags The EFLAGS returned from \ref interrupt_save.
+ */
+static inline void interrupt_restore(uint32_t flags) {
+	if(flags & INTERRUPT_FLAG) {
+		irqstat_irqs_on();
+		__asm__ __volatile__ ("sti" : : : "memory");
+	}
 }
 
 #endif /* INCLUDE_INTERRUPT_H */
@@ -0,0 +1,113 @@
+/**
+ * \file ioapic.h
+ * \brief Functions and definitions for the I/O APIC, which routes the ISA IRQs to the local APIC
+ * of the boot CPU instead of the PIC. An IRQ is acknowledged with one write to the local APIC, and
+ * each IRQ's redirection entry is kept so masking is one register write with no read.
+ * 
+ * The local APIC takes the priority of an interrupt from the top 4 bits of its vector, so the IRQs
+ * are given vectors by how soon they need handling.
+ */
+#ifndef INCLUDE_IOAPIC_H
+#define INCLUDE_IOAPIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The offset of the register select register.
+ */
+#define IOAPIC_REG_SELECT			0x00
+
+/**
+ * \brief The offset of the window to the selected register.
+ */
+#define IOAPIC_REG_WINDOW			0x10
+
+/**
+ * \brief The version register. Bits 16-23 are the number of redirection entries minus 1.
+ */
+#define IOAPIC_VERSION				0x01
+
+/**
+ * \brief The low half of the first redirection entry. Each entry is two registers.
+ */
+#define IOAPIC_REDIRECTION			0x10
+
+/**
+ * \brief The redirection entry bit for an active low input.
+ */
+#define IOAPIC_ACTIVE_LOW			0x2000
+
+/**
+ * \brief The redirection entry bit for a level triggered input.
+ */
+#define IOAPIC_LEVEL				0x8000
+
+/**
+ * \brief The redirection entry bit that masks off the input.
+ */
+#define IOAPIC_MASKED				0x10000
+
+/**
+ * \brief The priority class of the timer, the highest of the IRQs.
+ */
+#define IOAPIC_PRIORITY_TIMER		0x6
+
+/**
+ * \brief The priority class of the keyboard and the RTC.
+ */
+#define IOAPIC_PRIORITY_INPUT		0x5
+
+/**
+ * \brief The priority class of the other devices.
+ */
+#define IOAPIC_PRIORITY_DEVICE		0x4
+
+/**
+ * \brief Map the I/O APICs from the MADT and route each ISA IRQ to the boot CPU, masked off. Must
+ * be called after \ref smp_init, which maps the local APIC.
+ * 
+ * \return Whether there is an I/O APIC to use.
+ */
+bool ioapic_init(void);
+
+/**
+ * \brief Get the vector an ISA IRQ is delivered on.
+ * 
+ * \param [in] irq The ISA IRQ.
+ * 
+ * \return The vector.
+ */
+uint8_t ioapic_get_vector(uint8_t irq);
+
+/**
+ * \brief Mask off an ISA IRQ.
+ * 
+ * \param [in] irq The ISA IRQ.
+ */
+void ioapic_set_mask(uint8_t irq);
+
+/**
+ * \brief Unmask an ISA IRQ.
+ * 
+ * \param [in] irq The ISA IRQ.
+ */
+void ioapic_clear_mask(uint8_t irq);
+
+/**
+ * \brief Get whether an ISA IRQ is level triggered, which it is if the MADT overrides it to be.
+ * 
+ * \param [in] irq The ISA IRQ.
+ * 
+ * \return Whether the IRQ is level triggered.
+ */
+bool ioapic_is_level(uint8_t irq);
+
+/**
+ * \brief Acknowledge an IRQ, which is a write to the local APIC.
+ * 
+ * \param [in] irq The ISA IRQ, unused as the local APIC acknowledges the highest in service.
+ */
+void ioapic_send_end_of_interrupt(uint8_t irq);
+
+#endif /* INCLUDE_IOAPIC_H */
@@ -7,19 +7,70 @@
 
 #include <regs_t.h>
 
+#include <stdint.h>
+#include <stdbool.h>
+
 /**
  * \brief The total number of IRQ's that can be handled.
  */
 #define IRQ_TOTAL	16
 
+/**
+ * \brief The vector of the entry used to time the entry and exit of an IRQ. Is above the PIC
+ * vectors and below the I/O APIC vectors.
+ */
+#define IRQ_BENCH_VECTOR	0x30
+
+/**
+ * \brief The number of times \ref irq_bench raises \ref IRQ_BENCH_VECTOR.
+ */
+#define IRQ_BENCH_ROUNDS	1000
+
+/**
+ * \brief The number of IRQs \ref irq_round_trip times.
+ */
+#define IRQ_ROUND_TRIP_ROUNDS		100
+
+/**
+ * \brief The longest \ref irq_round_trip waits for the IRQs, in milliseconds.
+ */
+#define IRQ_ROUND_TRIP_TIMEOUT_MS	1000
+
+/**
+ * \brief The number of passes of the loop \ref irq_round_trip times with interrupts disabled, to
+ * find the shortest pass.
+ */
+#define IRQ_ROUND_TRIP_CALIBRATE	1000
+
+/**
+ * \brief How many times the shortest pass a pass of the loop in \ref irq_round_trip must take to
+ * have had an interrupt in it.
+ */
+#define IRQ_ROUND_TRIP_GAP			8
+
 /**
  * \typedef typedef void (*irq_handler)(regs_t * regs)
  * \brief The type of a IRQ handler.
  * 
- * \param [in] regs The registers that were present when the handler was called.
+ * \param [in] regs The registers that were present when the handler was called. NULL if the IRQ
+ * fired while disabled, is edge triggered and is replayed by \ref irq_clear_mask.
  */
 typedef void (*irq_handler)(regs_t * regs);
 
+/**
+ * \struct irq_chip_t
+ * 
+ * \brief The operations of an interrupt controller, so the IRQs can come from the PIC or the
+ * I/O APIC.
+ */
+typedef struct {
+	const char * name;					/**< The name of the interrupt controller. */
+	void (*eoi)(uint8_t irq);			/**< Acknowledge an IRQ. */
+	void (*mask)(uint8_t irq);			/**< Mask off an IRQ. */
+	void (*unmask)(uint8_t irq);		/**< Unmask an IRQ. */
+	bool (*is_level)(uint8_t irq);		/**< Whether an IRQ is level triggered. */
+} irq_chip_t;
+
 /**
  * \brief Install a new IRQ handler for a given IRQ number.
  * 
@@ -37,16 +88,75 @@ void irq_install_handler(int irq_num, irq_handler handler);
 void irq_uninstall_handler(int irq_num);
 
 /**
- * \brief Mask off a interrupt to disable the interrupt by supplying the IRQ number.
+ * \brief Get the number of times an IRQ has been raised.
+ * \param [in] irq_num The IRQ number.
+ * \return The number of times the IRQ was raised since boot.
+ */
+uint32_t irq_get_count(uint8_t irq_num);
+
+/**
+ * \brief Get the average number of cycles the handler of an IRQ takes.
+ * \param [in] irq_num The IRQ number.
+ * \return The average number of cycles. 0 if the IRQ was never raised.
+ */
+uint32_t irq_get_handler_cycles(uint8_t irq_num);
+
+/**
+ * \brief Get the average number of cycles acknowledging an IRQ takes.
+ * \param [in] irq_num The IRQ number.
+ * \return The average number of cycles. 0 if the IRQ was never raised.
+ */
+uint32_t irq_get_eoi_cycles(uint8_t irq_num);
+
+/**
+ * \brief Time the entry and exit of an IRQ that interrupted ring 0, by raising an interrupt at
+ * \ref IRQ_BENCH_VECTOR that has the same entry as the IRQs and a handler that does nothing.
+ * \return The average number of cycles of \ref IRQ_BENCH_ROUNDS interrupts.
+ */
+uint32_t irq_bench(void);
+
+/**
+ * \brief Time the whole round trip of a real IRQ, from the interrupted code's view: delivery, the
+ * entry, the handler, the acknowledgement and the exit. Spins reading the TSC with interrupts
+ * enabled, and a pass of the loop that the IRQ was taken in is a round trip. A pass that another
+ * thread ran in isn't counted. Must be called from a thread, with the IRQ unmasked.
+ * 
+ * \param [in] irq_num The IRQ number.
+ * 
+ * \return The average number of cycles of \ref IRQ_ROUND_TRIP_ROUNDS IRQs. 0 if there is no TSC or
+ * the IRQ wasn't raised within \ref IRQ_ROUND_TRIP_TIMEOUT_MS.
+ */
+uint32_t irq_round_trip(uint8_t irq_num);
+
+/**
+ * \brief Get the name of the interrupt controller the IRQs come from.
+ * \return The name of the interrupt controller.
+ */
+const char * irq_get_chip_name(void);
+
+/**
+ * \brief Get whether the IRQs come from the I/O APIC, so are acknowledged through the local APIC.
+ * \return Whether the I/O APIC is used.
+ */
+bool irq_has_ioapic(void);
+
+/**
+ * \brief Disable an interrupt by supplying the IRQ number. Is lazy, so only a flag is set. The IRQ
+ * is only masked off on the interrupt controller if it fires while disabled, and is then replayed
+ * by \ref irq_clear_mask if it is edge triggered.
  * 
- * \param [in] irq_num The IRQ number to be masked off.
+ * \param [in] irq_num The IRQ number to be disabled.
  */
 void irq_set_mask(uint8_t irq_num);
 
 /**
- * \brief Unmask a interrupt to enable the interrupt by supplying the IRQ number.
+ * \brief Enable an interrupt by supplying the IRQ number. If it fired while disabled, then it is
+ * unmasked on the interrupt controller. An edge triggered IRQ then has its handler run before
+ * returning, a level triggered one fires again on its own as the line is still raised. Any work the
+ * handler defers and any thread switch are left to the next IRQ exit, so can be called with
+ * interrupts disabled or a lock held.
  * 
- * \param [in] irq_num The IRQ number to unmask.
+ * \param [in] irq_num The IRQ number to enable.
  */
 void irq_clear_mask(uint8_t irq_num);
 
@@ -55,4 +165,11 @@ void irq_clear_mask(uint8_t irq_num);
  */
 void irq_init(void);
 
+/**
+ * \brief Route the IRQs through the I/O APIC and disable the PIC, keeping the IRQs that were
+ * unmasked. Each IRQ is given a vector by its priority, see \ref ioapic_get_vector. Stays on the PIC
+ * if there is no I/O APIC. Must be called after \ref smp_init.
+ */
+void irq_enable_ioapic(void);
+
 #endif /* INCLUDE_IRQ_H */
@@ -0,0 +1,102 @@
+/**
+ * \file irqstat.h
+ * \brief Functions, definitions and structures for the interrupt latency statistics. The entry of
+ * each exception and IRQ reads the TSC, and so does the C handler as it starts and ends. So each
+ * vector has a histogram of its latency, the cycles from the entry to the handler starting, and its
+ * duration, the cycles the handler runs for.
+ * 
+ * Timing the sections of code with interrupts disabled hooks every \ref interrupt_save and
+ * \ref interrupt_restore, so is only built in when the kernel is compiled with IRQ_TRACE defined
+ * (make IRQ_TRACE=1), else the hooks are empty. The longest section of each CPU is kept with where
+ * it started and ended.
+ */
+#ifndef INCLUDE_IRQSTAT_H
+#define INCLUDE_IRQSTAT_H
+
+#include <stdint.h>
+
+/**
+ * \brief The number of vectors with statistics, the exceptions then the IRQs numbered as on the
+ * PIC.
+ */
+#define IRQSTAT_VECTORS			48
+
+/**
+ * \brief The number of buckets in each histogram. Each bucket is double the cycles of the one
+ * before, and the last has everything longer.
+ */
+#define IRQSTAT_BUCKETS			16
+
+/**
+ * \brief The first bucket has everything under 2 to the power of this number of cycles.
+ */
+#define IRQSTAT_FIRST_SHIFT		8
+
+/**
+ * \struct irqstat_histogram_t
+ * 
+ * \brief A histogram of a number of cycles.
+ */
+typedef struct {
+	uint32_t buckets[IRQSTAT_BUCKETS];	/**< The number of times in each range of cycles. */
+	uint32_t max;						/**< The most cycles recorded. */
+} irqstat_histogram_t;
+
+/**
+ * \brief Record an exception or IRQ once its handler has finished.
+ * 
+ * \param [in] vector The vector, less than \ref IRQSTAT_VECTORS.
+ * \param [in] entry The TSC at the entry.
+ * \param [in] start The TSC as the handler started.
+ * \param [in] end The TSC as the handler ended.
+ */
+void irqstat_record(uint32_t vector, uint64_t entry, uint64_t start, uint64_t end);
+
+/**
+ * \brief Print the histograms of each vector that has been raised, and the longest section with
+ * interrupts disabled on each CPU.
+ */
+void irqstat_dump(void);
+
+#ifdef IRQ_TRACE
+
+/**
+ * \brief Start timing the sections with interrupts disabled. Must be called after the boot CPU's
+ * \ref percpu_init, as the times are per-CPU.
+ */
+void irqstat_init(void);
+
+/**
+ * \brief Called as interrupts are disabled. Starts timing the section.
+ */
+void irqstat_irqs_off(void);
+
+/**
+ * \brief Called before interrupts are enabled again. Ends the section, recording it if it is the
+ * longest.
+ */
+void irqstat_irqs_on(void);
+
+/**
+ * \brief Called at the start of every IRQ. The interrupted code had interrupts enabled, so any
+ * section left open, such as one ended by a sti before a hlt, is dropped.
+ */
+void irqstat_irq_entry(void);
+
+#else
+
+static inline void irqstat_init(void) {
+}
+
+static inline void irqstat_irqs_off(void) {
+}
+
+static inline void irqstat_irqs_on(void) {
+}
+
+static inline void irqstat_irq_entry(void) {
+}
+
+#endif /* IRQ_TRACE */
+
+#endif /* INCLUDE_IRQSTAT_H */
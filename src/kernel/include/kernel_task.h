@@ -1,6 +1,55 @@
+/**
+ * \file kernel_task.h
+ * \brief The kernel task that runs the terminal.
+ */
 #ifndef INCLUDE_KERNEL_TASK_H
 #define INCLUDE_KERNEL_TASK_H
 
+/**
+ * \brief The number of physical blocks the per command arena starts with. Everything a command
+ * allocates is freed in one go when the command finishes.
+ */
+#define KERNEL_TASK_ARENA_BLOCKS	1
+
+/**
+ * \brief The number of physical blocks the command history arena grows by.
+ */
+#define KERNEL_TASK_HISTORY_BLOCKS	1
+
+/**
+ * \brief The number of commands kept in the history. Once reached, the oldest half is dropped.
+ */
+#define KERNEL_TASK_HISTORY_MAX		128
+
+/**
+ * \brief The starting size of the command buffer in bytes. It doubles when full.
+ */
+#define KERNEL_TASK_COMMAND_SIZE	64
+
+/**
+ * \brief The number of sleeps the scheduler benchmark measures the wake up to run time of, for each
+ * priority.
+ */
+#define KERNEL_TASK_SCHED_BENCH_SLEEPS	100
+
+/**
+ * \brief The number of milliseconds the idle test sleeps for with and without the tickless idle.
+ */
+#define KERNEL_TASK_IDLE_TEST_MS	60000
+
+/**
+ * \brief The number of physical blocks the parallel memory fill benchmark fills.
+ */
+#define KERNEL_TASK_SMP_BENCH_BLOCKS	256
+
+/**
+ * \brief The number of times the parallel memory fill benchmark fills the buffer.
+ */
+#define KERNEL_TASK_SMP_BENCH_ROUNDS	32
+
+/**
+ * \brief The kernel task that runs the terminal. Reads commands from the keyboard and runs them.
+ */
 void kernel_task(void);
 
-#endif /* INCLUDE_KERNEL_TASK_H */
\ No newline at end of file
+#endif /* INCLUDE_KERNEL_TASK_H */
@@ -5,6 +5,8 @@
 #ifndef INCLUDE_KEYBOARD_H
 #define INCLUDE_KEYBOARD_H
 
+#include <async.h>
+
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -663,12 +665,21 @@ char key_to_ascii(unsigned char key);
 unsigned char get_last_key_press(void);
 
 /**
- * \brief Waits for a key to be pressed. Waits until the key isn't \ref KEYBOARD_KEY_UNKNOWN.
+ * \brief Waits for a key to be pressed. Waits until the key isn't \ref KEYBOARD_KEY_UNKNOWN. The
+ * thread is blocked until the keyboard IRQ, so other threads can run.
  * 
  * \return The last key press that isn't \ref KEYBOARD_KEY_UNKNOWN.
  */
 unsigned char wait_for_key_press(void);
 
+/**
+ * \brief Get the event signalled on each key press, so a coroutine can wait for a key with
+ * \ref ASYNC_WAIT_UNTIL and \ref get_last_key_press.
+ * 
+ * \return The key press event.
+ */
+async_event_t * keyboard_get_event(void);
+
 /**
  * \brief Initiate the keyboard driver to accept key presses and handle them.
  */
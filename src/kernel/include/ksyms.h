@@ -0,0 +1,32 @@
+/**
+ * \file ksyms.h
+ * \brief Functions and structures for looking up the kernel symbols. The symbol table is generated
+ * from the map file of a first link of the kernel (ld -M) and linked into the final kernel.
+ */
+#ifndef INCLUDE_KSYMS_H
+#define INCLUDE_KSYMS_H
+
+#include <stdint.h>
+
+/**
+ * \struct ksym_t
+ * 
+ * \brief A single symbol in the code section of the kernel.
+ */
+typedef struct {
+	uint32_t addr;			/**< The address of the symbol. */
+	const char * name;		/**< The name of the symbol. */
+} ksym_t;
+
+/**
+ * \brief Find the symbol that contains \p addr. Only global symbols are in the kernel map, so a
+ * static function will be shown as the global symbol before it plus an offset.
+ * 
+ * \param [in] addr The address to look up.
+ * \param [out] offset The offset of \p addr from the start of the symbol. Can be NULL.
+ * 
+ * \return The symbol name. If no symbol contains \p addr, then returns NULL.
+ */
+const char * ksym_lookup(uint32_t addr, uint32_t * offset);
+
+#endif /* INCLUDE_KSYMS_H */
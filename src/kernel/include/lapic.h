@@ -0,0 +1,200 @@
+/**
+ * \file lapic.h
+ * \brief Functions and definitions for the local APIC of each CPU. Is used to send interrupts
+ * between the CPUs (IPIs), including the INIT and startup IPIs that start the other CPUs.
+ */
+#ifndef INCLUDE_LAPIC_H
+#define INCLUDE_LAPIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The register with the local APIC ID in the top byte.
+ */
+#define LAPIC_REG_ID				0x020
+
+/**
+ * \brief The task priority register. Interrupts of a lower priority class are held back.
+ */
+#define LAPIC_REG_TASK_PRIORITY		0x080
+
+/**
+ * \brief The end of interrupt register.
+ */
+#define LAPIC_REG_EOI				0x0B0
+
+/**
+ * \brief The spurious interrupt vector register, which also software enables the local APIC.
+ */
+#define LAPIC_REG_SPURIOUS			0x0F0
+
+/**
+ * \brief The local vector table entry of the timer, with its vector, mode and mask bit.
+ */
+#define LAPIC_REG_LVT_TIMER			0x320
+
+/**
+ * \brief The count the timer starts counting down from. Writing this starts the timer.
+ */
+#define LAPIC_REG_TIMER_INITIAL		0x380
+
+/**
+ * \brief The count the timer is at.
+ */
+#define LAPIC_REG_TIMER_CURRENT		0x390
+
+/**
+ * \brief The divider of the bus clock the timer counts at.
+ */
+#define LAPIC_REG_TIMER_DIVIDE		0x3E0
+
+/**
+ * \brief The low half of the interrupt command register. Writing this sends the IPI.
+ */
+#define LAPIC_REG_ICR_LOW			0x300
+
+/**
+ * \brief The high half of the interrupt command register, with the destination APIC ID in the top
+ * byte.
+ */
+#define LAPIC_REG_ICR_HIGH			0x310
+
+/**
+ * \brief The bit in the spurious interrupt vector register that enables the local APIC.
+ */
+#define LAPIC_SPURIOUS_ENABLE		0x100
+
+/**
+ * \brief The interrupt vector for spurious interrupts. Its low 4 bits must be set on older CPUs.
+ */
+#define LAPIC_SPURIOUS_VECTOR		0xFF
+
+/**
+ * \brief The interrupt vector for IPIs that wake another CPU.
+ */
+#define LAPIC_IPI_VECTOR			0xF0
+
+/**
+ * \brief The ICR delivery mode for a normal interrupt with a vector.
+ */
+#define LAPIC_ICR_FIXED				0x000
+
+/**
+ * \brief The ICR delivery mode for an INIT IPI, which resets the CPU to wait for a startup IPI.
+ */
+#define LAPIC_ICR_INIT				0x500
+
+/**
+ * \brief The ICR delivery mode for a startup IPI. The vector is the page the CPU starts at in real
+ * mode.
+ */
+#define LAPIC_ICR_STARTUP			0x600
+
+/**
+ * \brief The ICR bit that is set while the IPI is being sent.
+ */
+#define LAPIC_ICR_PENDING			0x1000
+
+/**
+ * \brief The ICR level bit, set for all IPIs except the INIT de-assert.
+ */
+#define LAPIC_ICR_ASSERT			0x4000
+
+/**
+ * \brief The ICR trigger mode bit for level triggered, used for the INIT de-assert.
+ */
+#define LAPIC_ICR_LEVEL				0x8000
+
+/**
+ * \brief The local vector table bit that masks off the interrupt.
+ */
+#define LAPIC_LVT_MASKED			0x10000
+
+/**
+ * \brief The timer mode that reloads the initial count each time it reaches 0. The one shot mode
+ * is 0.
+ */
+#define LAPIC_TIMER_PERIODIC		0x20000
+
+/**
+ * \brief The timer mode that interrupts once the TSC reaches the value in
+ * \ref LAPIC_MSR_TSC_DEADLINE.
+ */
+#define LAPIC_TIMER_TSC_DEADLINE	0x40000
+
+/**
+ * \brief The timer divide value to count at the bus clock.
+ */
+#define LAPIC_TIMER_DIVIDE_1		0x0B
+
+/**
+ * \brief The MSR with the TSC value the timer interrupts at in the TSC-deadline mode. Writing 0
+ * disarms it.
+ */
+#define LAPIC_MSR_TSC_DEADLINE		0x6E0
+
+/**
+ * \brief The number of ticks the timer is counted over to find its frequency.
+ */
+#define LAPIC_TIMER_CALIBRATE_TICKS	10
+
+/**
+ * \brief Map the local APIC registers and install the interrupt handlers for its vectors. Doesn't
+ * enable the local APIC, see \ref lapic_enable.
+ * 
+ * \param [in] address The physical address of the local APIC from the MADT.
+ */
+void lapic_init(uint32_t address);
+
+/**
+ * \brief Enable the local APIC of the CPU calling this so it can send and receive IPIs.
+ */
+void lapic_enable(void);
+
+/**
+ * \brief Get the local APIC ID of the CPU calling this.
+ * 
+ * \return The local APIC ID.
+ */
+uint8_t lapic_get_id(void);
+
+/**
+ * \brief Acknowledge an interrupt from the local APIC.
+ */
+void lapic_send_eoi(void);
+
+/**
+ * \brief Send an interrupt to another CPU.
+ * 
+ * \param [in] apic_id The local APIC ID of the CPU.
+ * \param [in] vector The interrupt vector.
+ */
+void lapic_send_ipi(uint8_t apic_id, uint8_t vector);
+
+/**
+ * \brief Send the INIT IPI to a CPU, which resets it to wait for a startup IPI.
+ * 
+ * \param [in] apic_id The local APIC ID of the CPU.
+ */
+void lapic_send_init(uint8_t apic_id);
+
+/**
+ * \brief Send a startup IPI to a CPU.
+ * 
+ * \param [in] apic_id The local APIC ID of the CPU.
+ * \param [in] page The 4KB page below 1MB the CPU starts running in real mode at.
+ */
+void lapic_send_startup(uint8_t apic_id, uint8_t page);
+
+/**
+ * \brief Find the frequency of the timer of the boot CPU by counting over ticks of the PIT, and
+ * register it as a clock event device, which takes over the tick. Raises the vector of IRQ 0 so
+ * needs the IRQs to be on the I/O APIC, see \ref irq_enable_ioapic. The one shot uses the
+ * TSC-deadline mode if the CPU has it.
+ * 
+ * \return Whether the timer is used.
+ */
+bool lapic_timer_init(void);
+
+#endif /* INCLUDE_LAPIC_H */
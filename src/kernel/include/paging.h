@@ -184,6 +184,55 @@ void vmm_flush_tlb_entry(uint32_t virtual_addr);
 
 void vmm_map_page(void * physical_addr, void * virtual_addr);
 
+void vmm_map_range(uint32_t physical_addr, uint32_t length);
+
+void vmm_map_device(uint32_t physical_addr);
+
+/**
+ * \brief Get the kernel's page directory, which kernel threads run in.
+ * 
+ * \return The kernel's page directory.
+ */
+page_directory_t * vmm_get_kernel_directory(void);
+
+/**
+ * \brief Create a page directory for a user process. The kernel's page tables are shared but not
+ * user accessible, and the rest is left for \ref vmm_map_user_page.
+ * 
+ * \return The new page directory. NULL if out of memory.
+ */
+page_directory_t * vmm_create_address_space(void);
+
+/**
+ * \brief Map a page into a user process so ring 3 can read and write it.
+ * 
+ * \param [in] p_directory The page directory of the process.
+ * \param [in] physical_addr The physical page, owned by the address space from now on.
+ * \param [in] virtual_addr The user address. Must not be in a page table of the kernel.
+ * 
+ * \return Whether the page was mapped. False if out of memory or the address is the kernel's.
+ */
+bool vmm_map_user_page(page_directory_t * p_directory, void * physical_addr, void * virtual_addr);
+
+/**
+ * \brief Check that every page of a range is mapped in a page directory so ring 3 can access it.
+ * 
+ * \param [in] p_directory The page directory of the process.
+ * \param [in] addr The start of the range.
+ * \param [in] size The size of the range in bytes.
+ * 
+ * \return Whether all of the range is present and user accessible. True if the size is 0.
+ */
+bool vmm_is_user_range(page_directory_t * p_directory, uint32_t addr, uint32_t size);
+
+/**
+ * \brief Free a page directory from \ref vmm_create_address_space, its user page tables and the
+ * pages mapped in them. Switches back to the kernel's page directory if it was in use.
+ * 
+ * \param [in] p_directory The page directory to free.
+ */
+void vmm_destroy_address_space(page_directory_t * p_directory);
+
 void paging_init(void);
 
 #endif /* INCLUDE_PAGING_H */
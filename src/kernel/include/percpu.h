@@ -0,0 +1,132 @@
+/**
+ * \file percpu.h
+ * \brief Functions, definitions and structures for the per-CPU data. Each CPU has its own
+ * \ref percpu_t, addressed through its own GDT data segment loaded into GS. So a CPU can read and
+ * update its own counters with a single instruction, without a lock and without the cache line
+ * bouncing between the CPUs.
+ * 
+ * The fields are read and written with \ref this_cpu_read and \ref this_cpu_write, which only
+ * work on 32 bit fields. \ref this_cpu_inc and \ref this_cpu_dec are a single instruction, so can't
+ * be torn by an IRQ handler updating the same field.
+ */
+#ifndef INCLUDE_PERCPU_H
+#define INCLUDE_PERCPU_H
+
+#include <gdt.h>
+#include <irq.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \brief The maximum number of CPUs with per-CPU data, one for each per-CPU GDT entry.
+ */
+#define PERCPU_MAX_CPUS		GDT_PER_CPU_ENTRIES
+
+/**
+ * \brief The alignment of each CPU's data, so no two CPUs share a cache line.
+ */
+#define PERCPU_ALIGN		64
+
+/**
+ * \struct percpu_t
+ * 
+ * \brief The data each CPU has its own copy of.
+ */
+typedef struct percpu {
+	struct percpu * self;				/**< The address of this data, for \ref this_cpu_ptr. */
+	uint32_t cpu_id;					/**< The CPU ID, 0 is the boot CPU. */
+	uint32_t irq_depth;					/**< The number of IRQs being handled on this CPU. */
+	uint32_t irq_counts[IRQ_TOTAL];		/**< The number of times each IRQ was raised on this CPU. */
+	struct thread * fpu_owner;			/**< The thread whose registers are in the FPU. NULL if none. */
+	uint32_t fpu_depth;					/**< The nesting of kernel_fpu_begin() outside of a thread. */
+	uint32_t fpu_flags;					/**< The EFLAGS from the outer kernel_fpu_begin() outside of a thread. */
+	uint32_t fpu_loads;					/**< The number of times a thread's FPU registers were loaded. */
+} __attribute__((aligned(PERCPU_ALIGN))) percpu_t;
+
+/**
+ * \brief Read a 32 bit value from the current CPU's data.
+ * 
+ * \param [in] offset The offset of the value in \ref percpu_t.
+ * 
+ * \return The value.
+ */
+static inline uint32_t percpu_read(uint32_t offset) {
+	uint32_t value;
+	__asm__ __volatile__ ("mov %0, dword ptr gs:[%1]" : "=r" (value) : "ri" (offset));
+	return value;
+}
+
+/**
+ * \brief Write a 32 bit value to the current CPU's data.
+ * 
+ * \param [in] offset The offset of the value in \ref percpu_t.
+ * \param [in] value The value to write.
+ */
+static inline void percpu_write(uint32_t offset, uint32_t value) {
+	__asm__ __volatile__ ("mov dword ptr gs:[%0], %1" : : "ri" (offset), "ri" (value) : "memory");
+}
+
+/**
+ * \brief Increment a 32 bit value in the current CPU's data with a single instruction.
+ * 
+ * \param [in] offset The offset of the value in \ref percpu_t.
+ */
+static inline void percpu_inc(uint32_t offset) {
+	__asm__ __volatile__ ("inc dword ptr gs:[%0]" : : "ri" (offset) : "memory");
+}
+
+/**
+ * \brief Decrement a 32 bit value in the current CPU's data with a single instruction.
+ * 
+ * \param [in] offset The offset of the value in \ref percpu_t.
+ */
+static inline void percpu_dec(uint32_t offset) {
+	__asm__ __volatile__ ("dec dword ptr gs:[%0]" : : "ri" (offset) : "memory");
+}
+
+/**
+ * \brief Read a 32 bit field of the current CPU's \ref percpu_t.
+ */
+#define this_cpu_read(field)			percpu_read(offsetof(percpu_t, field))
+
+/**
+ * \brief Write a 32 bit field of the current CPU's \ref percpu_t.
+ */
+#define this_cpu_write(field, value)	percpu_write(offsetof(percpu_t, field), (uint32_t) (value))
+
+/**
+ * \brief Increment a 32 bit field of the current CPU's \ref percpu_t.
+ */
+#define this_cpu_inc(field)				percpu_inc(offsetof(percpu_t, field))
+
+/**
+ * \brief Decrement a 32 bit field of the current CPU's \ref percpu_t.
+ */
+#define this_cpu_dec(field)				percpu_dec(offsetof(percpu_t, field))
+
+/**
+ * \brief Get the address of the current CPU's \ref percpu_t, for passing to functions that don't
+ * know about GS.
+ */
+#define this_cpu_ptr()					((percpu_t *) this_cpu_read(self))
+
+/**
+ * \brief Set up the per-CPU data for the calling CPU and load its segment into GS. Each CPU calls
+ * this as it starts, before any IRQ can be taken.
+ * 
+ * \param [in] cpu The CPU ID, less than \ref PERCPU_MAX_CPUS.
+ */
+void percpu_init(uint32_t cpu);
+
+/**
+ * \brief Get the per-CPU data of any CPU, for adding up the counters of all the CPUs.
+ * 
+ * \param [in] cpu The CPU ID.
+ * 
+ * \return The per-CPU data. NULL if the ID is too big. The data of a CPU that hasn't started is all
+ * zero.
+ */
+percpu_t * percpu_get(uint32_t cpu);
+
+#endif /* INCLUDE_PERCPU_H */
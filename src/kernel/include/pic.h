@@ -9,6 +9,7 @@
 #define INCLUDE_PIC_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <portio.h>
 
 /**
@@ -179,8 +180,47 @@ uint8_t pic_receive_data_slave(void);
 void pic_send_end_of_interrupt(uint8_t irq);
 
 /**
- * \brief Remap all the PIC IRQ's so that they don't conflict with the processors interrupts.
+ * \brief Remap all the PIC IRQ's so that they don't conflict with the processors interrupts. Keeps
+ * the masks the PIC's had, and reads them into the shadow that the masks are kept in from then on.
  */
 void pic_remap_irq(void);
 
+/**
+ * \brief Mask off an IRQ in the PIC's interrupt mask register. Only writes the register, the value
+ * is from the shadow.
+ * 
+ * \param [in] irq The IRQ number to mask off.
+ */
+void pic_set_mask(uint8_t irq);
+
+/**
+ * \brief Unmask an IRQ in the PIC's interrupt mask register. Only writes the register, the value is
+ * from the shadow.
+ * 
+ * \param [in] irq The IRQ number to unmask.
+ */
+void pic_clear_mask(uint8_t irq);
+
+/**
+ * \brief Get the interrupt mask registers of both PIC's, from the shadow so no port is read.
+ * 
+ * \return The mask, bit n set if IRQ n is masked off.
+ */
+uint16_t pic_get_mask(void);
+
+/**
+ * \brief Get whether an IRQ is level triggered. The PIC's are initialised in edge triggered mode,
+ * so none are.
+ * 
+ * \param [in] irq The IRQ number.
+ * 
+ * \return Whether the IRQ is level triggered, always false.
+ */
+bool pic_is_level(uint8_t irq);
+
+/**
+ * \brief Mask off every IRQ, for when the I/O APIC delivers the IRQ's instead.
+ */
+void pic_disable(void);
+
 #endif /* INCLUDE_PIC_H */
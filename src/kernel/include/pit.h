@@ -6,6 +6,33 @@
 #define INCLUDE_PIT_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The frequency of the clock input to the PIT counters in Hz.
+ */
+#define PIT_INPUT_FREQUENCY		1193180
+
+/**
+ * \brief The port with the gate of counter 2 in bit 0 and its output in bit 5. Bit 1 connects
+ * the output to the speaker.
+ */
+#define PIT_REG_COUNTER_2_GATE	0x61
+
+/**
+ * \brief The bit of \ref PIT_REG_COUNTER_2_GATE that lets counter 2 count.
+ */
+#define PIT_COUNTER_2_GATE		0x01
+
+/**
+ * \brief The bit of \ref PIT_REG_COUNTER_2_GATE that connects counter 2 to the speaker.
+ */
+#define PIT_COUNTER_2_SPEAKER	0x02
+
+/**
+ * \brief The bit of \ref PIT_REG_COUNTER_2_GATE with the output of counter 2.
+ */
+#define PIT_COUNTER_2_OUTPUT	0x20
 
 /**
  * \brief The port addresses of the PIT registers.
@@ -101,28 +128,31 @@ enum pit_ocw_counters {
 void pit_setup_counter(uint16_t freq, uint8_t counter, uint8_t mode);
 
 /**
- * \brief A simple wait that used the PIT to wait a number of ticks.
+ * \brief A simple wait that used the PIT to wait a number of ticks. The current thread sleeps, so
+ * other threads can run.
  * 
  * \param [in] milliseconds The number of ticks to wait.
  */
 void pit_wait(uint32_t milliseconds);
 
 /**
- * \brief Get the number of ticks that have passed when the PIT was initiated.
+ * \brief Start counter 2 counting down once, with the speaker off. Its output goes high when it
+ * reaches 0, see \ref pit_counter_2_done. Is polled, so needs no IRQ and can be used to time
+ * things with interrupts disabled.
  * 
- * \return Number of ticks passed.
+ * \param [in] count The number of input clocks to count.
  */
-uint32_t pit_get_ticks(void);
+void pit_counter_2_start(uint16_t count);
 
 /**
- * \brief Get the divisor used by the PIT when initiated.
+ * \brief Get whether counter 2 has counted down since \ref pit_counter_2_start.
  * 
- * \return The divisor.
+ * \return Whether the count has reached 0.
  */
-uint16_t pit_get_frequency(void);
+bool pit_counter_2_done(void);
 
 /**
- * \brief Initialise the PIT with a handler to a IRQ.
+ * \brief Initialise the PIT, registering counter 0 as a clock event device to drive the tick.
  */
 void pit_init(void);
 
@@ -0,0 +1,112 @@
+/**
+ * \file process.h
+ * \brief Functions, definitions and structures for user processes. A process is a kernel thread
+ * that runs in ring 3 with its own page directory. The kernel's page tables are in every page
+ * directory but only ring 0 can access them, so a system call doesn't switch page directory.
+ * 
+ * The user part of the address space is one page table: the code is copied to the bottom and the
+ * stack grows down from the top. User threads only run on the boot CPU, as there is one TSS.
+ */
+#ifndef INCLUDE_PROCESS_H
+#define INCLUDE_PROCESS_H
+
+#include <thread.h>
+#include <paging.h>
+#include <wait.h>
+#include <regs_t.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdnoreturn.h>
+
+/**
+ * \brief The lowest user address, where the code is copied to. Must not share a page table with
+ * the kernel.
+ */
+#define PROCESS_USER_BASE		0x80000000
+
+/**
+ * \brief The end of the user addresses, the top of the user stack.
+ */
+#define PROCESS_USER_END		0x80400000
+
+/**
+ * \brief The number of pages of the user stack.
+ */
+#define PROCESS_STACK_BLOCKS	4
+
+/**
+ * \brief The exit code of a process that was ended by a CPU exception.
+ */
+#define PROCESS_EXIT_FAULT		0xFFFFFFFF
+
+/**
+ * \struct process_t
+ * 
+ * \brief A user process.
+ */
+typedef struct process {
+	page_directory_t * directory;	/**< The page directory of the process. */
+	thread_t * thread;				/**< The thread running the process. */
+	uint32_t arg;					/**< The value in EAX when the process starts. */
+	uint32_t exit_code;				/**< The exit code, once \ref exited is complete. */
+	completion_t exited;			/**< Completed when the process exits. */
+} process_t;
+
+/**
+ * \brief Create a process that runs position independent code in ring 3.
+ * 
+ * \param [out] process The process to set up. Must stay valid until \ref process_wait returns.
+ * \param [in] name The name of the thread running the process.
+ * \param [in] code The code to copy to \ref PROCESS_USER_BASE, which is where it starts.
+ * \param [in] size The size of the code in bytes.
+ * \param [in] arg The value in EAX when the process starts.
+ * 
+ * \return Whether the process was created. False if out of memory or threads.
+ */
+bool process_create(process_t * process, const char * name, const void * code, uint32_t size, uint32_t arg);
+
+/**
+ * \brief Wait for a process to exit and free its address space.
+ * 
+ * \param [in] process The process to wait for.
+ * 
+ * \return The exit code of the process.
+ */
+uint32_t process_wait(process_t * process);
+
+/**
+ * \brief End the process of the current thread.
+ * 
+ * \param [in] code The exit code given to \ref process_wait.
+ */
+noreturn void process_exit(uint32_t code);
+
+/**
+ * \brief End the process of the current thread after a CPU exception in ring 3.
+ * 
+ * \param [in] regs The registers of the process when the exception happened.
+ * \param [in] msg The name of the exception.
+ */
+noreturn void process_fault(regs_t * regs, const char * msg);
+
+/**
+ * \brief Switch to the page directory and kernel stack of a thread. Called by the scheduler with
+ * interrupts disabled.
+ * 
+ * \param [in] next The thread being switched to.
+ */
+void process_switch(thread_t * next);
+
+/**
+ * \brief Check that a buffer given by a system call is all in the user addresses, and mapped in
+ * the calling process so the kernel can access it without faulting.
+ * 
+ * \param [in] addr The start of the buffer.
+ * \param [in] size The size of the buffer in bytes.
+ * 
+ * \return Whether ring 3 can access all of the buffer.
+ */
+bool process_is_user_range(uint32_t addr, uint32_t size);
+
+#endif /* INCLUDE_PROCESS_H */
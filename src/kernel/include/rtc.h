@@ -14,6 +14,28 @@
  */
 #define CURRENT_CENTURY		2000
 
+/**
+ * \brief The bit of the status B register that turns on the periodic interrupt.
+ */
+#define RTC_STATUS_B_PERIODIC		0x40
+
+/**
+ * \brief The bit of the status B register that turns on the interrupt after each update, once a
+ * second.
+ */
+#define RTC_STATUS_B_UPDATE_ENDED	0x10
+
+/**
+ * \brief The bit of the status C register that is set when the interrupt is for an update ending.
+ */
+#define RTC_STATUS_C_UPDATE_ENDED	0x10
+
+/**
+ * \brief The number of updates of the RTC, in seconds, between setting the wall clock from it
+ * again, so the wall clock doesn't drift from the RTC.
+ */
+#define RTC_RESYNC_SECONDS			3600
+
 /**
  * \struct rtc_date_time_t
  * 
@@ -69,7 +91,25 @@ void set_rate(uint8_t rate);
 rtc_date_time_t * read_rtc(rtc_date_time_t * date, bool hour_24h);
 
 /**
- * \brief Initialise the real time clock to update every half a second.
+ * \brief Get the difference of the local time from UTC, as the RTC is kept in UTC.
+ * 
+ * \return The number of seconds the local time is ahead of UTC.
+ */
+int32_t rtc_get_utc_offset(void);
+
+/**
+ * \brief Get the local date and time in 24hr format, from the wall clock plus the UTC offset. Is
+ * worked out from memory, so doesn't touch the CMOS.
+ * 
+ * \param [in] date The date and time structure which the values will be placed in.
+ * 
+ * \return The pointer to the date structure. NULL if \p date is NULL.
+ */
+rtc_date_time_t * rtc_get_date_time(rtc_date_time_t * date);
+
+/**
+ * \brief Initialise the real time clock to interrupt after each update, once a second, and keep
+ * the date and time in memory.
  */
 void rtc_init(void);
 
@@ -0,0 +1,99 @@
+/**
+ * \file smp.h
+ * \brief Functions, definitions and structures for starting and using the other CPUs. The CPUs are
+ * found from the ACPI MADT and started with the INIT and startup IPIs. Each has its own stack and
+ * \ref cpu_t, and sits in its own idle loop until given a function to run with \ref smp_call.
+ * 
+ * Threads are still only scheduled on the boot CPU.
+ */
+#ifndef INCLUDE_SMP_H
+#define INCLUDE_SMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The maximum number of CPUs used.
+ */
+#define SMP_MAX_CPUS			8
+
+/**
+ * \brief The number of physical blocks for the stack of each application processor.
+ */
+#define SMP_STACK_BLOCKS		2
+
+/**
+ * \brief The number of milliseconds to wait for an application processor to start.
+ */
+#define SMP_START_TIMEOUT		100
+
+/**
+ * \typedef typedef void (*smp_func_t)(uint32_t cpu, void * arg)
+ * \brief The type of a function run on the CPUs by \ref smp_call.
+ * \param [in] cpu The ID of the CPU running the function.
+ * \param [in] arg The argument given to \ref smp_call.
+ */
+typedef void (*smp_func_t)(uint32_t cpu, void * arg);
+
+/**
+ * \struct cpu_t
+ * 
+ * \brief The data for each CPU.
+ */
+typedef struct cpu {
+	uint32_t id;						/**< The CPU ID, 0 is the boot CPU. The online CPUs are numbered in order. */
+	uint8_t apic_id;					/**< The local APIC ID. */
+	volatile bool online;				/**< Whether the CPU has started and is in its idle loop. */
+	void * stack;						/**< The bottom of the stack. NULL for the boot CPU. */
+	volatile smp_func_t func;			/**< The function to run, set by \ref smp_call. */
+	void * volatile arg;				/**< The argument to \ref func. */
+	volatile bool done;					/**< Whether \ref func has finished. */
+	uint32_t calls;						/**< The number of functions run. */
+	uint32_t wakeups;					/**< The number of times the idle loop was woken. */
+} cpu_t;
+
+/**
+ * \brief Find the CPUs in the MADT and start them. If there is no MADT, then only the boot CPU is
+ * used.
+ */
+void smp_init(void);
+
+/**
+ * \brief Get the number of CPUs that are online, including the boot CPU.
+ * 
+ * \return The number of CPUs.
+ */
+uint32_t smp_get_cpu_count(void);
+
+/**
+ * \brief Get the data of a CPU.
+ * 
+ * \param [in] id The CPU ID.
+ * 
+ * \return The CPU. NULL if the CPU isn't online.
+ */
+cpu_t * smp_get_cpu(uint32_t id);
+
+/**
+ * \brief Get the ID of the CPU calling this.
+ * 
+ * \return The CPU ID.
+ */
+uint32_t smp_get_cpu_id(void);
+
+/**
+ * \brief Run a function on the first \p num_cpus CPUs at the same time, including the calling CPU
+ * as CPU 0, and wait for them all to finish. Must be called from a thread on the boot CPU.
+ * 
+ * \param [in] num_cpus The number of CPUs to run on. Is capped to the number online.
+ * \param [in] func The function to run.
+ * \param [in] arg The argument passed to \p func.
+ */
+void smp_call(uint32_t num_cpus, smp_func_t func, void * arg);
+
+/**
+ * \brief Print the CPUs with their local APIC ID and how often they were used.
+ */
+void smp_dump(void);
+
+#endif /* INCLUDE_SMP_H */
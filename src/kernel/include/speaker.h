@@ -13,12 +13,14 @@
 #define SPEAKER_PORT_ADDRESS	0x61
 
 /**
- * \brief Play the happy birthday song.
+ * \brief Start playing the happy birthday song. Returns straight away, the notes are played by a
+ * coroutine. Stops any song already playing.
  */
 void speaker_happy_birthday(void);
 
 /**
- * \brief Play the star was song.
+ * \brief Start playing the star wars song. Returns straight away, the notes are played by a
+ * coroutine. Stops any song already playing.
  */
 void speaker_star_wars(void);
 
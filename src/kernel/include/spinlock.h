@@ -0,0 +1,91 @@
+/**
+ * \file spinlock.h
+ * \brief Functions, definitions and structures for spin locks. The locks are ticket locks, so are
+ * taken in the order they were asked for and no CPU can be starved by the others. Each lock counts
+ * the number of times it was taken, how many of those had to wait, and how long it was held for,
+ * so the hot locks can be found with \ref spin_lock_dump.
+ * 
+ * With only one CPU, the only other thing that can take a lock is an IRQ handler or another thread
+ * after a preemption. So a lock that is also taken by an IRQ handler must be taken with
+ * \ref spin_lock_irqsave, else the handler spins forever on the lock the interrupted code holds.
+ */
+#ifndef INCLUDE_SPINLOCK_H
+#define INCLUDE_SPINLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \struct spinlock_t
+ * 
+ * \brief A ticket spin lock with its contention statistics.
+ */
+typedef struct spinlock {
+	volatile uint16_t next_ticket;		/**< The ticket given to the next CPU to ask for the lock. */
+	volatile uint16_t owner;			/**< The ticket of the CPU that holds the lock. */
+	const char * name;					/**< The name of the lock for the statistics. */
+	uint32_t acquisitions;				/**< The number of times the lock was taken. */
+	uint32_t contentions;				/**< The number of times the lock was held by another when asked for. */
+	uint64_t hold_cycles;				/**< The total CPU cycles the lock was held for. */
+	uint64_t max_hold_cycles;			/**< The longest the lock was held for in CPU cycles. */
+	uint64_t acquired_tsc;				/**< The time stamp counter when the lock was last taken. */
+	struct spinlock * next;				/**< The next lock in the list for \ref spin_lock_dump. */
+} spinlock_t;
+
+/**
+ * \brief Set up an unlocked spin lock and add it to the list of locks for the statistics. A zeroed
+ * lock is already unlocked, so a static lock can be used before this is called.
+ * 
+ * \param [in] lock The lock to set up.
+ * \param [in] name The name of the lock. Must not be freed.
+ */
+void spin_lock_init(spinlock_t * lock, const char * name);
+
+/**
+ * \brief Take a lock, spinning until it is free.
+ * 
+ * \param [in] lock The lock to take.
+ */
+void spin_lock(spinlock_t * lock);
+
+/**
+ * \brief Take a lock if it is free.
+ * 
+ * \param [in] lock The lock to take.
+ * 
+ * \return Whether the lock was taken.
+ */
+bool spin_trylock(spinlock_t * lock);
+
+/**
+ * \brief Release a lock taken with \ref spin_lock or \ref spin_trylock.
+ * 
+ * \param [in] lock The lock to release.
+ */
+void spin_unlock(spinlock_t * lock);
+
+/**
+ * \brief Disable interrupts and take a lock. Can be nested, unlike \ref interrupt_disable, as the
+ * interrupt state from before is returned to be put back by \ref spin_unlock_irqrestore.
+ * 
+ * \param [in] lock The lock to take.
+ * 
+ * \return The EFLAGS register before interrupts were disabled.
+ */
+uint32_t spin_lock_irqsave(spinlock_t * lock);
+
+/**
+ * \brief Release a lock taken with \ref spin_lock_irqsave and enable interrupts if they were
+ * enabled before.
+ * 
+ * \param [in] lock The lock to release.
+ * \param [in] flags The EFLAGS returned from \ref spin_lock_irqsave.
+ */
+void spin_unlock_irqrestore(spinlock_t * lock, uint32_t flags);
+
+/**
+ * \brief Print the statistics of all the locks.
+ */
+void spin_lock_dump(void);
+
+#endif /* INCLUDE_SPINLOCK_H */
@@ -0,0 +1,88 @@
+/**
+ * \file syscall.h
+ * \brief Functions and definitions for the system calls of user processes. Ring 3 enters the
+ * kernel either with int 0x80, which works on every CPU, or with SYSENTER if the CPU has it, which
+ * skips the IDT and the privilege checks of an interrupt gate.
+ * 
+ * Both take the system call number in EAX and the arguments in EBX, ESI and EDI, and return the
+ * result in EAX. int 0x80 keeps every other register. SYSENTER doesn't save the user EIP and ESP, so
+ * the caller puts the address to return to in EDX and its stack pointer in ECX, like the
+ * SYSEXIT that returns.
+ */
+#ifndef INCLUDE_SYSCALL_H
+#define INCLUDE_SYSCALL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The interrupt vector of the int 0x80 system call gate.
+ */
+#define SYSCALL_VECTOR				0x80
+
+/**
+ * \brief The MSR of the code segment SYSENTER loads. SS is the next entry, and SYSEXIT uses the
+ * two after for ring 3.
+ */
+#define SYSCALL_MSR_SYSENTER_CS		0x174
+
+/**
+ * \brief The MSR of the stack pointer SYSENTER loads.
+ */
+#define SYSCALL_MSR_SYSENTER_ESP	0x175
+
+/**
+ * \brief The MSR of the instruction pointer SYSENTER jumps to.
+ */
+#define SYSCALL_MSR_SYSENTER_EIP	0x176
+
+/**
+ * \brief The value returned for a system call that doesn't exist or has bad arguments.
+ */
+#define SYSCALL_ERROR				0xFFFFFFFF
+
+/**
+ * \brief The system call numbers.
+ */
+enum syscall_number {
+	SYSCALL_NULL	= 0,	/**< Does nothing, for measuring the cost of entering the kernel. */
+	SYSCALL_EXIT	= 1,	/**< End the process. EBX is the exit code. */
+	SYSCALL_WRITE	= 2,	/**< Write to the terminal. EBX is the buffer and ESI its size. */
+	SYSCALLS		= 3		/**< The number of system calls. */
+};
+
+/**
+ * \typedef typedef uint32_t (*syscall_t)(uint32_t arg1, uint32_t arg2, uint32_t arg3)
+ * \brief The type of a system call.
+ * \param [in] arg1 EBX of the caller.
+ * \param [in] arg2 ESI of the caller.
+ * \param [in] arg3 EDI of the caller.
+ * \return The value for EAX.
+ */
+typedef uint32_t (*syscall_t)(uint32_t arg1, uint32_t arg2, uint32_t arg3);
+
+/**
+ * \brief Open the int 0x80 gate and set up the SYSENTER MSRs on the boot CPU, if it has them.
+ */
+void syscall_init(void);
+
+/**
+ * \brief Whether user processes can enter the kernel with SYSENTER.
+ * 
+ * \return Whether SYSENTER can be used.
+ */
+bool syscall_has_sysenter(void);
+
+/**
+ * \brief Run a system call. Called by both entry stubs with interrupts enabled.
+ * 
+ * \param [in] number The system call number.
+ * \param [in] arg1 The first argument.
+ * \param [in] arg2 The second argument.
+ * \param [in] arg3 The third argument.
+ * 
+ * \return The result. \ref SYSCALL_ERROR if there isn't a system call with the number.
+ */
+uint32_t syscall_dispatch(uint32_t number, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+
+#endif /* INCLUDE_SYSCALL_H */
@@ -0,0 +1,193 @@
+/**
+ * \file thread.h
+ * \brief Functions, definitions and structures for the kernel threads. Each thread has its own
+ * stack and is switched to by the scheduler, either when the running thread blocks or yields, or
+ * when its time slice runs out on the tick (preemption).
+ * 
+ * There is a run queue for each priority, and a bitmap of which run queues have threads in them.
+ * The next thread is found with a single bsf on the bitmap, so picking it takes the same time no
+ * matter how many threads there are. Threads of the same priority take turns.
+ */
+#ifndef INCLUDE_THREAD_H
+#define INCLUDE_THREAD_H
+
+#include <fpu.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdnoreturn.h>
+
+struct process;
+
+/**
+ * \brief The maximum number of threads, including the boot and idle threads.
+ */
+#define THREAD_MAX				16
+
+/**
+ * \brief The number of physical blocks for each thread stack.
+ */
+#define THREAD_STACK_BLOCKS		4
+
+/**
+ * \brief The number of ticks a thread can run for before it is preempted.
+ */
+#define THREAD_TIME_SLICE		10
+
+/**
+ * \brief The maximum length of a thread name including the null terminator.
+ */
+#define THREAD_NAME_SIZE		16
+
+/**
+ * \brief The number of priorities, one run queue each. 0 is the highest priority. Must fit in the
+ * 32 bit ready bitmap.
+ */
+#define THREAD_PRIORITIES		32
+
+/**
+ * \brief The priority for threads waiting on the user, such as the shell. These preempt the normal
+ * and background threads as soon as they are woken so typing stays responsive.
+ */
+#define THREAD_PRIORITY_INTERACTIVE	4
+
+/**
+ * \brief The default priority.
+ */
+#define THREAD_PRIORITY_NORMAL		16
+
+/**
+ * \brief The priority for work that can be done whenever the CPU is free, such as flushing caches
+ * or zeroing pages.
+ */
+#define THREAD_PRIORITY_BACKGROUND	28
+
+/**
+ * \brief The states a thread can be in.
+ */
+typedef enum {
+	THREAD_UNUSED,			/**< The thread slot is free. */
+	THREAD_READY,			/**< The thread is in the run queue waiting to run. */
+	THREAD_RUNNING,			/**< The thread is running on the CPU. */
+	THREAD_BLOCKED,			/**< The thread is waiting for \ref thread_unblock. */
+	THREAD_SLEEPING,		/**< The thread is waiting for its sleep timer to expire. */
+	THREAD_DEAD				/**< The thread has exited and its stack is yet to be freed. */
+} thread_state_t;
+
+/**
+ * \typedef typedef void (*thread_entry_t)(void * arg)
+ * \brief The type of the function a thread starts running.
+ * \param [in] arg The argument given to \ref thread_create.
+ */
+typedef void (*thread_entry_t)(void * arg);
+
+/**
+ * \struct thread_t
+ * 
+ * \brief A kernel thread.
+ */
+typedef struct thread {
+	uint32_t esp;					/**< The saved stack pointer when not running. Must be first as used by the context switch. */
+	uint32_t id;					/**< The thread ID. */
+	thread_state_t state;			/**< The state the thread is in. */
+	char name[THREAD_NAME_SIZE];	/**< The name of the thread. */
+	void * stack;					/**< The bottom of the stack. NULL for the boot thread as it uses the boot stack. */
+	thread_entry_t entry;			/**< The function the thread runs. */
+	void * arg;						/**< The argument to \ref entry. */
+	uint32_t time_slice;			/**< The number of ticks left before the thread is preempted. */
+	uint32_t run_ticks;				/**< The number of ticks the thread was running on. */
+	uint32_t switches;				/**< The number of times the thread was switched to. */
+	uint8_t priority;				/**< The priority, 0 is the highest. Less than \ref THREAD_PRIORITIES. */
+	uint64_t wake_tsc;				/**< The time stamp counter when the thread was last woken, to measure the scheduler latency. */
+	struct thread * next;			/**< The next thread in the run queue. */
+	struct thread * wait_next;		/**< The next thread in the wait queue it is blocked on. */
+	bool fpu_used;					/**< Whether the thread has used the FPU, so \ref fpu_state is valid. */
+	uint8_t fpu_state[FPU_STATE_SIZE] __attribute__((aligned(16)));	/**< The saved FPU and SSE registers when not loaded. */
+	struct process * process;		/**< The user process the thread runs. NULL for a kernel thread. */
+} thread_t;
+
+/**
+ * \brief Turn the boot context into the first thread and create the idle thread. Before this, the
+ * blocking functions halt until the next interrupt instead.
+ */
+void thread_init(void);
+
+/**
+ * \brief Create a new thread and add it to the run queue.
+ * 
+ * \param [in] name The name of the thread. Is truncated to \ref THREAD_NAME_SIZE.
+ * \param [in] entry The function the thread runs. The thread exits if this returns.
+ * \param [in] arg The argument passed to \p entry.
+ * \param [in] priority The priority of the thread, 0 is the highest. Is capped to the lowest
+ * priority.
+ * 
+ * \return The new thread. NULL if there are no free threads or no memory for the stack.
+ */
+thread_t * thread_create(const char * name, thread_entry_t entry, void * arg, uint8_t priority);
+
+/**
+ * \brief End the current thread. Its stack is freed by the next thread to run.
+ */
+noreturn void thread_exit(void);
+
+/**
+ * \brief Get the running thread.
+ * 
+ * \return The running thread. NULL if \ref thread_init hasn't been called.
+ */
+thread_t * thread_current(void);
+
+/**
+ * \brief Change the priority of the current thread. If a thread of a higher priority is ready,
+ * then switches to it.
+ * 
+ * \param [in] priority The new priority, 0 is the highest. Is capped to the lowest priority.
+ */
+void thread_set_priority(uint8_t priority);
+
+/**
+ * \brief Give up the CPU to the next ready thread of the same or higher priority.
+ */
+void thread_yield(void);
+
+/**
+ * \brief Block the current thread until \ref thread_unblock is called for it. Must be called with
+ * interrupts disabled, after checking the condition being waited on, so a wake up from an IRQ
+ * handler isn't lost. Returns with interrupts still disabled. Callers should loop re-checking the
+ * condition.
+ */
+void thread_block(void);
+
+/**
+ * \brief Make a blocked thread ready to run. Does nothing if the thread isn't blocked. Can be
+ * called from an IRQ handler. If the thread is a higher priority than the running thread, then it
+ * is switched to straight away, or at the end of the IRQ if called from an IRQ handler.
+ * 
+ * \param [in] thread The thread to wake.
+ */
+void thread_unblock(thread_t * thread);
+
+/**
+ * \brief Put the current thread to sleep for a number of ticks.
+ * 
+ * \param [in] ticks The number of ticks to sleep for.
+ */
+void thread_sleep(uint32_t ticks);
+
+/**
+ * \brief Called on every tick to count down the time slice.
+ */
+void thread_tick(void);
+
+/**
+ * \brief Called at the end of an IRQ after the end of interrupt has been sent. Switches thread if
+ * the time slice has run out or a higher priority thread was woken.
+ */
+void thread_preempt(void);
+
+/**
+ * \brief Print all the threads with their state, priority and number of ticks run.
+ */
+void thread_dump(void);
+
+#endif /* INCLUDE_THREAD_H */
@@ -0,0 +1,36 @@
+/**
+ * \file timekeeping.h
+ * \brief Functions for the wall clock, the number of seconds since 00:00:00 UTC, 1 January 1970.
+ * The RTC sets the time of a point on the monotonic clock, and the time now is that plus the time
+ * passed on the monotonic clock, so reading it doesn't touch the CMOS. The RTC sets it again now
+ * and then so it doesn't drift from the RTC.
+ */
+#ifndef INCLUDE_TIMEKEEPING_H
+#define INCLUDE_TIMEKEEPING_H
+
+#include <stdint.h>
+
+/**
+ * \brief Set the wall clock. Must be called after \ref clock_init.
+ * 
+ * \param [in] seconds The number of seconds since 1970 in UTC, as of now on the monotonic clock.
+ */
+void timekeeping_sync(uint32_t seconds);
+
+/**
+ * \brief Get the wall clock.
+ * 
+ * \return The number of seconds since 1970 in UTC. 0 if it hasn't been set.
+ */
+uint32_t timekeeping_get_time(void);
+
+/**
+ * \brief Get the wall clock rounded to the nearest second. For reading on a second boundary, such
+ * as the RTC update-ended interrupt, where the monotonic clock can have drifted a little either side
+ * of the RTC since the wall clock was set.
+ * 
+ * \return The number of seconds since 1970 in UTC. 0 if it hasn't been set.
+ */
+uint32_t timekeeping_get_time_nearest(void);
+
+#endif /* INCLUDE_TIMEKEEPING_H */
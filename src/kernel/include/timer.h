@@ -0,0 +1,121 @@
+/**
+ * \file timer.h
+ * \brief Functions, definitions and structures for the kernel timers. The timers are kept in a
+ * hierarchical timing wheel that is advanced by the tick IRQ. Level 0 has a slot for each of the
+ * next 64 ticks, and each level above has slots 64 times as long. Timers are moved down a level
+ * when the level below wraps round, so adding and cancelling a timer are both O(1).
+ */
+#ifndef INCLUDE_TIMER_H
+#define INCLUDE_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The number of bits of the expiry tick used to index each level of the wheel.
+ */
+#define TIMER_WHEEL_BITS		6
+
+/**
+ * \brief The number of slots in each level of the wheel.
+ */
+#define TIMER_WHEEL_SLOTS		(1 << TIMER_WHEEL_BITS)
+
+/**
+ * \brief The number of levels of the wheel. Timers further away than the wheel covers,
+ * 2^(bits * levels) ticks (about 4.6 hours at 1000Hz), are put in the last slot and re-added when
+ * they get there.
+ */
+#define TIMER_WHEEL_LEVELS		4
+
+/**
+ * \typedef typedef void (*timer_callback_t)(void * arg)
+ * \brief The type of the function called when a timer expires. Is called from the tick IRQ with
+ * interrupts disabled, so must be short and not block.
+ * \param [in] arg The argument given to \ref timer_add.
+ */
+typedef void (*timer_callback_t)(void * arg);
+
+/**
+ * \struct timer_t
+ * 
+ * \brief A timer. Owned by the caller, so no memory needs to be allocated to add one. Must be set
+ * up with \ref timer_init before first use and stay valid until it has expired or been cancelled.
+ */
+typedef struct timer {
+	struct timer * next;			/**< The next timer in the wheel slot. */
+	struct timer * prev;			/**< The previous timer in the wheel slot. */
+	struct timer ** head;			/**< The head of the list the timer is in, so can be removed in O(1). */
+	uint32_t expires;				/**< The tick the timer expires on. */
+	timer_callback_t callback;		/**< The function to call when the timer expires. */
+	void * arg;						/**< The argument for \ref callback. */
+	bool pending;					/**< Whether the timer is in the wheel. */
+} timer_t;
+
+/**
+ * \brief Set up a timer so it isn't pending.
+ * 
+ * \param [in] timer The timer to set up.
+ */
+void timer_init(timer_t * timer);
+
+/**
+ * \brief Add a timer to call \p callback on the tick \p deadline. If the timer is already
+ * pending, then it is moved to the new deadline.
+ * 
+ * \param [in] timer The timer to add.
+ * \param [in] deadline The tick from \ref clockevent_get_ticks to expire on. If already passed, then
+ * expires on the next tick.
+ * \param [in] callback The function to call when the timer expires.
+ * \param [in] arg The argument to pass to \p callback.
+ */
+void timer_add(timer_t * timer, uint32_t deadline, timer_callback_t callback, void * arg);
+
+/**
+ * \brief Cancel a timer. Does nothing if the timer isn't pending.
+ * 
+ * \param [in] timer The timer to cancel.
+ */
+void timer_cancel(timer_t * timer);
+
+/**
+ * \brief Get whether a timer is waiting to expire.
+ * 
+ * \param [in] timer The timer.
+ * 
+ * \return Whether the timer is pending.
+ */
+bool timer_pending(timer_t * timer);
+
+/**
+ * \brief Convert milliseconds to ticks, rounding up.
+ * 
+ * \param [in] milliseconds The number of milliseconds.
+ * 
+ * \return The number of ticks.
+ */
+uint32_t timer_ms_to_ticks(uint32_t milliseconds);
+
+/**
+ * \brief Block the current thread for a number of milliseconds.
+ * 
+ * \param [in] milliseconds The number of milliseconds to sleep for.
+ */
+void sleep_ms(uint32_t milliseconds);
+
+/**
+ * \brief Get the number of ticks until the wheel next needs advancing, for the tickless idle.
+ * This is the next timer to expire, or the next time a level needs moving down if that is sooner.
+ * Interrupts must be disabled.
+ * 
+ * \return The number of ticks. 0xFFFFFFFF if there are no timers.
+ */
+uint32_t timer_ticks_to_next(void);
+
+/**
+ * \brief Advance the wheel up to the current tick, running the callbacks of the expired timers.
+ * Called from the tick IRQ.
+ */
+void timer_run(void);
+
+#endif /* INCLUDE_TIMER_H */
@@ -3,10 +3,6 @@
  * \brief The terminal interface that uses VGA display to display strings to the screen. The
  * screen is a 80x25 character display using the video memory address to display the characters.
  * Also initialises the display depending whether parameters where given from the bootloader.
- * 
- * \todo Don't have RTC use the TTY for setting the time, maybe? Could just have a loop that gets
- * the the current time and the RTC just sets a variable so the interrupt don't have to print to
- * the screen as this takes time.
  */
 #ifndef INCLUDE_TTY_H
 #define INCLUDE_TTY_H
@@ -57,7 +53,7 @@ rtc_date_time_t * tty_get_time(rtc_date_time_t * date);
 
 /**
  * \brief Set the display time/clock on the display below the logo. Displays the day, date and
- * time.
+ * time set by \ref tty_set_time.
  */
 void tty_set_display_time(void);
 
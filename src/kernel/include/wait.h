@@ -0,0 +1,152 @@
+/**
+ * \file wait.h
+ * \brief Functions and structures for waiting on events. A wait queue is a list of the threads
+ * blocked on an event, and is woken by whatever signals the event, usually an IRQ handler, so a
+ * waiting thread only runs again when its event has happened. Completions and semaphores are built
+ * on top of wait queues for the common cases.
+ */
+#ifndef INCLUDE_WAIT_H
+#define INCLUDE_WAIT_H
+
+#include <thread.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \brief The count of a completion after \ref complete_all, so every wait returns straight away.
+ */
+#define COMPLETION_ALL		0xFFFFFFFF
+
+/**
+ * \struct wait_queue_t
+ * 
+ * \brief A first in first out list of the threads waiting on an event.
+ */
+typedef struct wait_queue {
+	thread_t * head;				/**< The thread that has waited the longest. */
+	thread_t * tail;				/**< The thread that started waiting last, so adding is O(1). */
+} wait_queue_t;
+
+/**
+ * \struct completion_t
+ * 
+ * \brief An event that happens a number of times, such as a device finishing a command. Each
+ * \ref complete lets one \ref wait_for_completion return, whichever happens first.
+ */
+typedef struct completion {
+	uint32_t done;					/**< The number of completions not yet waited for. */
+	wait_queue_t waiters;			/**< The threads waiting for a completion. */
+} completion_t;
+
+/**
+ * \struct semaphore_t
+ * 
+ * \brief A counting semaphore.
+ */
+typedef struct semaphore {
+	int32_t count;					/**< The number of times can be taken without waiting. */
+	wait_queue_t waiters;			/**< The threads waiting for the count to go above zero. */
+} semaphore_t;
+
+/**
+ * \brief Set up an empty wait queue.
+ * 
+ * \param [in] queue The wait queue to set up.
+ */
+void wait_queue_init(wait_queue_t * queue);
+
+/**
+ * \brief Block the current thread on a wait queue until it is woken. Like \ref thread_block, must
+ * be called with interrupts disabled after checking the condition being waited on, and returns
+ * with interrupts still disabled. Callers should loop re-checking the condition.
+ * 
+ * \param [in] queue The wait queue to wait on.
+ */
+void wait_queue_sleep(wait_queue_t * queue);
+
+/**
+ * \brief Wake the thread that has waited the longest on a wait queue. Can be called from an IRQ
+ * handler.
+ * 
+ * \param [in] queue The wait queue.
+ * 
+ * \return Whether there was a thread to wake.
+ */
+bool wake_up_one(wait_queue_t * queue);
+
+/**
+ * \brief Wake all the threads waiting on a wait queue. Can be called from an IRQ handler.
+ * 
+ * \param [in] queue The wait queue.
+ */
+void wake_up_all(wait_queue_t * queue);
+
+/**
+ * \brief Set up a completion that hasn't happened.
+ * 
+ * \param [in] completion The completion to set up.
+ */
+void completion_init(completion_t * completion);
+
+/**
+ * \brief Forget any completions that haven't been waited for, before starting a new request.
+ * 
+ * \param [in] completion The completion to reset.
+ */
+void reinit_completion(completion_t * completion);
+
+/**
+ * \brief Signal a completion, waking one waiting thread. Can be called from an IRQ handler.
+ * 
+ * \param [in] completion The completion.
+ */
+void complete(completion_t * completion);
+
+/**
+ * \brief Signal a completion for good, waking all the waiting threads and any that wait later.
+ * Can be called from an IRQ handler.
+ * 
+ * \param [in] completion The completion.
+ */
+void complete_all(completion_t * completion);
+
+/**
+ * \brief Block until a completion has been signaled, then use it up.
+ * 
+ * \param [in] completion The completion to wait for.
+ */
+void wait_for_completion(completion_t * completion);
+
+/**
+ * \brief Set up a semaphore.
+ * 
+ * \param [in] semaphore The semaphore to set up.
+ * \param [in] count The number of times the semaphore can be taken before having to wait.
+ */
+void semaphore_init(semaphore_t * semaphore, int32_t count);
+
+/**
+ * \brief Take a semaphore, blocking until the count is above zero.
+ * 
+ * \param [in] semaphore The semaphore to take.
+ */
+void semaphore_down(semaphore_t * semaphore);
+
+/**
+ * \brief Take a semaphore if can do without waiting. Can be called from an IRQ handler.
+ * 
+ * \param [in] semaphore The semaphore to take.
+ * 
+ * \return Whether the semaphore was taken.
+ */
+bool semaphore_try_down(semaphore_t * semaphore);
+
+/**
+ * \brief Give back a semaphore, waking a waiting thread. Can be called from an IRQ handler.
+ * 
+ * \param [in] semaphore The semaphore to give back.
+ */
+void semaphore_up(semaphore_t * semaphore);
+
+#endif /* INCLUDE_WAIT_H */
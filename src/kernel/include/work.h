@@ -0,0 +1,73 @@
+/**
+ * \file work.h
+ * \brief Functions and structures for deferred work. IRQ handlers only acknowledge the device and
+ * queue the slow part as work, which is run with interrupts enabled after the end of interrupt has
+ * been sent, or by the idle thread. This keeps the time spent with interrupts disabled short.
+ */
+#ifndef INCLUDE_WORK_H
+#define INCLUDE_WORK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * \typedef typedef void (*work_func_t)(void * arg)
+ * \brief The type of the function run for a piece of work. Is run with interrupts enabled, but
+ * still in an IRQ, so must not block.
+ * \param [in] arg The argument given to \ref work_init.
+ */
+typedef void (*work_func_t)(void * arg);
+
+/**
+ * \struct work_t
+ * 
+ * \brief A piece of deferred work. Owned by the caller, so can be queued from an IRQ handler
+ * without allocating memory.
+ */
+typedef struct work {
+	struct work * next;				/**< The next work in the queue. */
+	work_func_t func;				/**< The function to run. */
+	void * arg;						/**< The argument for \ref func. */
+	bool pending;					/**< Whether the work is in the queue. */
+} work_t;
+
+/**
+ * \brief Set up a piece of work.
+ * 
+ * \param [in] work The work to set up.
+ * \param [in] func The function to run.
+ * \param [in] arg The argument to pass to \p func.
+ */
+void work_init(work_t * work, work_func_t func, void * arg);
+
+/**
+ * \brief Add a piece of work to the end of the queue. Can be called from an IRQ handler. If the
+ * work is already queued, then it is only run once.
+ * 
+ * \param [in] work The work to queue.
+ */
+void work_queue(work_t * work);
+
+/**
+ * \brief Get whether there is work waiting to be run.
+ * 
+ * \return Whether the queue isn't empty.
+ */
+bool work_pending(void);
+
+/**
+ * \brief Get whether the deferred work is being run. Thread switches are held back until it has
+ * finished, so the queue isn't left half run while another thread runs.
+ * 
+ * \return Whether \ref work_run is running.
+ */
+bool work_in_progress(void);
+
+/**
+ * \brief Run all the queued work, including any queued while running. Must be called with
+ * interrupts disabled. Interrupts are enabled while each function runs and disabled again on
+ * return. Does nothing if already running lower down the stack.
+ */
+void work_run(void);
+
+#endif /* INCLUDE_WORK_H */
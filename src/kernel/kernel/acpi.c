@@ -0,0 +1,226 @@
+#include <acpi.h>
+#include <paging.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+static uint32_t acpi_lapic_address = 0;								/**< The physical address of the local APICs. */
+static uint8_t acpi_lapic_ids[ACPI_MAX_CPUS];						/**< The local APIC ID of each usable CPU. */
+static uint32_t acpi_cpu_count = 0;									/**< The number of usable CPUs. */
+static acpi_ioapic_t acpi_ioapics[ACPI_MAX_IOAPICS];				/**< The I/O APICs. */
+static uint32_t acpi_ioapic_count = 0;								/**< The number of I/O APICs. */
+static acpi_irq_override_t acpi_irq_overrides[ACPI_MAX_IRQ_OVERRIDES];	/**< The ISA IRQ overrides. */
+static uint32_t acpi_irq_override_count = 0;						/**< The number of ISA IRQ overrides. */
+static uint32_t acpi_hpet_address = 0;								/**< The physical address of the HPET registers. */
+
+/**
+ * \brief Check the bytes of a structure add up to zero.
+ * 
+ * \param [in] ptr The structure.
+ * \param [in] length The length of the structure.
+ * 
+ * \return Whether the checksum is valid.
+ */
+static bool acpi_checksum(const void * ptr, uint32_t length) {
+	const uint8_t * bytes = (const uint8_t *) ptr;
+	uint8_t sum = 0;
+	for(uint32_t i = 0; i < length; i++) {
+		sum += bytes[i];
+	}
+	return sum == 0;
+}
+
+/**
+ * \brief Search for the RSDP on the 16 byte boundaries of a memory area.
+ * 
+ * \param [in] start The start of the area.
+ * \param [in] length The length of the area.
+ * 
+ * \return The RSDP. NULL if not found.
+ */
+static acpi_rsdp_t * acpi_search_rsdp(uint32_t start, uint32_t length) {
+	for(uint32_t addr = start; addr < start + length; addr += 16) {
+		acpi_rsdp_t * rsdp = (acpi_rsdp_t *) addr;
+		if(memcmp(rsdp->signature, "RSD PTR ", 8) == 0 && acpi_checksum(rsdp, sizeof(acpi_rsdp_t))) {
+			return rsdp;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * \brief Find the RSDP in the first KB of the extended BIOS data area, or the BIOS ROM.
+ * 
+ * \return The RSDP. NULL if not found.
+ */
+static acpi_rsdp_t * acpi_find_rsdp(void) {
+	// The BIOS data area has the real mode segment of the EBDA
+	uint16_t ebda_segment;
+	__asm__ __volatile__ ("mov %w0, [0x40E]" : "=r" (ebda_segment));
+	uint32_t ebda = (uint32_t) ebda_segment << 4;
+	if(ebda) {
+		acpi_rsdp_t * rsdp = acpi_search_rsdp(ebda, 1024);
+		if(rsdp) {
+			return rsdp;
+		}
+	}
+	
+	return acpi_search_rsdp(0xE0000, 0x20000);
+}
+
+/**
+ * \brief Map an ACPI table and check it is valid. The tables can be anywhere in memory, so only the
+ * first 4MB being mapped isn't enough.
+ * 
+ * \param [in] address The physical address of the table.
+ * 
+ * \return The table. NULL if the checksum is wrong.
+ */
+static acpi_header_t * acpi_map_table(uint32_t address) {
+	vmm_map_range(address, sizeof(acpi_header_t));
+	
+	acpi_header_t * header = (acpi_header_t *) address;
+	vmm_map_range(address, header->length);
+	
+	if(!acpi_checksum(header, header->length)) {
+		return NULL;
+	}
+	return header;
+}
+
+/**
+ * \brief Record the CPUs, I/O APICs and IRQ overrides from the MADT entries.
+ * 
+ * \param [in] madt The MADT.
+ */
+static void acpi_parse_madt(acpi_madt_t * madt) {
+	acpi_lapic_address = madt->lapic_address;
+	
+	uint8_t * entry = (uint8_t *) (madt + 1);
+	uint8_t * end = (uint8_t *) madt + madt->header.length;
+	
+	// Each entry starts with the type and length
+	while(entry + 2 <= end && entry[1] >= 2) {
+		switch(entry[0]) {
+			case ACPI_MADT_LAPIC: {
+				uint32_t flags = *(uint32_t *) &entry[4];
+				if((flags & ACPI_MADT_LAPIC_ENABLED) && acpi_cpu_count < ACPI_MAX_CPUS) {
+					acpi_lapic_ids[acpi_cpu_count++] = entry[3];
+				}
+				break;
+			}
+			
+			case ACPI_MADT_IOAPIC:
+				if(acpi_ioapic_count < ACPI_MAX_IOAPICS) {
+					acpi_ioapic_t * ioapic = &acpi_ioapics[acpi_ioapic_count++];
+					ioapic->id = entry[2];
+					ioapic->address = *(uint32_t *) &entry[4];
+					ioapic->gsi_base = *(uint32_t *) &entry[8];
+				}
+				break;
+			
+			case ACPI_MADT_IRQ_OVERRIDE:
+				if(acpi_irq_override_count < ACPI_MAX_IRQ_OVERRIDES) {
+					acpi_irq_override_t * override = &acpi_irq_overrides[acpi_irq_override_count++];
+					override->irq = entry[3];
+					override->gsi = *(uint32_t *) &entry[4];
+					override->flags = *(uint16_t *) &entry[8];
+				}
+				break;
+			
+			default:
+				break;
+		}
+		
+		entry += entry[1];
+	}
+}
+
+/**
+ * \brief Record the address of the HPET from the HPET table.
+ * 
+ * \param [in] hpet The HPET table.
+ */
+static void acpi_parse_hpet(acpi_hpet_t * hpet) {
+	// The registers are memory mapped, and this kernel only maps the first 4GB
+	if(hpet->space_id != 0 || (hpet->address >> 32) != 0) {
+		return;
+	}
+	
+	acpi_hpet_address = (uint32_t) hpet->address;
+}
+
+bool acpi_init(void) {
+	acpi_rsdp_t * rsdp = acpi_find_rsdp();
+	if(!rsdp) {
+		kprintf("ACPI: No RSDP\n");
+		return false;
+	}
+	
+	acpi_header_t * rsdt = acpi_map_table(rsdp->rsdt_address);
+	if(!rsdt || memcmp(rsdt->signature, "RSDT", 4) != 0) {
+		kprintf("ACPI: Bad RSDT at 0x%08X\n", rsdp->rsdt_address);
+		return false;
+	}
+	
+	// The RSDT is a list of the physical addresses of the other tables
+	uint32_t * tables = (uint32_t *) (rsdt + 1);
+	uint32_t num_tables = (rsdt->length - sizeof(acpi_header_t)) / sizeof(uint32_t);
+	
+	bool found_madt = false;
+	for(uint32_t i = 0; i < num_tables; i++) {
+		acpi_header_t * table = acpi_map_table(tables[i]);
+		if(!table) {
+			continue;
+		}
+		
+		if(memcmp(table->signature, "APIC", 4) == 0) {
+			acpi_parse_madt((acpi_madt_t *) table);
+			kprintf("ACPI: %u CPUs, %u I/O APICs, local APIC at 0x%08X\n", acpi_cpu_count, acpi_ioapic_count, acpi_lapic_address);
+			found_madt = true;
+		} else if(memcmp(table->signature, "HPET", 4) == 0) {
+			acpi_parse_hpet((acpi_hpet_t *) table);
+		}
+	}
+	
+	if(!found_madt) {
+		kprintf("ACPI: No MADT\n");
+	}
+	return found_madt;
+}
+
+uint32_t acpi_get_cpu_count(void) {
+	return acpi_cpu_count;
+}
+
+uint8_t acpi_get_lapic_id(uint32_t index) {
+	return acpi_lapic_ids[index];
+}
+
+uint32_t acpi_get_lapic_address(void) {
+	return acpi_lapic_address;
+}
+
+uint32_t acpi_get_ioapic_count(void) {
+	return acpi_ioapic_count;
+}
+
+const acpi_ioapic_t * acpi_get_ioapic(uint32_t index) {
+	return &acpi_ioapics[index];
+}
+
+const acpi_irq_override_t * acpi_get_irq_override(uint8_t irq) {
+	for(uint32_t i = 0; i < acpi_irq_override_count; i++) {
+		if(acpi_irq_overrides[i].irq == irq) {
+			return &acpi_irq_overrides[i];
+		}
+	}
+	return NULL;
+}
+
+uint32_t acpi_get_hpet_address(void) {
+	return acpi_hpet_address;
+}
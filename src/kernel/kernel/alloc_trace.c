@@ -0,0 +1,157 @@
+#include <alloc_trace.h>
+#include <ksyms.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef ALLOC_TRACE
+
+/**
+ * \struct alloc_trace_live_t
+ * 
+ * \brief A live allocation, so the call site can be found when it is freed.
+ */
+typedef struct {
+	uint32_t ptr;			/**< The allocated address. 0 if unused. \ref ALLOC_TRACE_TOMBSTONE if was freed. */
+	uint32_t site;			/**< The index into \ref alloc_trace_sites of the call site that allocated it. */
+} alloc_trace_live_t;
+
+/**
+ * \brief The value of a live entry that has been freed, so probing carries on past it.
+ */
+#define ALLOC_TRACE_TOMBSTONE	0xFFFFFFFF
+
+static alloc_trace_site_t alloc_trace_sites[ALLOC_TRACE_SITES];	/**< The call sites hash table. */
+static alloc_trace_live_t alloc_trace_live[ALLOC_TRACE_LIVE];		/**< The live allocations hash table. */
+static uint32_t alloc_trace_dropped_sites;							/**< The number of allocations not recorded as the call site table was full. */
+static uint32_t alloc_trace_dropped_live;							/**< The number of allocations not tracked as live as the live table was full. */
+
+/**
+ * \brief Hash an address into a table of \p size entries. Multiplicative hashing with the lower 2
+ * bits dropped as addresses are usually word aligned.
+ * 
+ * \param [in] addr The address to hash.
+ * \param [in] size The size of the table, a power of 2.
+ * 
+ * \return The index into the table.
+ */
+static uint32_t alloc_trace_hash(uint32_t addr, uint32_t size) {
+	return ((addr >> 2) * 2654435761u) & (size - 1);
+}
+
+/**
+ * \brief Find or add the entry for a call site.
+ * 
+ * \param [in] call_site The call site.
+ * 
+ * \return The index into \ref alloc_trace_sites. ALLOC_TRACE_SITES if the table is full.
+ */
+static uint32_t alloc_trace_find_site(uint32_t call_site) {
+	uint32_t index = alloc_trace_hash(call_site, ALLOC_TRACE_SITES);
+	
+	for(uint32_t i = 0; i < ALLOC_TRACE_SITES; i++) {
+		alloc_trace_site_t * site = &alloc_trace_sites[index];
+		if(site->call_site == call_site) {
+			return index;
+		}
+		
+		if(site->call_site == 0) {
+			site->call_site = call_site;
+			return index;
+		}
+		
+		index = (index + 1) & (ALLOC_TRACE_SITES - 1);
+	}
+	
+	return ALLOC_TRACE_SITES;
+}
+
+void alloc_trace_alloc(void * call_site, void * ptr, uint32_t size) {
+	uint32_t site_index = alloc_trace_find_site((uint32_t) call_site);
+	if(site_index == ALLOC_TRACE_SITES) {
+		alloc_trace_dropped_sites++;
+		return;
+	}
+	
+	alloc_trace_sites[site_index].count++;
+	alloc_trace_sites[site_index].bytes += size;
+	
+	if(!ptr) {
+		return;
+	}
+	
+	uint32_t index = alloc_trace_hash((uint32_t) ptr, ALLOC_TRACE_LIVE);
+	for(uint32_t i = 0; i < ALLOC_TRACE_LIVE; i++) {
+		alloc_trace_live_t * live = &alloc_trace_live[index];
+		if(live->ptr == 0 || live->ptr == ALLOC_TRACE_TOMBSTONE) {
+			live->ptr = (uint32_t) ptr;
+			live->site = site_index;
+			alloc_trace_sites[site_index].live++;
+			return;
+		}
+		
+		index = (index + 1) & (ALLOC_TRACE_LIVE - 1);
+	}
+	
+	alloc_trace_dropped_live++;
+}
+
+void alloc_trace_free(void * ptr) {
+	uint32_t index = alloc_trace_hash((uint32_t) ptr, ALLOC_TRACE_LIVE);
+	
+	for(uint32_t i = 0; i < ALLOC_TRACE_LIVE; i++) {
+		alloc_trace_live_t * live = &alloc_trace_live[index];
+		if(live->ptr == 0) {
+			return;		// Not tracked
+		}
+		
+		if(live->ptr == (uint32_t) ptr) {
+			alloc_trace_sites[live->site].live--;
+			live->ptr = ALLOC_TRACE_TOMBSTONE;
+			return;
+		}
+		
+		index = (index + 1) & (ALLOC_TRACE_LIVE - 1);
+	}
+}
+
+void alloc_trace_dump(void) {
+	uint8_t order[ALLOC_TRACE_SITES];
+	uint32_t num_sites = 0;
+	
+	// Insertion sort the used entries by the number of bytes allocated
+	for(uint32_t i = 0; i < ALLOC_TRACE_SITES; i++) {
+		if(alloc_trace_sites[i].call_site == 0) {
+			continue;
+		}
+		
+		uint32_t j = num_sites++;
+		while(j > 0 && alloc_trace_sites[order[j - 1]].bytes < alloc_trace_sites[i].bytes) {
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = i;
+	}
+	
+	kprintf("Call site\tCount\tBytes\tLive\tSymbol\n");
+	for(uint32_t i = 0; i < num_sites; i++) {
+		alloc_trace_site_t * site = &alloc_trace_sites[order[i]];
+		uint32_t offset = 0;
+		const char * name = ksym_lookup(site->call_site, &offset);
+		
+		kprintf("0x%08X\t%u\t%u\t%u\t%s+0x%X\n", site->call_site, site->count, site->bytes, site->live, name ? name : "?", offset);
+	}
+	
+	if(alloc_trace_dropped_sites || alloc_trace_dropped_live) {
+		kprintf("Dropped: %u allocations (call site table full), %u live (live table full)\n", alloc_trace_dropped_sites, alloc_trace_dropped_live);
+	}
+}
+
+#else
+
+void alloc_trace_dump(void) {
+	kprintf("Allocation tracing is disabled, build the kernel with ALLOC_TRACE=1\n");
+}
+
+#endif /* ALLOC_TRACE */
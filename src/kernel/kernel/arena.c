@@ -0,0 +1,139 @@
+#include <arena.h>
+#include <pmm.h>
+#include <alloc_trace.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \brief Round \p size up to the arena alignment.
+ * 
+ * \param [in] size The size to round up.
+ * 
+ * \return The aligned size.
+ */
+static uint32_t arena_align(uint32_t size) {
+	return (size + (ARENA_ALIGNMENT - 1)) & ~(ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * \brief Allocate a new chunk of continues blocks from the physical memory manager.
+ * 
+ * \param [in] num_blocks The number of blocks for the chunk.
+ * 
+ * \return The chunk. NULL if no more physical memory.
+ */
+static arena_chunk_t * arena_new_chunk(uint32_t num_blocks) {
+	arena_chunk_t * chunk = (arena_chunk_t *) pmm_alloc_blocks(num_blocks);
+	if(!chunk) {
+		return NULL;
+	}
+	
+	chunk->next = NULL;
+	chunk->num_blocks = num_blocks;
+	chunk->size = num_blocks * PMM_BLOCK_SIZE;
+	
+	return chunk;
+}
+
+/**
+ * \brief Give all chunks starting from \p chunk back to the physical memory manager.
+ * 
+ * \param [in] chunk The first chunk to free.
+ */
+static void arena_free_chunks(arena_chunk_t * chunk) {
+	while(chunk) {
+		arena_chunk_t * next = chunk->next;
+		pmm_free_blocks(chunk, chunk->num_blocks);
+		chunk = next;
+	}
+}
+
+arena_t * arena_create(uint32_t num_blocks) {
+	if(num_blocks == 0) {
+		return NULL;
+	}
+	
+	arena_chunk_t * chunk = arena_new_chunk(num_blocks);
+	if(!chunk) {
+		return NULL;
+	}
+	
+	// The arena lives straight after the chunk header in the first chunk
+	arena_t * arena = (arena_t *) ((uint8_t *) chunk + arena_align(sizeof(arena_chunk_t)));
+	arena->head = chunk;
+	arena->current = chunk;
+	arena->chunk_blocks = num_blocks;
+	arena->offset = arena_align(sizeof(arena_chunk_t)) + arena_align(sizeof(arena_t));
+	arena->used = 0;
+	
+	return arena;
+}
+
+void * arena_alloc(arena_t * arena, size_t size) {
+	if(!arena || size == 0) {
+		return NULL;
+	}
+	
+	uint32_t aligned_size = arena_align(size);
+	
+	// Not enough room in the current chunk, so move onto a new one
+	if(arena->offset + aligned_size > arena->current->size) {
+		uint32_t header = arena_align(sizeof(arena_chunk_t));
+		uint32_t num_blocks = arena->chunk_blocks;
+		
+		// Make sure the new chunk is big enough for large allocations
+		if(header + aligned_size > num_blocks * PMM_BLOCK_SIZE) {
+			num_blocks = ((header + aligned_size - 1) / PMM_BLOCK_SIZE) + 1;
+		}
+		
+		arena_chunk_t * chunk = arena_new_chunk(num_blocks);
+		if(!chunk) {
+			return NULL;
+		}
+		
+		arena->current->next = chunk;
+		arena->current = chunk;
+		arena->offset = header;
+	}
+	
+	void * ptr = (uint8_t *) arena->current + arena->offset;
+	arena->offset += aligned_size;
+	arena->used += aligned_size;
+	
+	// Arena objects are freed with the whole arena, so are counted but not tracked as live
+	alloc_trace_alloc(__builtin_return_address(0), NULL, aligned_size);
+	
+	return ptr;
+}
+
+void arena_reset(arena_t * arena) {
+	if(!arena) {
+		return;
+	}
+	
+	// Only the extra chunks need freeing, the first chunk is reused as is
+	arena_free_chunks(arena->head->next);
+	arena->head->next = NULL;
+	
+	arena->current = arena->head;
+	arena->offset = arena_align(sizeof(arena_chunk_t)) + arena_align(sizeof(arena_t));
+	arena->used = 0;
+}
+
+void arena_destroy(arena_t * arena) {
+	if(!arena) {
+		return;
+	}
+	
+	// The arena is inside the first chunk, so this frees the arena too
+	arena_free_chunks(arena->head);
+}
+
+uint32_t arena_get_used(arena_t * arena) {
+	if(!arena) {
+		return 0;
+	}
+	
+	return arena->used;
+}
@@ -0,0 +1,206 @@
+#include <async.h>
+#include <timer.h>
+#include <work.h>
+#include <clockevent.h>
+#include <interrupt.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+static async_t * ready_head = NULL;		/**< The first coroutine in the ready queue. */
+static async_t * ready_tail = NULL;		/**< The last coroutine in the ready queue, so adding is O(1). */
+static uint32_t ready_count = 0;		/**< The number of coroutines in the ready queue. */
+static work_t async_work;				/**< The deferred work that runs the ready coroutines. */
+
+/**
+ * \brief Take a coroutine out of the waiters of its event. Interrupts must be disabled.
+ * 
+ * \param [in] task The coroutine.
+ */
+static void async_event_remove(async_t * task) {
+	async_event_t * event = task->event;
+	if(!event) {
+		return;
+	}
+	
+	for(async_t ** link = &event->waiters; *link; link = &(*link)->wait_next) {
+		if(*link == task) {
+			*link = task->wait_next;
+			break;
+		}
+	}
+	
+	task->event = NULL;
+	task->wait_next = NULL;
+}
+
+/**
+ * \brief Take a coroutine out of the ready queue. Interrupts must be disabled.
+ * 
+ * \param [in] task The coroutine.
+ */
+static void async_ready_remove(async_t * task) {
+	if(!task->ready) {
+		return;
+	}
+	
+	async_t * prev = NULL;
+	for(async_t * t = ready_head; t; prev = t, t = t->next) {
+		if(t == task) {
+			if(prev) {
+				prev->next = task->next;
+			} else {
+				ready_head = task->next;
+			}
+			if(ready_tail == task) {
+				ready_tail = prev;
+			}
+			ready_count--;
+			break;
+		}
+	}
+	
+	task->next = NULL;
+	task->ready = false;
+}
+
+/**
+ * \brief The deferred work that resumes the ready coroutines.
+ * 
+ * \param [in] arg Unused.
+ */
+static void async_run(void * arg) {
+	(void) arg;
+	
+	// Only run the ones ready now, so a coroutine that yields lets the other work run before it
+	// carries on
+	uint32_t flags = interrupt_save();
+	uint32_t count = ready_count;
+	
+	while(count-- && ready_head) {
+		async_t * task = ready_head;
+		async_ready_remove(task);
+		interrupt_restore(flags);
+		
+		if(task->active && task->func(task) == ASYNC_DONE) {
+			task->active = false;
+		}
+		
+		flags = interrupt_save();
+	}
+	
+	interrupt_restore(flags);
+}
+
+/**
+ * \brief The timer callback that wakes a sleeping coroutine.
+ * 
+ * \param [in] arg The coroutine to wake.
+ */
+static void async_sleep_timeout(void * arg) {
+	async_wake((async_t *) arg);
+}
+
+void async_init(void) {
+	work_init(&async_work, async_run, NULL);
+}
+
+bool async_start(async_t * task, async_func_t func, void * arg) {
+	if(task->active) {
+		return false;
+	}
+	
+	task->resume = 0;
+	task->func = func;
+	task->arg = arg;
+	task->active = true;
+	task->ready = false;
+	task->next = NULL;
+	task->event = NULL;
+	task->wait_next = NULL;
+	timer_init(&task->timer);
+	
+	async_wake(task);
+	return true;
+}
+
+void async_cancel(async_t * task) {
+	uint32_t flags = interrupt_save();
+	
+	if(task->active) {
+		timer_cancel(&task->timer);
+		async_ready_remove(task);
+		async_event_remove(task);
+		task->active = false;
+	}
+	
+	interrupt_restore(flags);
+}
+
+bool async_active(async_t * task) {
+	return task->active;
+}
+
+void async_wake(async_t * task) {
+	uint32_t flags = interrupt_save();
+	
+	if(task->active && !task->ready) {
+		async_event_remove(task);
+		
+		task->ready = true;
+		task->next = NULL;
+		if(ready_tail) {
+			ready_tail->next = task;
+		} else {
+			ready_head = task;
+		}
+		ready_tail = task;
+		
+		work_queue(&async_work);
+	}
+	
+	interrupt_restore(flags);
+}
+
+void async_sleep(async_t * task, uint32_t milliseconds) {
+	timer_add(&task->timer, clockevent_get_ticks() + timer_ms_to_ticks(milliseconds), async_sleep_timeout, task);
+}
+
+void async_event_init(async_event_t * event) {
+	event->waiters = NULL;
+	event->pending = false;
+}
+
+void async_event_wait(async_event_t * event, async_t * task) {
+	uint32_t flags = interrupt_save();
+	
+	if(event->pending) {
+		event->pending = false;
+		async_wake(task);
+	} else {
+		task->event = event;
+		task->wait_next = event->waiters;
+		event->waiters = task;
+	}
+	
+	interrupt_restore(flags);
+}
+
+void async_event_signal(async_event_t * event) {
+	uint32_t flags = interrupt_save();
+	
+	if(!event->waiters) {
+		event->pending = true;
+	}
+	
+	while(event->waiters) {
+		async_t * task = event->waiters;
+		event->waiters = task->wait_next;
+		task->event = NULL;
+		task->wait_next = NULL;
+		async_wake(task);
+	}
+	
+	interrupt_restore(flags);
+}
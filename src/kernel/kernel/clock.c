@@ -0,0 +1,151 @@
+#include <clock.h>
+#include <clockevent.h>
+#include <pit.h>
+#include <cpu.h>
+#include <cpu_features.h>
+#include <interrupt.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+static bool clock_invariant = false;				/**< Whether the TSC is invariant. */
+static uint32_t clock_tsc_khz = 0;					/**< The frequency of the TSC in kHz. */
+static uint32_t clock_tsc_mult = 0;					/**< Nanoseconds per TSC cycle, with \ref CLOCK_SHIFT bits of fraction. */
+static const clock_source_t * clock_source = NULL;	/**< The source the clock is read from. NULL for the tick. */
+static uint32_t clock_mult = 0;						/**< Nanoseconds per count of the source, with \ref CLOCK_SHIFT bits of fraction. */
+static uint64_t clock_source_base = 0;				/**< The count of the source when the clock moved onto it. */
+static uint64_t clock_ns_base = 0;					/**< The time when the clock moved onto the source. */
+
+/**
+ * \brief Read the TSC as a clock source.
+ * 
+ * \return The TSC.
+ */
+static uint64_t clock_read_tsc(void) {
+	return cpu_rdtsc();
+}
+
+/**
+ * \brief The TSC as a clock source. The rating and frequency are set once it is calibrated.
+ */
+static clock_source_t clock_tsc = {
+	"TSC",
+	0,
+	0,
+	clock_read_tsc
+};
+
+/**
+ * \brief Time the TSC over \ref CLOCK_CALIBRATE_MS of counter 2 of the PIT.
+ * 
+ * \return The frequency of the TSC in kHz.
+ */
+static uint32_t clock_calibrate(void) {
+	uint32_t count = PIT_INPUT_FREQUENCY * CLOCK_CALIBRATE_MS / 1000;
+	
+	// Nothing else can run, so the count is just the TSC and the port reads
+	uint32_t flags = interrupt_save();
+	
+	pit_counter_2_start((uint16_t) count);
+	uint64_t start = cpu_rdtsc();
+	while(!pit_counter_2_done()) {
+		cpu_pause();
+	}
+	uint64_t cycles = cpu_rdtsc() - start;
+	
+	interrupt_restore(flags);
+	
+	// The count isn't a whole number of milliseconds, so scale by the clocks counted
+	return cpu_div64_32(cycles * PIT_INPUT_FREQUENCY, count * 1000);
+}
+
+/**
+ * \brief Get the multiplier from counts of a source to nanoseconds.
+ * 
+ * \param [in] khz The frequency of the source in kHz. Must be at least \ref CLOCK_MIN_KHZ so the
+ * multiplier fits in 32 bits, else it saturates.
+ * 
+ * \return Nanoseconds per count, with \ref CLOCK_SHIFT bits of fraction.
+ */
+static uint32_t clock_get_mult(uint32_t khz) {
+	return cpu_div64_32((uint64_t) 1000000 << CLOCK_SHIFT, khz);
+}
+
+/**
+ * \brief Scale a number of counts by a multiplier.
+ * 
+ * \param [in] counts The number of counts.
+ * \param [in] mult Nanoseconds per count, with \ref CLOCK_SHIFT bits of fraction.
+ * 
+ * \return The number of nanoseconds.
+ */
+static uint64_t clock_scale(uint64_t counts, uint32_t mult) {
+	// Multiply each half so the product doesn't overflow, as there is no 64 by 64 bit multiply
+	uint32_t high = (uint32_t) (counts >> 32);
+	uint32_t low = (uint32_t) counts;
+	return (((uint64_t) high * mult) << (32 - CLOCK_SHIFT)) + (((uint64_t) low * mult) >> CLOCK_SHIFT);
+}
+
+void clock_init(void) {
+	if(!cpu_has(CPU_FEATURE_TSC)) {
+		kprintf("Clock: No TSC, using the tick\n");
+		return;
+	}
+	
+	clock_invariant = cpu_has(CPU_FEATURE_INVARIANT_TSC);
+	clock_tsc_khz = clock_calibrate();
+	
+	// The TSC runs at hundreds of MHz or more, so this fits in 32 bits
+	clock_tsc_mult = clock_get_mult(clock_tsc_khz);
+	
+	kprintf("TSC: %ukHz%s\n", clock_tsc_khz, clock_invariant ? ", invariant" : "");
+	
+	clock_tsc.rating = clock_invariant ? 300 : 100;
+	clock_tsc.khz = clock_tsc_khz;
+	clock_register(&clock_tsc);
+}
+
+void clock_register(clock_source_t * source) {
+	if(source->khz < CLOCK_MIN_KHZ) {
+		kprintf("Clock: %s at %ukHz is too slow\n", source->name, source->khz);
+		return;
+	}
+	
+	if(clock_source && clock_source->rating >= source->rating) {
+		return;
+	}
+	
+	uint32_t flags = interrupt_save();
+	
+	// The time carries on from where the old source left off
+	clock_ns_base = clock_monotonic_ns();
+	clock_source = source;
+	clock_mult = clock_get_mult(source->khz);
+	clock_source_base = source->read();
+	
+	interrupt_restore(flags);
+	
+	kprintf("Clock: %s at %ukHz\n", source->name, source->khz);
+}
+
+uint64_t clock_cycles_to_ns(uint64_t cycles) {
+	return clock_scale(cycles, clock_tsc_mult);
+}
+
+uint64_t clock_monotonic_ns(void) {
+	if(!clock_source) {
+		return (uint64_t) clockevent_get_ticks() * (CLOCK_NS_PER_SEC / CLOCKEVENT_HZ);
+	}
+	
+	return clock_ns_base + clock_scale(clock_source->read() - clock_source_base, clock_mult);
+}
+
+uint32_t clock_get_tsc_khz(void) {
+	return clock_tsc_khz;
+}
+
+bool clock_tsc_is_invariant(void) {
+	return clock_invariant;
+}
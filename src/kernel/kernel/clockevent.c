@@ -0,0 +1,128 @@
+#include <clockevent.h>
+#include <irq.h>
+#include <pic.h>
+#include <regs_t.h>
+#include <thread.h>
+#include <timer.h>
+#include <interrupt.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+static clockevent_t * clockevent_devices = NULL;	/**< The registered devices. */
+static clockevent_t * tick_device = NULL;			/**< The device that drives the tick. */
+static volatile uint32_t tick_ticks;				/**< The number of ticks since the first device was registered. */
+static uint32_t tick_count;							/**< The number of counts of the tick device in each tick. */
+static uint32_t tick_remainder;						/**< The counts passed since the last tick that aren't part of the current periodic count. */
+static bool tick_tickless = true;					/**< Whether the periodic tick is stopped while idle. */
+static volatile bool tick_oneshot;					/**< Whether the tick device is in one shot mode as the CPU is idle. */
+static uint32_t tick_oneshot_count;					/**< The count the tick device was loaded with for the one shot. */
+
+/**
+ * \brief Add counts of the tick device that have passed onto the tick count.
+ * 
+ * \param [in] counts The number of counts that have passed.
+ */
+static void clockevent_add_counts(uint32_t counts) {
+	counts += tick_remainder;
+	tick_ticks += counts / tick_count;
+	tick_remainder = counts % tick_count;
+}
+
+/**
+ * \brief The handler of IRQ 0, which is raised by whichever device is the tick.
+ * 
+ * \param [in] regs The register of the CPU when the interrupt was called.
+ */
+static void clockevent_handler(regs_t * regs) {
+	(void) regs;		// Not using the registers
+	tick_ticks++;		// Increment tick count
+	timer_run();		// Run the expired timers, waking sleeping threads
+	thread_tick();		// Count down the time slice
+}
+
+void clockevent_register(clockevent_t * device) {
+	uint32_t flags = interrupt_save();
+	
+	device->next = clockevent_devices;
+	clockevent_devices = device;
+	
+	if(!(device->features & CLOCKEVENT_PERIODIC) || (tick_device && tick_device->rating >= device->rating)) {
+		interrupt_restore(flags);
+		return;
+	}
+	
+	if(tick_device) {
+		tick_device->stop();
+	} else {
+		irq_install_handler(PIC_IRQ_TIMER, clockevent_handler);
+	}
+	
+	// The ticks carry on from where the old device left off
+	tick_device = device;
+	tick_count = device->frequency / CLOCKEVENT_HZ;
+	tick_remainder = 0;
+	tick_oneshot = false;
+	device->set_periodic(tick_count);
+	
+	interrupt_restore(flags);
+	
+	kprintf("Tick: %s at %uHz\n", device->name, CLOCKEVENT_HZ);
+}
+
+const clockevent_t * clockevent_get_device(void) {
+	return tick_device;
+}
+
+uint32_t clockevent_get_ticks(void) {
+	return tick_ticks;
+}
+
+void clockevent_set_tickless(bool enable) {
+	tick_tickless = enable;
+}
+
+bool clockevent_get_tickless(void) {
+	return tick_tickless;
+}
+
+void clockevent_idle_enter(uint32_t ticks) {
+	if(!tick_device || !(tick_device->features & CLOCKEVENT_ONESHOT) || !tick_tickless || tick_oneshot || ticks <= 1) {
+		return;
+	}
+	
+	// Leave a tick spare for the part of the current tick that has passed
+	uint32_t max_ticks = tick_device->max_count / tick_count - 1;
+	if(ticks > max_ticks) {
+		ticks = max_ticks;
+	}
+	
+	// Count the part of the current tick that has passed, so the one shot ends on a tick
+	clockevent_add_counts(tick_count - tick_device->get_count());
+	
+	tick_oneshot_count = ticks * tick_count - tick_remainder;
+	tick_device->set_oneshot(tick_oneshot_count);
+	tick_oneshot = true;
+}
+
+void clockevent_idle_exit(void) {
+	if(!tick_oneshot) {
+		return;
+	}
+	
+	uint32_t count = tick_device->get_count();
+	
+	if(count == 0 || count > tick_oneshot_count) {
+		// The one shot has passed, and may have wrapped round. The IRQ has been raised and will
+		// count the last tick when handled
+		clockevent_add_counts(tick_oneshot_count - tick_count);
+	} else {
+		clockevent_add_counts(tick_oneshot_count - count);
+	}
+	
+	// Back to the periodic tick
+	tick_device->set_periodic(tick_count);
+	tick_oneshot = false;
+}
@@ -1,8 +1,11 @@
 #include <cmos.h>
 #include <portio.h>
+#include <spinlock.h>
 
 #include <stdint.h>
 
+static spinlock_t cmos_lock;	/**< Keeps the register select and the data access together. */
+
 /**
  * \todo Set the NMI bit correctly
  */
@@ -11,11 +14,32 @@
  * \todo Add delay between port operations maybe
  */
 uint8_t cmos_read(uint8_t reg) {
+	uint32_t flags = spin_lock_irqsave(&cmos_lock);
 	out_port_byte(CMOS_ADDRESS, reg);
-	return in_port_byte(CMOS_DATA);
+	uint8_t val = in_port_byte(CMOS_DATA);
+	spin_unlock_irqrestore(&cmos_lock, flags);
+	return val;
 }
 
 void cmos_write(uint8_t reg, uint8_t val) {
+	uint32_t flags = spin_lock_irqsave(&cmos_lock);
 	out_port_byte(CMOS_ADDRESS, reg);
 	out_port_byte(CMOS_DATA, val);
+	spin_unlock_irqrestore(&cmos_lock, flags);
+}
+
+uint8_t cmos_modify(uint8_t reg, uint8_t mask, uint8_t bits) {
+	uint32_t flags = spin_lock_irqsave(&cmos_lock);
+	out_port_byte(CMOS_ADDRESS, reg);
+	uint8_t prev = in_port_byte(CMOS_DATA);
+	
+	// Reading resets the selected register, so select it again
+	out_port_byte(CMOS_ADDRESS, reg);
+	out_port_byte(CMOS_DATA, (prev & ~mask) | bits);
+	spin_unlock_irqrestore(&cmos_lock, flags);
+	return prev;
+}
+
+void cmos_init(void) {
+	spin_lock_init(&cmos_lock, "cmos");
 }
@@ -0,0 +1,180 @@
+#include <cpu_features.h>
+#include <cpu.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * \struct cpu_feature_name_t
+ * 
+ * \brief The name of a feature for \ref cpu_features_dump.
+ */
+typedef struct {
+	uint32_t feature;		/**< The feature. */
+	const char * name;		/**< The name. */
+} cpu_feature_name_t;
+
+static uint32_t cpu_leaves[CPU_LEAVES][4];		/**< The cached EAX, EBX, ECX and EDX of each leaf. */
+static char cpu_vendor[13];						/**< The vendor ID string. */
+static char cpu_brand[49];						/**< The brand string. */
+static uint32_t cpu_family = 0;					/**< The CPU family, with the extended family added. */
+static uint32_t cpu_model = 0;					/**< The CPU model, with the extended model added. */
+static uint32_t cpu_stepping = 0;				/**< The CPU stepping. */
+
+/**
+ * \brief The features printed by \ref cpu_features_dump.
+ */
+static const cpu_feature_name_t cpu_feature_names[] = {
+	{ CPU_FEATURE_FPU, "fpu" },
+	{ CPU_FEATURE_TSC, "tsc" },
+	{ CPU_FEATURE_MSR, "msr" },
+	{ CPU_FEATURE_APIC, "apic" },
+	{ CPU_FEATURE_SEP, "sep" },
+	{ CPU_FEATURE_PGE, "pge" },
+	{ CPU_FEATURE_FXSR, "fxsr" },
+	{ CPU_FEATURE_SSE, "sse" },
+	{ CPU_FEATURE_SSE2, "sse2" },
+	{ CPU_FEATURE_HTT, "htt" },
+	{ CPU_FEATURE_SSE3, "sse3" },
+	{ CPU_FEATURE_SSSE3, "ssse3" },
+	{ CPU_FEATURE_SSE4_1, "sse4.1" },
+	{ CPU_FEATURE_SSE4_2, "sse4.2" },
+	{ CPU_FEATURE_X2APIC, "x2apic" },
+	{ CPU_FEATURE_POPCNT, "popcnt" },
+	{ CPU_FEATURE_TSC_DEADLINE, "tsc-deadline" },
+	{ CPU_FEATURE_XSAVE, "xsave" },
+	{ CPU_FEATURE_AVX, "avx" },
+	{ CPU_FEATURE_HYPERVISOR, "hypervisor" },
+	{ CPU_FEATURE_BMI1, "bmi1" },
+	{ CPU_FEATURE_AVX2, "avx2" },
+	{ CPU_FEATURE_SMEP, "smep" },
+	{ CPU_FEATURE_ERMS, "erms" },
+	{ CPU_FEATURE_NX, "nx" },
+	{ CPU_FEATURE_INVARIANT_TSC, "invariant-tsc" }
+};
+
+/**
+ * \brief Check whether the CPU has the CPUID instruction, by whether the ID flag can be changed.
+ * 
+ * \return Whether CPUID can be used.
+ */
+static bool cpu_has_cpuid(void) {
+	uint32_t before;
+	uint32_t after;
+	__asm__ __volatile__ (
+		"pushfd\n\t"
+		"pop %0\n\t"
+		"mov %1, %0\n\t"
+		"xor %1, 0x200000\n\t"
+		"push %1\n\t"
+		"popfd\n\t"
+		"pushfd\n\t"
+		"pop %1\n\t"
+		"push %0\n\t"
+		"popfd"
+		: "=&r" (before), "=&r" (after) : : "cc");
+	return (before ^ after) & 0x200000;
+}
+
+/**
+ * \brief Copy the registers of a CPUID leaf as a string.
+ * 
+ * \param [out] str Where to copy to.
+ * \param [in] regs The registers in the order of the string.
+ * \param [in] num_regs The number of registers.
+ */
+static void cpu_copy_string(char * str, const uint32_t * regs, uint32_t num_regs) {
+	for(uint32_t i = 0; i < num_regs * sizeof(uint32_t); i++) {
+		str[i] = (char) (regs[i / sizeof(uint32_t)] >> ((i % sizeof(uint32_t)) * 8));
+	}
+	str[num_regs * sizeof(uint32_t)] = '\0';
+}
+
+void cpu_features_init(void) {
+	if(!cpu_has_cpuid()) {
+		return;
+	}
+	
+	uint32_t regs[4];
+	cpu_cpuid(0, regs);
+	uint32_t max_leaf = regs[0];
+	
+	// The vendor is in EBX, EDX then ECX
+	uint32_t vendor[3] = { regs[1], regs[3], regs[2] };
+	cpu_copy_string(cpu_vendor, vendor, 3);
+	
+	if(max_leaf >= 1) {
+		cpu_cpuid(1, cpu_leaves[CPU_LEAF_BASIC]);
+		
+		uint32_t signature = cpu_leaves[CPU_LEAF_BASIC][CPU_EAX];
+		cpu_stepping = signature & 0xF;
+		cpu_model = (signature >> 4) & 0xF;
+		cpu_family = (signature >> 8) & 0xF;
+		if(cpu_family == 0xF) {
+			cpu_family += (signature >> 20) & 0xFF;
+		}
+		if(cpu_family >= 0x6) {
+			cpu_model |= ((signature >> 16) & 0xF) << 4;
+		}
+	}
+	
+	if(max_leaf >= 7) {
+		cpu_cpuid(7, cpu_leaves[CPU_LEAF_EXTENDED]);
+	}
+	
+	cpu_cpuid(0x80000000, regs);
+	uint32_t max_ext_leaf = regs[0];
+	
+	if(max_ext_leaf >= 0x80000001) {
+		cpu_cpuid(0x80000001, cpu_leaves[CPU_LEAF_AMD]);
+	}
+	
+	if(max_ext_leaf >= 0x80000004) {
+		uint32_t brand[12];
+		cpu_cpuid(0x80000002, &brand[0]);
+		cpu_cpuid(0x80000003, &brand[4]);
+		cpu_cpuid(0x80000004, &brand[8]);
+		cpu_copy_string(cpu_brand, brand, 12);
+	}
+	
+	if(max_ext_leaf >= 0x80000007) {
+		cpu_cpuid(0x80000007, cpu_leaves[CPU_LEAF_POWER]);
+	}
+}
+
+bool cpu_has(uint32_t feature) {
+	uint32_t leaf = feature >> 8;
+	uint32_t reg = (feature >> 5) & 0x3;
+	uint32_t bit = feature & 0x1F;
+	
+	return (cpu_leaves[leaf][reg] >> bit) & 1;
+}
+
+const char * cpu_get_vendor(void) {
+	return cpu_vendor;
+}
+
+const char * cpu_get_brand(void) {
+	// The brand is padded with leading spaces on some CPUs
+	const char * brand = cpu_brand;
+	while(*brand == ' ') {
+		brand++;
+	}
+	return brand;
+}
+
+void cpu_features_dump(void) {
+	kprintf("Vendor: %s\n", cpu_get_vendor());
+	kprintf("Brand: %s\n", cpu_get_brand());
+	kprintf("Family: 0x%X, model: 0x%X, stepping: %u\n", cpu_family, cpu_model, cpu_stepping);
+	
+	kprintf("Features:");
+	for(uint32_t i = 0; i < sizeof(cpu_feature_names) / sizeof(cpu_feature_names[0]); i++) {
+		if(cpu_has(cpu_feature_names[i].feature)) {
+			kprintf(" %s", cpu_feature_names[i].name);
+		}
+	}
+	kprintf("\n");
+}
@@ -0,0 +1,68 @@
+#include <delay.h>
+#include <clock.h>
+#include <pit.h>
+#include <cpu.h>
+#include <spinlock.h>
+
+#include <stdint.h>
+
+static spinlock_t delay_pit_lock;	/**< Keeps counter 2 of the PIT to one wait at a time. */
+
+/**
+ * \brief Spin on the TSC.
+ * 
+ * \param [in] cycles The number of TSC cycles to wait for.
+ */
+static void delay_tsc(uint64_t cycles) {
+	uint64_t start = cpu_rdtsc();
+	while(cpu_rdtsc() - start < cycles) {
+		cpu_pause();
+	}
+}
+
+/**
+ * \brief Poll counter 2 of the PIT, a count of at most \ref DELAY_PIT_MAX_COUNT at a time. Stops
+ * the speaker, which is driven by the same counter.
+ * 
+ * \param [in] counts The number of counts of the PIT to wait for.
+ */
+static void delay_pit(uint64_t counts) {
+	uint32_t flags = spin_lock_irqsave(&delay_pit_lock);
+	
+	while(counts) {
+		uint16_t count = counts > DELAY_PIT_MAX_COUNT ? DELAY_PIT_MAX_COUNT : (uint16_t) counts;
+		counts -= count;
+		
+		pit_counter_2_start(count);
+		while(!pit_counter_2_done()) {
+			cpu_pause();
+		}
+	}
+	
+	spin_unlock_irqrestore(&delay_pit_lock, flags);
+}
+
+/**
+ * \brief Wait for a time given as a fraction of a second.
+ * 
+ * \param [in] time The time.
+ * \param [in] per_sec The number of units of the time in a second.
+ */
+static void delay(uint32_t time, uint32_t per_sec) {
+	// Round up so the wait is never short
+	uint32_t tsc_khz = clock_get_tsc_khz();
+	if(tsc_khz) {
+		uint32_t per_ms = per_sec / 1000;
+		delay_tsc(cpu_div64((uint64_t) time * tsc_khz + per_ms - 1, per_ms));
+	} else {
+		delay_pit(cpu_div64((uint64_t) time * PIT_INPUT_FREQUENCY + per_sec - 1, per_sec));
+	}
+}
+
+void udelay(uint32_t microseconds) {
+	delay(microseconds, 1000000);
+}
+
+void ndelay(uint32_t nanoseconds) {
+	delay(nanoseconds, CLOCK_NS_PER_SEC);
+}
@@ -4,15 +4,22 @@
 #include <pic.h>
 #include <irq.h>
 #include <pit.h>
+#include <clockevent.h>
 #include <cmos.h>
+#include <interrupt.h>
+#include <timer.h>
+#include <wait.h>
+#include <delay.h>
 
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 
-static volatile bool floppy_irq_fired = false;	/**< Whether the floppy IRQ was called to determine when a command has finished. */
+static completion_t floppy_irq_done;			/**< Signaled by the floppy IRQ to determine when a command has finished. */
 static uint8_t current_drive = 0;				/**< The current drive. */
+static bool floppy_motor_running = false;		/**< Whether the motor of the current drive is on. */
+static timer_t floppy_motor_timer;				/**< The timer to turn the motor off after the last access. */
 
 /**
  * \brief The PIT handler that is called when the PIT creates an interrupt.
@@ -21,19 +28,15 @@ static uint8_t current_drive = 0;				/**< The current drive. */
  */
 static void floppy_handler(regs_t * regs) {
 	(void) regs;		// Not using the registers
-	floppy_irq_fired = true;
+	complete(&floppy_irq_done);
 }
 
 /**
- * \brief The function that waits until the floppy IRQ is called.
+ * \brief The function that waits until the floppy IRQ is called. The thread is blocked so other
+ * threads can run while the drive is busy.
  */
 static void floppy_wait_irq(void) {
-	while(!floppy_irq_fired) {
-		__asm__ __volatile__ ("sti");
-		__asm__ __volatile__ ("hlt");
-		__asm__ __volatile__ ("cli");
-	}
-	floppy_irq_fired = false;
+	wait_for_completion(&floppy_irq_done);
 }
 
 /**
@@ -85,6 +88,7 @@ static uint8_t floppy_read_status(void) {
  */
 static void floppy_write_dor(uint8_t val) {
 	out_port_byte(FLOPPY_DIGITAL_OUTPUT_REGISTER, val);
+	floppy_motor_running = (val & (FLOPPY_DOR_DRIVE_0_MOTOR | FLOPPY_DOR_DRIVE_1_MOTOR | FLOPPY_DOR_DRIVE_2_MOTOR | FLOPPY_DOR_DRIVE_3_MOTOR)) != 0;
 }
 
 /**
@@ -203,6 +207,7 @@ static void floppy_enable(void) {
 
 /**
  * \brief Turn on or off the current drive motor to spin the floppy read for reading or writing.
+ * Turning on cancels any pending turn off, and only waits for the motor to spin up if it was off.
  * 
  * \param [in] enable Whether to turn on or off the drive motor. 
  * 
@@ -213,6 +218,13 @@ static void floppy_motor(bool enable) {
 		return;
 	}
 	
+	if(enable) {
+		timer_cancel(&floppy_motor_timer);
+		if(floppy_motor_running) {
+			return;
+		}
+	}
+	
 	uint8_t motor = 0;
 	
 	switch(current_drive) {
@@ -232,11 +244,30 @@ static void floppy_motor(bool enable) {
 	
 	if(enable) {
 		floppy_write_dor(current_drive | motor | FLOPPY_DOR_RESET | FLOPPY_DOR_DMA);
+		
+		// Sleep for 300 millisecond for the motor to spin up
+		pit_wait(300);
 	} else {
 		floppy_write_dor(FLOPPY_DOR_RESET);
 	}
-	// Sleep for 300 millisecond
-	pit_wait(300);
+}
+
+/**
+ * \brief The timer callback that turns the motor off.
+ * 
+ * \param [in] arg Unused.
+ */
+static void floppy_motor_timeout(void * arg) {
+	(void) arg;
+	floppy_motor(false);
+}
+
+/**
+ * \brief Turn the motor off after \ref FLOPPY_MOTOR_OFF_DELAY, unless the drive is used again
+ * before then.
+ */
+static void floppy_motor_off_later(void) {
+	timer_add(&floppy_motor_timer, clockevent_get_ticks() + timer_ms_to_ticks(FLOPPY_MOTOR_OFF_DELAY), floppy_motor_timeout, NULL);
 }
 
 /**
@@ -267,12 +298,12 @@ static int floppy_calibrate(uint8_t drive) {
 		
 		// Are we back at cylinder 0, at the beginning
 		if(!cylinder) {
-			floppy_motor(false);
+			floppy_motor_off_later();
 			return 0;
 		}
 	}
 	
-	floppy_motor(false);
+	floppy_motor_off_later();
 	return -1;
 }
 
@@ -283,7 +314,9 @@ static void floppy_reset(void) {
 	uint8_t status_reg_0;
 	uint8_t cylinder;
 	
+	// Hold the controller in reset long enough for it to see it, without waiting a whole tick
 	floppy_disable();
+	udelay(FLOPPY_RESET_DELAY);
 	floppy_enable();
 	
 	floppy_wait_irq();
@@ -446,16 +479,20 @@ uint8_t * floppy_read_sector(uint32_t sector_lba) {
 	
 	floppy_motor(true);
 	if(floppy_seek(track, head) != 0) {
+		floppy_motor_off_later();
 		return NULL;
 	}
 	
 	floppy_read_sector_chs(head, track, sector);
-	floppy_motor(false);
+	floppy_motor_off_later();
 	
 	return (uint8_t *) FLOPPY_DMA_BUFFER;
 }
 
 void floppy_init(void) {
+	timer_init(&floppy_motor_timer);
+	completion_init(&floppy_irq_done);
+	
 	floppy_detect_drive();
 	
 	irq_install_handler(PIC_IRQ_DISKETTE_DRIVE, floppy_handler);
@@ -0,0 +1,260 @@
+#include <fpu.h>
+#include <thread.h>
+#include <percpu.h>
+#include <isr.h>
+#include <gdt.h>
+#include <work.h>
+#include <interrupt.h>
+#include <panic.h>
+#include <cpu_features.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+static bool has_fpu = false;		/**< Whether there is a FPU. */
+static bool has_fxsr = false;		/**< Whether FXSAVE and FXRSTOR can be used, else FNSAVE and FRSTOR. */
+static bool has_sse = false;		/**< Whether SSE is turned on. */
+static bool has_sse2 = false;		/**< Whether SSE2 is turned on. */
+
+/**
+ * \brief Read the CR0 control register.
+ * 
+ * \return The value of CR0.
+ */
+static inline uint32_t fpu_read_cr0(void) {
+	uint32_t cr0;
+	__asm__ __volatile__ ("mov %0, cr0" : "=r" (cr0));
+	return cr0;
+}
+
+/**
+ * \brief Write the CR0 control register.
+ * 
+ * \param [in] cr0 The new value of CR0.
+ */
+static inline void fpu_write_cr0(uint32_t cr0) {
+	__asm__ __volatile__ ("mov cr0, %0" : : "r" (cr0) : "memory");
+}
+
+/**
+ * \brief Clear CR0.TS, so the FPU can be used without raising \#NM.
+ */
+static inline void fpu_clts(void) {
+	__asm__ __volatile__ ("clts" : : : "memory");
+}
+
+/**
+ * \brief Set CR0.TS if it isn't already set, so the next FPU instruction raises \#NM.
+ */
+static inline void fpu_stts(void) {
+	uint32_t cr0 = fpu_read_cr0();
+	if(!(cr0 & FPU_CR0_TS)) {
+		fpu_write_cr0(cr0 | FPU_CR0_TS);
+	}
+}
+
+/**
+ * \brief Save the FPU and SSE registers. CR0.TS must be clear.
+ * 
+ * \param [out] state Where to save the registers, 16 byte aligned.
+ */
+static inline void fpu_save(uint8_t * state) {
+	if(has_fxsr) {
+		__asm__ __volatile__ ("fxsave [%0]" : : "r" (state) : "memory");
+	} else {
+		__asm__ __volatile__ ("fnsave [%0]" : : "r" (state) : "memory");
+	}
+}
+
+/**
+ * \brief Load the FPU and SSE registers. CR0.TS must be clear.
+ * 
+ * \param [in] state The saved registers, 16 byte aligned.
+ */
+static inline void fpu_restore(uint8_t * state) {
+	if(has_fxsr) {
+		__asm__ __volatile__ ("fxrstor [%0]" : : "r" (state) : "memory");
+	} else {
+		__asm__ __volatile__ ("frstor [%0]" : : "r" (state) : "memory");
+	}
+}
+
+/**
+ * \brief Get the thread the FPU is being used for in ring 0. The FPU state is only kept per thread
+ * for the kernel threads on the boot CPU, outside of IRQ handlers and deferred work. A process's
+ * registers go back to ring 3, so a system call mustn't use them.
+ * 
+ * \return The thread. NULL if not running as a kernel thread.
+ */
+static thread_t * fpu_context_thread(void) {
+	if(this_cpu_read(cpu_id) != 0 || this_cpu_read(irq_depth) != 0 || work_in_progress()) {
+		return NULL;
+	}
+	
+	thread_t * thread = thread_current();
+	if(thread->process) {
+		return NULL;
+	}
+	
+	return thread;
+}
+
+/**
+ * \brief Make a thread the owner of the FPU, saving the registers of the old owner and loading the
+ * thread's. Interrupts must be disabled.
+ * 
+ * \param [in] thread The new owner.
+ */
+static void fpu_load(thread_t * thread) {
+	fpu_clts();
+	
+	thread_t * owner = (thread_t *) this_cpu_read(fpu_owner);
+	if(owner == thread) {
+		return;
+	}
+	
+	if(owner) {
+		fpu_save(owner->fpu_state);
+	}
+	
+	// A thread's first use starts with clean registers
+	if(thread->fpu_used) {
+		fpu_restore(thread->fpu_state);
+	} else {
+		__asm__ __volatile__ ("fninit");
+		thread->fpu_used = true;
+	}
+	
+	this_cpu_write(fpu_owner, thread);
+	this_cpu_inc(fpu_loads);
+}
+
+/**
+ * \brief The device not available exception (\#NM) handler. A thread used the FPU for the first
+ * time since it was switched to, so load its registers.
+ * 
+ * \param [in] regs The registers of the thread.
+ */
+static void fpu_handler(regs_t * regs) {
+	// Ring 3 uses the FPU freely, and ring 0 only in kernel_fpu_begin() of a kernel thread
+	thread_t * thread = (regs->cs & 0x3) == GDT_PRIVILEGE_RING_3 ? thread_current() : fpu_context_thread();
+	if(!thread) {
+		panic("FPU used outside of kernel_fpu_begin() at 0x%08X\n", regs->eip);
+	}
+	
+	fpu_load(thread);
+}
+
+void fpu_init_cpu(void) {
+	if(!has_fpu) {
+		return;
+	}
+	
+	uint32_t cr0 = fpu_read_cr0();
+	cr0 &= ~(FPU_CR0_EM | FPU_CR0_TS);
+	cr0 |= FPU_CR0_MP | FPU_CR0_NE;
+	fpu_write_cr0(cr0);
+	
+	if(has_sse) {
+		uint32_t cr4;
+		__asm__ __volatile__ ("mov %0, cr4" : "=r" (cr4));
+		cr4 |= FPU_CR4_OSFXSR | FPU_CR4_OSXMMEXCPT;
+		__asm__ __volatile__ ("mov cr4, %0" : : "r" (cr4));
+	}
+	
+	__asm__ __volatile__ ("fninit");
+	
+	// No thread owns the registers yet
+	this_cpu_write(fpu_owner, NULL);
+	fpu_stts();
+}
+
+void fpu_init(void) {
+	has_fpu = cpu_has(CPU_FEATURE_FPU);
+	has_fxsr = cpu_has(CPU_FEATURE_FXSR);
+	has_sse = has_fxsr && cpu_has(CPU_FEATURE_SSE);
+	has_sse2 = has_sse && cpu_has(CPU_FEATURE_SSE2);
+	
+	if(!has_fpu) {
+		kprintf("FPU: None\n");
+		return;
+	}
+	
+	isr_install_handler(EXCEPTION_DEVICE_NOT_AVAILABLE, fpu_handler);
+	fpu_init_cpu();
+	
+	kprintf("FPU: %s%s%s\n", has_fxsr ? "FXSR " : "", has_sse ? "SSE " : "", has_sse2 ? "SSE2" : "");
+}
+
+bool fpu_present(void) {
+	return has_fpu;
+}
+
+bool fpu_has_sse2(void) {
+	return has_sse2;
+}
+
+void fpu_switch(thread_t * next) {
+	if(!has_fpu) {
+		return;
+	}
+	
+	// Only the owner's registers are loaded, any other thread loads its own on first use
+	if(next == (thread_t *) this_cpu_read(fpu_owner)) {
+		fpu_clts();
+	} else {
+		fpu_stts();
+	}
+}
+
+void fpu_thread_exit(thread_t * thread) {
+	if((thread_t *) this_cpu_read(fpu_owner) == thread) {
+		this_cpu_write(fpu_owner, NULL);
+	}
+}
+
+void kernel_fpu_begin(void) {
+	if(!has_fpu) {
+		return;
+	}
+	
+	uint32_t flags = interrupt_save();
+	
+	// A thread's registers are switched lazily, so the thread can still be preempted
+	thread_t * thread = fpu_context_thread();
+	if(thread && this_cpu_read(fpu_depth) == 0) {
+		fpu_load(thread);
+		interrupt_restore(flags);
+		return;
+	}
+	
+	// Nothing would save the registers if this was interrupted, so interrupts stay disabled
+	if(this_cpu_read(fpu_depth) == 0) {
+		this_cpu_write(fpu_flags, flags);
+		
+		thread_t * owner = (thread_t *) this_cpu_read(fpu_owner);
+		fpu_clts();
+		if(owner) {
+			// The owner loads its registers again on its next use
+			fpu_save(owner->fpu_state);
+			this_cpu_write(fpu_owner, NULL);
+		}
+		__asm__ __volatile__ ("fninit");
+	}
+	
+	this_cpu_inc(fpu_depth);
+}
+
+void kernel_fpu_end(void) {
+	if(!has_fpu || this_cpu_read(fpu_depth) == 0) {
+		return;
+	}
+	
+	this_cpu_dec(fpu_depth);
+	if(this_cpu_read(fpu_depth) == 0) {
+		fpu_stts();
+		interrupt_restore(this_cpu_read(fpu_flags));
+	}
+}
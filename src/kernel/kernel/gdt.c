@@ -89,6 +89,38 @@ static void tss_set_entry(void) {
 	gdt_entries[GDT_TSS_INDEX].is_limit_4K = false;
 }
 
+/**
+ * \brief Create a kernel data GDT entry with a base address and byte granular limit.
+ * 
+ * \param [in] index The index into the GDT table for the entry being created.
+ * \param [in] base The start of memory for the entry.
+ * \param [in] size The size of memory for the entry in bytes, up to 1MB.
+ */
+static void gdt_set_data_entry(size_t index, uint32_t base, uint32_t size) {
+	// Set up base address
+	gdt_entries[index].base_low = (base & 0xFFFFFF);
+	gdt_entries[index].base_high = (base >> 24) & 0xFF;
+	
+	// Set up limits
+	gdt_entries[index].limit_low = ((size - 1) & 0xFFFF);
+	gdt_entries[index].limit_high = ((size - 1) >> 16) & 0x0F;
+	
+	// Set up access bits
+	gdt_entries[index].accessed = false;
+	gdt_entries[index].writeable = true;
+	gdt_entries[index].direction_conforming = false;
+	gdt_entries[index].executable = false;
+	gdt_entries[index].descriptor_bit = true;
+	gdt_entries[index].privilege = GDT_PRIVILEGE_RING_0;
+	gdt_entries[index].present = true;
+	
+	// Set up flags
+	gdt_entries[index].reserved_zero = 0;
+	gdt_entries[index].is_64bits = false;
+	gdt_entries[index].is_32bits = true;
+	gdt_entries[index].is_limit_4K = false;
+}
+
 /**
  * \brief Set up the full GDT table with a kernel code and data segment, user code and data
  * segment, and the TSS.
@@ -107,6 +139,11 @@ static void gdt_setup(void) {
 	
 	// Set up TSS
 	tss_set_entry();
+	
+	// The per-CPU segments are set up as each CPU starts
+	for(size_t i = 0; i < GDT_PER_CPU_ENTRIES; i++) {
+		gdt_entries[GDT_PER_CPU_INDEX + i] = (gdt_entry_t) { };
+	}
 }
 
 /**
@@ -145,3 +182,16 @@ void gdt_init(void) {
 	// Load the TSS
 	ltr();
 }
+
+uint16_t gdt_set_per_cpu(uint32_t cpu, uint32_t base, uint32_t size) {
+	gdt_set_data_entry(GDT_PER_CPU_INDEX + cpu, base, size);
+	return (uint16_t) (GDT_PER_CPU_OFFSET + cpu * sizeof(gdt_entry_t));
+}
+
+void gdt_set_kernel_stack(uint32_t esp) {
+	tss.ESP0 = esp;
+}
+
+uint32_t gdt_get_kernel_stack_address(void) {
+	return (uint32_t) &tss.ESP0;
+}
@@ -0,0 +1,239 @@
+#include <hpet.h>
+#include <acpi.h>
+#include <clock.h>
+#include <clockevent.h>
+#include <cpu.h>
+#include <irq.h>
+#include <pic.h>
+#include <paging.h>
+#include <interrupt.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+static volatile uint32_t * hpet_regs = NULL;	/**< The HPET registers, identity mapped. */
+static uint32_t hpet_timer;						/**< The comparator used as the clock event device. */
+static uint32_t hpet_route;						/**< The comparator configuration bits that route it to IRQ 0. */
+static uint32_t hpet_period;					/**< The counts between the periodic interrupts. */
+static uint32_t hpet_oneshot_end;				/**< The low 32 bits of the main counter the one shot ends at. */
+static bool hpet_periodic;						/**< Whether the comparator is in periodic mode. */
+static bool hpet_armed;							/**< Whether the comparator is set. */
+
+/**
+ * \brief Read a 32 bit HPET register.
+ * 
+ * \param [in] reg The offset of the register.
+ * 
+ * \return The value of the register.
+ */
+static inline uint32_t hpet_read(uint32_t reg) {
+	return hpet_regs[reg / sizeof(uint32_t)];
+}
+
+/**
+ * \brief Write a 32 bit HPET register.
+ * 
+ * \param [in] reg The offset of the register.
+ * \param [in] value The value to write.
+ */
+static inline void hpet_write(uint32_t reg, uint32_t value) {
+	hpet_regs[reg / sizeof(uint32_t)] = value;
+}
+
+uint64_t hpet_read_counter(void) {
+	if(!hpet_regs) {
+		return 0;
+	}
+	
+	// The counter is read in two halves, so read again if the low half carried into the high half
+	uint32_t high;
+	uint32_t low;
+	do {
+		high = hpet_read(HPET_REG_COUNTER + 4);
+		low = hpet_read(HPET_REG_COUNTER);
+	} while(high != hpet_read(HPET_REG_COUNTER + 4));
+	
+	return ((uint64_t) high << 32) | low;
+}
+
+/**
+ * \brief Run the comparator periodically.
+ * 
+ * \param [in] count The number of counts between interrupts.
+ */
+static void hpet_set_periodic(uint32_t count) {
+	uint32_t config = HPET_TIMER_ENABLE | HPET_TIMER_PERIODIC | HPET_TIMER_VALUE_SET | HPET_TIMER_32_MODE | hpet_route;
+	hpet_write(HPET_REG_TIMER_CONFIG(hpet_timer), config);
+	
+	// The first write is when the first interrupt is, the second is the period
+	hpet_write(HPET_REG_TIMER_COMPARATOR(hpet_timer), hpet_read(HPET_REG_COUNTER) + count);
+	hpet_write(HPET_REG_TIMER_COMPARATOR(hpet_timer), count);
+	
+	hpet_period = count;
+	hpet_periodic = true;
+	hpet_armed = true;
+}
+
+/**
+ * \brief Interrupt once.
+ * 
+ * \param [in] count The number of counts until the interrupt. Is at least a tick, so the counter
+ * can't pass the comparator before it is written.
+ */
+static void hpet_set_oneshot(uint32_t count) {
+	hpet_write(HPET_REG_TIMER_CONFIG(hpet_timer), HPET_TIMER_ENABLE | HPET_TIMER_32_MODE | hpet_route);
+	
+	hpet_oneshot_end = hpet_read(HPET_REG_COUNTER) + count;
+	hpet_write(HPET_REG_TIMER_COMPARATOR(hpet_timer), hpet_oneshot_end);
+	
+	hpet_periodic = false;
+	hpet_armed = true;
+}
+
+/**
+ * \brief Get the counts until the comparator next interrupts.
+ * 
+ * \return The counts left. 0 if a one shot has passed.
+ */
+static uint32_t hpet_get_count(void) {
+	if(!hpet_armed) {
+		return 0;
+	}
+	
+	// In periodic mode the comparator moves on to the next interrupt when it matches
+	uint32_t end = hpet_periodic ? hpet_read(HPET_REG_TIMER_COMPARATOR(hpet_timer)) : hpet_oneshot_end;
+	int32_t left = (int32_t) (end - hpet_read(HPET_REG_COUNTER));
+	
+	if(left <= 0) {
+		return 0;
+	}
+	
+	if(hpet_periodic && (uint32_t) left > hpet_period) {
+		return hpet_period;
+	}
+	
+	return (uint32_t) left;
+}
+
+/**
+ * \brief Stop the comparator interrupting. The main counter keeps running for the clock.
+ */
+static void hpet_stop(void) {
+	hpet_write(HPET_REG_TIMER_CONFIG(hpet_timer), HPET_TIMER_32_MODE);
+	hpet_armed = false;
+}
+
+/**
+ * \brief A comparator as a clock event device. Is rated above the PIT, as it is programmed without
+ * port I/O, and below the local APIC timer, which doesn't go through the I/O APIC.
+ */
+static clockevent_t hpet_clockevent = {
+	"HPET",
+	CLOCKEVENT_ONESHOT,
+	150,
+	0,
+	0x7FFFFFFF,
+	hpet_set_periodic,
+	hpet_set_oneshot,
+	hpet_get_count,
+	hpet_stop,
+	NULL
+};
+
+/**
+ * \brief The main counter as a clock source. Is rated above a TSC that isn't invariant, as its rate
+ * is fixed, but reading it is an uncached read, so below an invariant TSC.
+ */
+static clock_source_t hpet_clock_source = {
+	"HPET",
+	200,
+	0,
+	hpet_read_counter
+};
+
+/**
+ * \brief Find a comparator that can be routed to the I/O APIC input of IRQ 0.
+ * 
+ * \param [in] timers The number of comparators.
+ * 
+ * \return Whether one was found, set in \ref hpet_timer and \ref hpet_route.
+ */
+static bool hpet_find_timer(uint32_t timers) {
+	if(!irq_has_ioapic()) {
+		return false;
+	}
+	
+	// The timer is usually overridden onto input 2
+	uint32_t gsi = PIC_IRQ_TIMER;
+	const acpi_irq_override_t * override = acpi_get_irq_override(PIC_IRQ_TIMER);
+	if(override) {
+		gsi = override->gsi;
+	}
+	
+	if(gsi >= 32) {
+		return false;
+	}
+	
+	for(uint32_t i = 0; i < timers; i++) {
+		// The high half has a bit for each input the comparator can be routed to
+		uint32_t routes = hpet_read(HPET_REG_TIMER_CONFIG(i) + 4);
+		if(routes & (1 << gsi)) {
+			hpet_timer = i;
+			hpet_route = gsi << HPET_TIMER_ROUTE_SHIFT;
+			
+			if(hpet_read(HPET_REG_TIMER_CONFIG(i)) & HPET_TIMER_PERIODIC_CAP) {
+				hpet_clockevent.features |= CLOCKEVENT_PERIODIC;
+			}
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+bool hpet_init(void) {
+	uint32_t address = acpi_get_hpet_address();
+	if(!address) {
+		return false;
+	}
+	
+	vmm_map_device(address);
+	hpet_regs = (volatile uint32_t *) address;
+	
+	uint32_t capabilities = hpet_read(HPET_REG_CAPABILITIES);
+	uint32_t period = hpet_read(HPET_REG_CAPABILITIES + 4);
+	if(period == 0 || period > HPET_MAX_PERIOD_FS) {
+		kprintf("HPET: Bad period %ufs\n", period);
+		hpet_regs = NULL;
+		return false;
+	}
+	
+	uint32_t timers = HPET_CAP_TIMERS(capabilities);
+	
+	// Nothing interrupts until a comparator is used as the tick
+	hpet_write(HPET_REG_CONFIG, hpet_read(HPET_REG_CONFIG) & ~(HPET_CONFIG_ENABLE | HPET_CONFIG_LEGACY));
+	for(uint32_t i = 0; i < timers; i++) {
+		hpet_write(HPET_REG_TIMER_CONFIG(i), hpet_read(HPET_REG_TIMER_CONFIG(i)) & ~(HPET_TIMER_ENABLE | HPET_TIMER_PERIODIC));
+	}
+	hpet_write(HPET_REG_CONFIG, hpet_read(HPET_REG_CONFIG) | HPET_CONFIG_ENABLE);
+	
+	// The period is in femtoseconds, so is at least 10MHz
+	uint32_t khz = cpu_div64_32(1000000000000ULL, period);
+	
+	kprintf("HPET: %u comparators at %ukHz%s\n", timers, khz, (capabilities & HPET_CAP_COUNT_64) ? ", 64 bit" : "");
+	
+	// A 32 bit counter wraps within minutes, so can't be a clock source
+	if(capabilities & HPET_CAP_COUNT_64) {
+		hpet_clock_source.khz = khz;
+		clock_register(&hpet_clock_source);
+	}
+	
+	if(hpet_find_timer(timers)) {
+		hpet_clockevent.frequency = (uint32_t) cpu_div64(1000000000000000ULL, period);
+		clockevent_register(&hpet_clockevent);
+	}
+	
+	return true;
+}
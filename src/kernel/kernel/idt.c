@@ -54,11 +54,20 @@ static void idt_load(void) {
 	lidt();
 }
 
+void idt_load_cpu(void) {
+	lidt();
+}
+
 void idt_open_interrupt_gate(uint8_t index, uint32_t base) {
 	// Open an interrupt gate
 	idt_set_entry(index, base, GDT_KERNEL_CODE_OFFSET, IDT_INTERRUPT_GATE, GDT_PRIVILEGE_RING_0, true);
 }
 
+void idt_open_user_gate(uint8_t index, uint32_t base) {
+	// Open an interrupt gate that ring 3 can use
+	idt_set_entry(index, base, GDT_KERNEL_CODE_OFFSET, IDT_INTERRUPT_GATE, GDT_PRIVILEGE_RING_3, true);
+}
+
 void idt_close_interrupt_gate(uint8_t index) {
 	// Close an interrupt gate
 	idt_set_entry(index, 0, 0, 0, 0, false);
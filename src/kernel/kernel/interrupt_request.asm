@@ -1,159 +1,102 @@
 	[bits	32]
 	section	.text
 
+	[extern	_irq_handler]
+	[extern	_irq_bench_handler]
+
 ;
-; Interrupt Requests
+; Interrupt requests. Each IRQ has its own entry with its IRQ number baked in, so the handler is
+; called directly with no jump to a common stub and no table lookup. The gates are interrupt
+; gates, so interrupts are already off.
+;
+; The kernel never changes its data segments, so an IRQ that interrupted ring 0 only saves them
+; for regs_t and doesn't load them. Loading and popping a segment register reads its descriptor,
+; so is the slow part. Ring 3 runs with GS null, so an IRQ from ring 3 loads the boot CPU's
+; per-CPU segment into GS, as only the boot CPU runs user threads.
+;
+; The TSC is read as soon as the general registers are saved, and passed to the handler as the
+; time of the entry.
 ;
 
-; 32: irq00
-global _irq00
-_irq00:
-	cli
-	push	byte 0
-	push	byte 32
-	jmp		irq_common_stub
-
-; 33: irq01
-global _irq01
-_irq01:
-	cli
-	push	byte 0
-	push	byte 33
-	jmp		irq_common_stub
-
-; 34: irq02
-global _irq02
-_irq02:
-	cli
-	push	byte 0
-	push	byte 34
-	jmp		irq_common_stub
-
-; 35: irq03
-global _irq03
-_irq03:
-	cli
-	push	byte 0
-	push	byte 35
-	jmp		irq_common_stub
-	
-; 36: irq04
-global _irq04
-_irq04:
-	cli
-	push	byte 0
-	push	byte 36
-	jmp		irq_common_stub
-
-; 37: irq05
-global _irq05
-_irq05:
-	cli
-	push	byte 0
-	push	byte 37
-	jmp		irq_common_stub
-	
-; 38: irq06
-global _irq06
-_irq06:
-	cli
-	push	byte 0
-	push	byte 38
-	jmp		irq_common_stub
-
-; 39: irq07
-global _irq07
-_irq07:
-	cli
-	push	byte 0
-	push	byte 39
-	jmp		irq_common_stub
-	
-; 40: irq08
-global _irq08
-_irq08:
-	cli
-	push	byte 0
-	push	byte 40
-	jmp		irq_common_stub
-
-; 41: irq09
-global _irq09
-_irq09:
-	cli
-	push	byte 0
-	push	byte 41
-	jmp		irq_common_stub
-	
-; 42: irq10
-global _irq10
-_irq10:
-	cli
-	push	byte 0
-	push	byte 42
-	jmp		irq_common_stub
-
-; 43: irq11
-global _irq11
-_irq11:
-	cli
-	push	byte 0
-	push	byte 43
-	jmp		irq_common_stub
-	
-; 44: irq12
-global _irq12
-_irq12:
-	cli
-	push	byte 0
-	push	byte 44
-	jmp		irq_common_stub
-
-; 45: irq13
-global _irq13
-_irq13:
-	cli
-	push	byte 0
-	push	byte 45
-	jmp		irq_common_stub
-	
-; 46: irq14
-global _irq14
-_irq14:
-	cli
-	push	byte 0
-	push	byte 46
-	jmp		irq_common_stub
+; The number of IRQs, IRQ_TOTAL
+%define IRQ_COUNT		16
 
-; 47: irq15
-global _irq15
-_irq15:
-	cli
-	push	byte 0
-	push	byte 47
-	jmp		irq_common_stub
+; The offset of the CS the CPU pushed once the IRQ number, error code and general registers are
+; pushed
+%define IRQ_CS_OFFSET	44
 
-extern _irq_handler
-irq_common_stub:
+; The entry of an IRQ.
+; %1: The IRQ number, pushed to the handler.
+; %2: The C handler, void handler(uint32_t irq_num, regs_t * regs, uint64_t entry).
+%macro IRQ_STUB 2
+	push	byte 0					; No error code
+	push	byte 32 + %1			; The interrupt number on the PIC
 	pusha
+	rdtsc							; The entry time, kept in EDI:ESI as they are saved
+	mov		esi, eax
+	mov		edi, edx
 	push	ds
 	push	es
 	push	fs
 	push	gs
-	mov		ax, 0x10
+	test	byte [esp + IRQ_CS_OFFSET + 16], 3
+	jnz		%%from_user
+
+	mov		eax, esp
+	push	edi						; entry
+	push	esi
+	push	eax						; regs
+	push	dword %1				; irq_num
+	call	%2
+	add		esp, 16 + 16			; The arguments and the segments, which are still loaded
+	popa
+	add		esp, 8					; The IRQ number and error code
+	iret
+
+%%from_user:
+	mov		ax, 0x10				; The kernel data segment
 	mov		ds, ax
 	mov		es, ax
 	mov		fs, ax
+	mov		ax, 0x30				; The boot CPU's per-CPU segment
 	mov		gs, ax
+
 	mov		eax, esp
-	push	eax
-	mov		eax, _irq_handler
-	call	eax
-	pop		eax
+	push	edi						; entry
+	push	esi
+	push	eax						; regs
+	push	dword %1				; irq_num
+	call	%2
+	add		esp, 16
 	pop		gs
 	pop		fs
 	pop		es
 	pop		ds
 	popa
-	add		esp, 8
+	add		esp, 8					; The IRQ number and error code
 	iret
+%endmacro
+
+; 32 - 47 on the PIC, or the I/O APIC vectors: irq_stub_0 - irq_stub_15
+%assign i 0
+%rep IRQ_COUNT
+irq_stub_%+i:
+	IRQ_STUB i, _irq_handler
+%assign i i + 1
+%endrep
+
+; IRQ_BENCH_VECTOR: The same entry and exit as an IRQ, with a handler that does nothing
+global _irq_bench
+_irq_bench:
+	IRQ_STUB 0, _irq_bench_handler
+
+	section	.rodata
+
+; The entry of each IRQ, so they can be put at any vector
+global irq_stub_table
+irq_stub_table:
+%assign i 0
+%rep IRQ_COUNT
+	dd		irq_stub_%+i
+%assign i i + 1
+%endrep
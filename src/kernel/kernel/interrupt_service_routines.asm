@@ -1,274 +1,98 @@
 	[bits	32]
 	section	.text
 
+	[extern	_fault_handler]
+
 ;
-; Interrupt service routines
+; Interrupt service routines. Exceptions are rare, so share a common stub. The gates are interrupt
+; gates, so interrupts are already off. The TSC is read as soon as the general registers are saved,
+; and passed to the handler as the time of the entry.
 ;
 
-; 0: Divide By Zero Exception.
-global _isr00
-_isr00:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 0 ; Exception number.
-	jmp		isr_common_stub
-
-; 1: Debug Exception.
-global _isr01
-_isr01:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 1 ; Exception number.
-	jmp		isr_common_stub
-
-; 2: Non Maskable Interrupt Exception.
-global _isr02
-_isr02:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 2 ; Exception number.
-	jmp		isr_common_stub
-
-; 3: Breakpoint Exception.
-global _isr03
-_isr03:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 3 ; Exception number.
-	jmp		isr_common_stub
-
-; 4: Overflow Exception.
-global _isr04
-_isr04:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 4 ; Exception number.
-	jmp		isr_common_stub
-
-; 5: Bound Range Exceeded Exception.
-global _isr05
-_isr05:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 5 ; Exception number.
-	jmp		isr_common_stub
-
-; 6: Invalid Opcode Exception.
-global _isr06
-_isr06:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 6 ; Exception number.
-	jmp		isr_common_stub
-
-; 7: Device Not Available Exception.
-global _isr07
-_isr07:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 7 ; Exception number.
-	jmp		isr_common_stub
+; The number of exceptions, ISR_TOTAL
+%define ISR_COUNT		32
+
+; The offset of the CS the CPU pushed once the exception number, error code, general registers and
+; segments are pushed
+%define ISR_CS_OFFSET	60
+
+; The entry of an exception.
+; %1: The exception number.
+%macro ISR_STUB 1
+	; Double fault, invalid TSS, segment not present, stack fault, general protection, page fault,
+	; alignment check, control protection, VMM communication and security exceptions have an error
+	; code pushed by the CPU
+%if %1 == 8 || (%1 >= 10 && %1 <= 14) || %1 == 17 || %1 == 21 || %1 == 29 || %1 == 30
+	; The CPU has pushed the error code
+%else
+	push	byte 0					; No error code
+%endif
+	push	byte %1					; The exception number
+	jmp		isr_common_stub
+%endmacro
+
+; 0 - 31: isr_stub_0 - isr_stub_31
+%assign i 0
+%rep ISR_COUNT
+isr_stub_%+i:
+	ISR_STUB i
+%assign i i + 1
+%endrep
 
-; 8: Double Fault Exception.
-global _isr08
-_isr08:
-	cli
-	push	byte 8 ; Exception number. Error code is pushed by system.
-	jmp		isr_common_stub
-
-;  9: Coprocessor Segment Overrun (unused in modern processors).
-global _isr09
-_isr09:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 9 ; Exception number.
-	jmp		isr_common_stub
-
-; 10: Invalid TSS Exception.
-global _isr10
-_isr10:
-	cli
-	push	byte 10 ; Exception number. Error code is pushed by system.
-	jmp		isr_common_stub
-
-; 11: Segment Not Present.
-global _isr11
-_isr11:
-	cli
-	push	byte 11 ; Exception number. Error code is pushed by system.
-	jmp		isr_common_stub
-
-; 12: Stack Fault Exception.
-global _isr12
-_isr12:
-	cli
-	push	byte 12 ; Exception number. Error code is pushed by system.
-	jmp		isr_common_stub
-
-; 13: General Protection Exception.
-global _isr13
-_isr13:
-	cli
-	push	byte 13 ; Exception number. Error code is pushed by system.
-	jmp		isr_common_stub
-
-; 14: Page Fault Exception.
-global _isr14
-_isr14:
-	cli
-	push	byte 14 ; Exception number. Error code is pushed by system.
-	jmp		isr_common_stub
-
-; 15: Unknown Interrupt Exception
-global _isr15
-_isr15:
-	cli
-	push	byte 0
-	push	byte 15
-	jmp		isr_common_stub
-
-; 16: x87 FPU Floating Point Error.
-global _isr16
-_isr16:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 16 ; Exception number.
-	jmp		isr_common_stub
-
-; 17: Alignment Check Exception.
-global _isr17
-_isr17:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 17 ; Exception number.
-	jmp		isr_common_stub
-
-; 18: Machine Check Exception.
-global _isr18
-_isr18:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 18 ; Exception number.
-	jmp		isr_common_stub
-
-; 19: SIMD Floating Point Exception.
-global _isr19
-_isr19:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 19 ; Exception number.
-	jmp		isr_common_stub
-
-; 20: Virtualization Exception.
-global _isr20
-_isr20:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 20 ; Exception number.
-	jmp		isr_common_stub
-
-global _isr21
-_isr21:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 21 ; Exception number.
-	jmp		isr_common_stub
-	
-global _isr22
-_isr22:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 22 ; Exception number.
-	jmp		isr_common_stub
-	
-global _isr23
-_isr23:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 23 ; Exception number.
-	jmp		isr_common_stub
-	
-global _isr24
-_isr24:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 24 ; Exception number.
-	jmp		isr_common_stub
-	
-global _isr25
-_isr25:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 25 ; Exception number.
-	jmp		isr_common_stub
-	
-global _isr26
-_isr26:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 26 ; Exception number.
-	jmp		isr_common_stub
-	
-global _isr27
-_isr27:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 27 ; Exception number.
-	jmp		isr_common_stub
-	
-global _isr28
-_isr28:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 28 ; Exception number.
-	jmp		isr_common_stub
-	
-global _isr29
-_isr29:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 29 ; Exception number.
-	jmp		isr_common_stub
-	
-global _isr30
-_isr30:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 30 ; Exception number.
-	jmp		isr_common_stub
-	
-global _isr31
-_isr31:
-	cli
-	push	byte 0 ; No error code.
-	push	byte 31 ; Exception number.
-	jmp		isr_common_stub
-
-extern _fault_handler
 isr_common_stub:
 	pusha
+	rdtsc						; The entry time, kept in EDI:ESI as they are saved
+	mov		esi, eax
+	mov		edi, edx
 	push	ds
 	push	es
 	push	fs
 	push	gs
-	
+
+	; The kernel never changes its data segments, so only load them from ring 3. Ring 3 runs with
+	; GS null, so load the boot CPU's per-CPU segment as only the boot CPU runs user threads
+	test	byte [esp + ISR_CS_OFFSET], 3
+	jz		.from_kernel
 	mov		ax, 0x10			; Load the Kernel Data Segment descriptor
 	mov		ds, ax
 	mov		es, ax
 	mov		fs, ax
+	mov		ax, 0x30
 	mov		gs, ax
-	
-	mov		eax, esp			; Push the stack
+.from_kernel:
+
+	mov		eax, esp			; Push the stack and the entry time
+	push	edi
+	push	esi
 	push	eax
-	
+
 	call	_fault_handler		; Call C exception handler
-	pop		eax
-	
+	add		esp, 12
+
+	; The handler can change the return CS, so check again
+	test	byte [esp + ISR_CS_OFFSET], 3
+	jz		.to_kernel
 	pop		gs
 	pop		fs
 	pop		es
 	pop		ds
 	popa
-	
 	add		esp, 8				; Cleans up the pushed error code and pushed ISR number
-	iret						; pops 5 things at once: CS, EIP, EFLAGS, SS, and ESP!
\ No newline at end of file
+	iret
+
+.to_kernel:
+	add		esp, 16				; The segments, which are still loaded
+	popa
+	add		esp, 8				; Cleans up the pushed error code and pushed ISR number
+	iret
+
+	section	.rodata
+
+; The entry of each exception
+global isr_stub_table
+isr_stub_table:
+%assign i 0
+%rep ISR_COUNT
+	dd		isr_stub_%+i
+%assign i i + 1
+%endrep
@@ -0,0 +1,197 @@
+#include <ioapic.h>
+#include <acpi.h>
+#include <lapic.h>
+#include <paging.h>
+#include <irq.h>
+#include <interrupt.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * \struct ioapic_route_t
+ * 
+ * \brief Where an ISA IRQ is wired to.
+ */
+typedef struct {
+	volatile uint32_t * regs;		/**< The registers of the I/O APIC. NULL if the IRQ isn't wired. */
+	uint8_t pin;					/**< The input of the I/O APIC. */
+	uint32_t entry;					/**< The low half of the redirection entry without the mask bit. */
+} ioapic_route_t;
+
+static volatile uint32_t * ioapic_regs[ACPI_MAX_IOAPICS];	/**< The registers of each I/O APIC, identity mapped. */
+static uint32_t ioapic_entries[ACPI_MAX_IOAPICS];			/**< The number of inputs of each I/O APIC. */
+static ioapic_route_t ioapic_routes[IRQ_TOTAL];				/**< The route of each ISA IRQ. */
+
+/**
+ * \brief The priority class of each ISA IRQ, the top 4 bits of its vector.
+ */
+static const uint8_t ioapic_priorities[IRQ_TOTAL] = {
+	IOAPIC_PRIORITY_TIMER,		// PIT
+	IOAPIC_PRIORITY_INPUT,		// Keyboard
+	IOAPIC_PRIORITY_DEVICE,		// Cascade, never raised
+	IOAPIC_PRIORITY_DEVICE,
+	IOAPIC_PRIORITY_DEVICE,
+	IOAPIC_PRIORITY_DEVICE,
+	IOAPIC_PRIORITY_DEVICE,		// Floppy
+	IOAPIC_PRIORITY_DEVICE,
+	IOAPIC_PRIORITY_INPUT,		// RTC
+	IOAPIC_PRIORITY_DEVICE,
+	IOAPIC_PRIORITY_DEVICE,
+	IOAPIC_PRIORITY_DEVICE,
+	IOAPIC_PRIORITY_DEVICE,
+	IOAPIC_PRIORITY_DEVICE,
+	IOAPIC_PRIORITY_DEVICE,
+	IOAPIC_PRIORITY_DEVICE
+};
+
+/**
+ * \brief Read an I/O APIC register.
+ * 
+ * \param [in] regs The registers of the I/O APIC.
+ * \param [in] reg The register to read.
+ * 
+ * \return The value of the register.
+ */
+static inline uint32_t ioapic_read(volatile uint32_t * regs, uint32_t reg) {
+	regs[IOAPIC_REG_SELECT / sizeof(uint32_t)] = reg;
+	return regs[IOAPIC_REG_WINDOW / sizeof(uint32_t)];
+}
+
+/**
+ * \brief Write an I/O APIC register. Interrupts must be disabled, as the select and the write are
+ * two accesses.
+ * 
+ * \param [in] regs The registers of the I/O APIC.
+ * \param [in] reg The register to write.
+ * \param [in] value The value to write.
+ */
+static inline void ioapic_write(volatile uint32_t * regs, uint32_t reg, uint32_t value) {
+	regs[IOAPIC_REG_SELECT / sizeof(uint32_t)] = reg;
+	regs[IOAPIC_REG_WINDOW / sizeof(uint32_t)] = value;
+}
+
+/**
+ * \brief Find the I/O APIC with an input wired to a global system interrupt.
+ * 
+ * \param [in] gsi The global system interrupt.
+ * \param [out] pin The input of the I/O APIC.
+ * 
+ * \return The index of the I/O APIC. -1 if none has the interrupt.
+ */
+static int32_t ioapic_find(uint32_t gsi, uint8_t * pin) {
+	for(uint32_t i = 0; i < acpi_get_ioapic_count() && i < ACPI_MAX_IOAPICS; i++) {
+		uint32_t base = acpi_get_ioapic(i)->gsi_base;
+		if(gsi >= base && gsi < base + ioapic_entries[i]) {
+			*pin = (uint8_t) (gsi - base);
+			return (int32_t) i;
+		}
+	}
+	
+	return -1;
+}
+
+bool ioapic_init(void) {
+	// The local APIC is only mapped by smp_init if there are these
+	uint32_t count = acpi_get_ioapic_count();
+	if(count == 0 || acpi_get_cpu_count() == 0 || !acpi_get_lapic_address()) {
+		return false;
+	}
+	
+	if(count > ACPI_MAX_IOAPICS) {
+		count = ACPI_MAX_IOAPICS;
+	}
+	
+	uint32_t flags = interrupt_save();
+	
+	for(uint32_t i = 0; i < count; i++) {
+		uint32_t address = acpi_get_ioapic(i)->address;
+		vmm_map_device(address);
+		ioapic_regs[i] = (volatile uint32_t *) address;
+		ioapic_entries[i] = ((ioapic_read(ioapic_regs[i], IOAPIC_VERSION) >> 16) & 0xFF) + 1;
+		
+		// Nothing is delivered until an IRQ is unmasked
+		for(uint32_t pin = 0; pin < ioapic_entries[i]; pin++) {
+			ioapic_write(ioapic_regs[i], IOAPIC_REDIRECTION + pin * 2, IOAPIC_MASKED);
+		}
+	}
+	
+	uint32_t destination = (uint32_t) lapic_get_id() << 24;
+	
+	for(uint8_t irq = 0; irq < IRQ_TOTAL; irq++) {
+		ioapic_routes[irq].regs = NULL;
+		
+		// The cascade isn't a real IRQ, and the timer is often overridden onto its input
+		if(irq == 2) {
+			continue;
+		}
+		
+		// ISA IRQs are edge triggered active high unless overridden
+		uint32_t gsi = irq;
+		uint32_t entry = ioapic_get_vector(irq);
+		const acpi_irq_override_t * override = acpi_get_irq_override(irq);
+		if(override) {
+			gsi = override->gsi;
+			if((override->flags & 0x3) == 0x3) {
+				entry |= IOAPIC_ACTIVE_LOW;
+			}
+			if(((override->flags >> 2) & 0x3) == 0x3) {
+				entry |= IOAPIC_LEVEL;
+			}
+		}
+		
+		uint8_t pin;
+		int32_t index = ioapic_find(gsi, &pin);
+		if(index < 0) {
+			continue;
+		}
+		
+		ioapic_routes[irq].regs = ioapic_regs[index];
+		ioapic_routes[irq].pin = pin;
+		ioapic_routes[irq].entry = entry;
+		
+		ioapic_write(ioapic_regs[index], IOAPIC_REDIRECTION + pin * 2 + 1, destination);
+		ioapic_write(ioapic_regs[index], IOAPIC_REDIRECTION + pin * 2, entry | IOAPIC_MASKED);
+	}
+	
+	interrupt_restore(flags);
+	
+	return true;
+}
+
+uint8_t ioapic_get_vector(uint8_t irq) {
+	// The IRQ number is the bottom 4 bits, so each vector is different
+	return (uint8_t) ((ioapic_priorities[irq] << 4) | irq);
+}
+
+void ioapic_set_mask(uint8_t irq) {
+	ioapic_route_t * route = &ioapic_routes[irq];
+	if(!route->regs) {
+		return;
+	}
+	
+	uint32_t flags = interrupt_save();
+	ioapic_write(route->regs, IOAPIC_REDIRECTION + route->pin * 2, route->entry | IOAPIC_MASKED);
+	interrupt_restore(flags);
+}
+
+void ioapic_clear_mask(uint8_t irq) {
+	ioapic_route_t * route = &ioapic_routes[irq];
+	if(!route->regs) {
+		return;
+	}
+	
+	uint32_t flags = interrupt_save();
+	ioapic_write(route->regs, IOAPIC_REDIRECTION + route->pin * 2, route->entry);
+	interrupt_restore(flags);
+}
+
+bool ioapic_is_level(uint8_t irq) {
+	return (ioapic_routes[irq].entry & IOAPIC_LEVEL) != 0;
+}
+
+void ioapic_send_end_of_interrupt(uint8_t irq) {
+	(void) irq;
+	lapic_send_eoi();
+}
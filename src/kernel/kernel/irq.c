@@ -1,24 +1,61 @@
 #include <irq.h>
-#include <portio.h>
 #include <idt.h>
 #include <pic.h>
+#include <ioapic.h>
+#include <cpu.h>
+#include <interrupt.h>
+#include <thread.h>
+#include <clockevent.h>
+#include <clock.h>
+#include <work.h>
+#include <percpu.h>
+#include <irqstat.h>
+#include <isr.h>
 
-extern void _irq00();
-extern void _irq01();
-extern void _irq02();
-extern void _irq03();
-extern void _irq04();
-extern void _irq05();
-extern void _irq06();
-extern void _irq07();
-extern void _irq08();
-extern void _irq09();
-extern void _irq10();
-extern void _irq11();
-extern void _irq12();
-extern void _irq13();
-extern void _irq14();
-extern void _irq15();
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * \brief The entry of each IRQ, generated in interrupt_request.asm. Each passes its own IRQ number
+ * to \ref _irq_handler, so can be put at any vector.
+ */
+extern const uint32_t irq_stub_table[IRQ_TOTAL];
+
+/**
+ * \brief The entry for \ref IRQ_BENCH_VECTOR, the same as an IRQ's but calls
+ * \ref _irq_bench_handler.
+ */
+extern void _irq_bench();
+
+/**
+ * \brief The 8259 PIC, used until the I/O APIC is set up or if there isn't one.
+ */
+static const irq_chip_t irq_chip_pic = {
+	"8259 PIC",
+	pic_send_end_of_interrupt,
+	pic_set_mask,
+	pic_clear_mask,
+	pic_is_level
+};
+
+/**
+ * \brief The I/O APIC, acknowledged through the local APIC.
+ */
+static const irq_chip_t irq_chip_ioapic = {
+	"I/O APIC",
+	ioapic_send_end_of_interrupt,
+	ioapic_set_mask,
+	ioapic_clear_mask,
+	ioapic_is_level
+};
+
+static const irq_chip_t * irq_chip = &irq_chip_pic;		/**< The interrupt controller the IRQs come from. */
+static uint64_t irq_handler_cycles[IRQ_TOTAL];			/**< The cycles spent in the handler of each IRQ. */
+static uint64_t irq_eoi_cycles[IRQ_TOTAL];				/**< The cycles spent acknowledging each IRQ. */
+static uint16_t irq_disabled = 0;						/**< The IRQs disabled by \ref irq_set_mask, bit n for IRQ n. */
+static uint16_t irq_masked = 0;							/**< The disabled IRQs that fired so were masked off on the interrupt controller. */
+static uint16_t irq_pending = 0;						/**< The disabled edge triggered IRQs that fired and are replayed when enabled. */
 
 /**
  * \brief The list of handlers for each IRQ.
@@ -36,18 +73,63 @@ void irq_uninstall_handler(int irq_num) {
 	irq_handlers[irq_num] = 0;
 }
 
+/**
+ * \brief Run the handler of a disabled IRQ that fired, now it is enabled. Isn't timed as it has no
+ * entry. Unlike an IRQ exit, the deferred work isn't run and the thread isn't switched, as the
+ * caller can be in a section with interrupts disabled or a lock held. Both are left to the next IRQ
+ * exit. Interrupts must be disabled.
+ * 
+ * \param [in] irq_num The IRQ number.
+ */
+static void irq_replay(uint8_t irq_num) {
+	this_cpu_inc(irq_counts[irq_num]);
+	this_cpu_inc(irq_depth);
+	
+	// No handler reads the registers, and there are none as nothing was interrupted
+	irq_handler handler = irq_handlers[irq_num];
+	if(handler) {
+		handler(NULL);
+	}
+	
+	this_cpu_dec(irq_depth);
+}
+
 /**
  * \brief Each of the IRQ ISR's point to this function, rather than the 'fault_handler' in 'isr.c'.
  * The IRQ Controllers need to be told when you are done servicing them, so you need to send them
  * an "End of Interrupt" command (0x20).
  * 
+ * \param [in] irq_num The IRQ number, baked into the entry of the IRQ.
  * \param [in] regs The registers when this is called.
+ * \param [in] entry The TSC at the entry of the IRQ.
  */
-void _irq_handler(regs_t * regs) {
-	uint8_t irq_num = regs->int_num - 32;
+void _irq_handler(uint32_t irq_num, regs_t * regs, uint64_t entry) {
+	// Interrupts were enabled in the interrupted code, so no section with them disabled is open
+	irqstat_irq_entry();
+	
+	// The counts and depth are per-CPU, so are updated without a lock
+	this_cpu_inc(irq_counts[irq_num]);
+	this_cpu_inc(irq_depth);
+	
+	// If woken from idle, start the periodic tick again before any handler reads the ticks
+	clockevent_idle_exit();
+	
+	// The IRQ was disabled, so mask it off now so it doesn't fire again. A missed edge isn't raised
+	// again so is replayed when enabled, a level IRQ fires again on unmasking if still raised
+	if(irq_disabled & (1 << irq_num)) {
+		irq_chip->mask(irq_num);
+		irq_masked |= (uint16_t) (1 << irq_num);
+		if(!irq_chip->is_level((uint8_t) irq_num)) {
+			irq_pending |= (uint16_t) (1 << irq_num);
+		}
+		irq_chip->eoi(irq_num);
+		this_cpu_dec(irq_depth);
+		return;
+	}
 	
 	// Get the handler
 	irq_handler handler = irq_handlers[irq_num];
+	uint64_t start = cpu_rdtsc();
 	
 	// Run the handler if got one
 	if (handler) {
@@ -55,58 +137,231 @@ void _irq_handler(regs_t * regs) {
 	}
 	
 	// Send the end of interrupt command
-	pic_send_end_of_interrupt(irq_num);
+	uint64_t eoi = cpu_rdtsc();
+	irq_chip->eoi(irq_num);
+	
+	// IRQs are only taken on the boot CPU, and each IRQ is masked until acknowledged, so the sums
+	// are only added to by one IRQ at a time
+	irq_handler_cycles[irq_num] += eoi - start;
+	irq_eoi_cycles[irq_num] += cpu_rdtsc() - eoi;
+	irqstat_record(ISR_TOTAL + irq_num, entry, start, eoi);
+	
+	// Leave the work and any thread switch to whatever was running the work this IRQ interrupted
+	// The depth is more than 1 when an IRQ is taken while running the deferred work of another
+	if(this_cpu_read(irq_depth) > 1 || work_in_progress()) {
+		this_cpu_dec(irq_depth);
+		return;
+	}
+	
+	// Run the work the handlers deferred, now other IRQs can be taken
+	work_run();
+	this_cpu_dec(irq_depth);
+	
+	// Switch thread if the time slice ran out or a thread was woken. Done after the end of
+	// interrupt so the next thread doesn't run with this IRQ unacknowledged
+	thread_preempt();
 }
 
-void irq_set_mask(uint8_t irq_num) {
-	uint16_t port;
-	uint8_t value;
+uint32_t irq_get_count(uint8_t irq_num) {
+	if(irq_num >= IRQ_TOTAL) {
+		return 0;
+	}
+	
+	// Add up the counts of all the CPUs
+	uint32_t count = 0;
+	for(uint32_t cpu = 0; cpu < PERCPU_MAX_CPUS; cpu++) {
+		count += percpu_get(cpu)->irq_counts[irq_num];
+	}
+	
+	return count;
+}
+
+/**
+ * \brief Get the average of a sum of cycles over the number of times an IRQ was raised.
+ * 
+ * \param [in] cycles The sum of cycles of each IRQ.
+ * \param [in] irq_num The IRQ number.
+ * 
+ * \return The average number of cycles. 0 if the IRQ was never raised.
+ */
+static uint32_t irq_average_cycles(const uint64_t * cycles, uint8_t irq_num) {
+	if(irq_num >= IRQ_TOTAL) {
+		return 0;
+	}
+	
+	uint32_t count = irq_get_count(irq_num);
+	if(!count) {
+		return 0;
+	}
 	
-	if(irq_num < 8) {
-		port = PIC_INTERRUPT_MASK_REG_MASTER;
-	} else {
-		port = PIC_INTERRUPT_MASK_REG_SLAVE;
-		irq_num -= 8;
+	return cpu_div64_32(cycles[irq_num], count);
+}
+
+uint32_t irq_get_handler_cycles(uint8_t irq_num) {
+	return irq_average_cycles(irq_handler_cycles, irq_num);
+}
+
+uint32_t irq_get_eoi_cycles(uint8_t irq_num) {
+	return irq_average_cycles(irq_eoi_cycles, irq_num);
+}
+
+/**
+ * \brief The handler of \ref IRQ_BENCH_VECTOR, which does nothing so only the entry and exit are
+ * timed.
+ * 
+ * \param [in] irq_num Unused.
+ * \param [in] regs Unused.
+ * \param [in] entry Unused.
+ */
+void _irq_bench_handler(uint32_t irq_num, regs_t * regs, uint64_t entry) {
+	(void) irq_num;
+	(void) regs;
+	(void) entry;
+}
+
+uint32_t irq_bench(void) {
+	uint64_t start = cpu_rdtsc();
+	for(uint32_t i = 0; i < IRQ_BENCH_ROUNDS; i++) {
+		__asm__ __volatile__ ("int %0" : : "i" (IRQ_BENCH_VECTOR) : "memory");
 	}
+	return cpu_div64_32(cpu_rdtsc() - start, IRQ_BENCH_ROUNDS);
+}
+
+uint32_t irq_round_trip(uint8_t irq_num) {
+	uint32_t tsc_khz = clock_get_tsc_khz();
+	if(irq_num >= IRQ_TOTAL || !tsc_khz) {
+		return 0;
+	}
+	
+	thread_t * thread = thread_current();
+	uint32_t flags = interrupt_save();
+	
+	// The shortest pass of the loop, with no interrupts to lengthen it
+	uint64_t pass = UINT64_MAX;
+	uint64_t prev = cpu_rdtsc();
+	for(uint32_t i = 0; i < IRQ_ROUND_TRIP_CALIBRATE; i++) {
+		uint64_t now = cpu_rdtsc();
+		if(now - prev < pass) {
+			pass = now - prev;
+		}
+		prev = now;
+	}
+	
+	interrupt_enable();
+	
+	uint32_t count = irq_get_count(irq_num);
+	uint32_t switches = thread->switches;
+	uint64_t total = 0;
+	uint32_t timed = 0;
+	uint64_t deadline = cpu_rdtsc() + (uint64_t) tsc_khz * IRQ_ROUND_TRIP_TIMEOUT_MS;
+	
+	prev = cpu_rdtsc();
+	while(timed < IRQ_ROUND_TRIP_ROUNDS && prev < deadline) {
+		uint64_t now = cpu_rdtsc();
+		uint64_t gap = now - prev;
+		prev = now;
+		if(gap < pass * IRQ_ROUND_TRIP_GAP) {
+			continue;
+		}
+		
+		// The IRQ changes the count and a thread switch the switches, so read them again
+		__asm__ __volatile__ ("" : : : "memory");
+		uint32_t new_count = irq_get_count(irq_num);
+		uint32_t new_switches = thread->switches;
+		
+		// Only a pass that just this IRQ was taken in, with no other thread run, is a round trip
+		if(new_count == count + 1 && new_switches == switches) {
+			total += gap - pass;
+			timed++;
+		}
+		count = new_count;
+		switches = new_switches;
+		
+		// Leave the time taken here out of the next pass
+		prev = cpu_rdtsc();
+	}
+	
+	interrupt_restore(flags);
 	
-	value = in_port_byte(port) | (1 << irq_num);
-	out_port_byte(port, value);
+	return timed ? cpu_div64_32(total, timed) : 0;
+}
+
+const char * irq_get_chip_name(void) {
+	return irq_chip->name;
+}
+
+bool irq_has_ioapic(void) {
+	return irq_chip == &irq_chip_ioapic;
+}
+
+void irq_set_mask(uint8_t irq_num) {
+	// Only the flag is set, the interrupt controller is left alone unless the IRQ fires
+	uint32_t flags = interrupt_save();
+	irq_disabled |= (uint16_t) (1 << irq_num);
+	interrupt_restore(flags);
 }
 
 void irq_clear_mask(uint8_t irq_num) {
-	uint16_t port;
-	uint8_t value;
+	uint16_t bit = (uint16_t) (1 << irq_num);
+	uint32_t flags = interrupt_save();
+	
+	irq_disabled &= (uint16_t) ~bit;
+	
+	// Only touch the interrupt controller if the IRQ fired while disabled
+	if(irq_masked & bit) {
+		irq_masked &= (uint16_t) ~bit;
+		irq_chip->unmask(irq_num);
+	}
 	
-	if(irq_num < 8) {
-		port = PIC_INTERRUPT_MASK_REG_MASTER;
-	} else {
-		port = PIC_INTERRUPT_MASK_REG_SLAVE;
-		irq_num -= 8;
+	// Only set for edge triggered IRQs, as the edge that was missed won't be raised again
+	if(irq_pending & bit) {
+		irq_pending &= (uint16_t) ~bit;
+		irq_replay(irq_num);
 	}
 	
-	value = in_port_byte(port) & ~(1 << irq_num);
-	out_port_byte(port, value);
+	interrupt_restore(flags);
+}
+
+void irq_enable_ioapic(void) {
+	uint32_t flags = interrupt_save();
+	
+	if(!ioapic_init()) {
+		interrupt_restore(flags);
+		kprintf("IRQ: No I/O APIC, using the %s\n", irq_chip->name);
+		return;
+	}
+	
+	// Keep the IRQs that were enabled on the PIC enabled. The disabled IRQs that fired are masked
+	// off on the PIC, so stay masked off until enabled
+	uint16_t mask = pic_get_mask();
+	
+	for(uint8_t i = 0; i < IRQ_TOTAL; i++) {
+		idt_open_interrupt_gate(ioapic_get_vector(i), irq_stub_table[i]);
+		if(!(mask & (1 << i)) && i != 2) {
+			ioapic_clear_mask(i);
+		}
+	}
+	
+	pic_disable();
+	irq_chip = &irq_chip_ioapic;
+	
+	interrupt_restore(flags);
+	
+	kprintf("IRQ: Using the %s\n", irq_chip->name);
 }
 
 void irq_init(void) {
 	// Remap the PIC IRQ so not to overlap with other exceptions
 	pic_remap_irq();
 	
+	// The IRQs the PIC starts with masked off are disabled, and only enabled by unmasking them
+	irq_disabled = pic_get_mask();
+	irq_masked = irq_disabled;
+	
 	// Open all the IRQ's
-	idt_open_interrupt_gate(32, (uint32_t) &_irq00);
-	idt_open_interrupt_gate(33, (uint32_t) &_irq01);
-	idt_open_interrupt_gate(34, (uint32_t) &_irq02);
-	idt_open_interrupt_gate(35, (uint32_t) &_irq03);
-	idt_open_interrupt_gate(36, (uint32_t) &_irq04);
-	idt_open_interrupt_gate(37, (uint32_t) &_irq05);
-	idt_open_interrupt_gate(38, (uint32_t) &_irq06);
-	idt_open_interrupt_gate(39, (uint32_t) &_irq07);
-	idt_open_interrupt_gate(40, (uint32_t) &_irq08);
-	idt_open_interrupt_gate(41, (uint32_t) &_irq09);
-	idt_open_interrupt_gate(42, (uint32_t) &_irq10);
-	idt_open_interrupt_gate(43, (uint32_t) &_irq11);
-	idt_open_interrupt_gate(44, (uint32_t) &_irq12);
-	idt_open_interrupt_gate(45, (uint32_t) &_irq13);
-	idt_open_interrupt_gate(46, (uint32_t) &_irq14);
-	idt_open_interrupt_gate(47, (uint32_t) &_irq15);
+	for(uint8_t i = 0; i < IRQ_TOTAL; i++) {
+		idt_open_interrupt_gate(32 + i, irq_stub_table[i]);
+	}
+	
+	idt_open_interrupt_gate(IRQ_BENCH_VECTOR, (uint32_t) _irq_bench);
 }
@@ -0,0 +1,228 @@
+#include <irqstat.h>
+#include <irq.h>
+#include <isr.h>
+#include <percpu.h>
+#include <cpu.h>
+#include <ksyms.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#if IRQSTAT_VECTORS != ISR_TOTAL + IRQ_TOTAL
+#error "Each exception and IRQ needs statistics"
+#endif
+
+/**
+ * \struct irqstat_vector_t
+ * 
+ * \brief The statistics of a vector.
+ */
+typedef struct {
+	uint32_t count;						/**< The number of times the handler finished. */
+	irqstat_histogram_t latency;		/**< The cycles from the entry to the handler starting. */
+	irqstat_histogram_t duration;		/**< The cycles the handler ran for. */
+} irqstat_vector_t;
+
+static irqstat_vector_t irqstat_vectors[IRQSTAT_VECTORS];	/**< The statistics of each vector. Exceptions are rare and IRQs are only taken on the boot CPU, so these aren't per-CPU. */
+
+/**
+ * \brief Add a number of cycles to a histogram.
+ * 
+ * \param [in] histogram The histogram.
+ * \param [in] cycles The number of cycles.
+ */
+static void irqstat_add(irqstat_histogram_t * histogram, uint64_t cycles) {
+	uint32_t value = (cycles >> 32) ? UINT32_MAX : (uint32_t) cycles;
+	
+	// The bucket is the index of the top bit, past the first bucket
+	uint32_t bucket = 0;
+	if(value >> IRQSTAT_FIRST_SHIFT) {
+		bucket = 32 - __builtin_clz(value) - IRQSTAT_FIRST_SHIFT;
+		if(bucket >= IRQSTAT_BUCKETS) {
+			bucket = IRQSTAT_BUCKETS - 1;
+		}
+	}
+	
+	histogram->buckets[bucket]++;
+	if(value > histogram->max) {
+		histogram->max = value;
+	}
+}
+
+void irqstat_record(uint32_t vector, uint64_t entry, uint64_t start, uint64_t end) {
+	if(vector >= IRQSTAT_VECTORS) {
+		return;
+	}
+	
+	irqstat_vector_t * stats = &irqstat_vectors[vector];
+	stats->count++;
+	irqstat_add(&stats->latency, start - entry);
+	irqstat_add(&stats->duration, end - start);
+}
+
+/**
+ * \brief Print the buckets of histograms side by side, up to the last bucket any of them use.
+ * 
+ * \param [in] histograms The histograms.
+ * \param [in] num The number of histograms.
+ */
+static void irqstat_print_buckets(const irqstat_histogram_t * histograms, uint32_t num) {
+	uint32_t last = 0;
+	for(uint32_t i = 0; i < num; i++) {
+		for(uint32_t bucket = 0; bucket < IRQSTAT_BUCKETS; bucket++) {
+			if(histograms[i].buckets[bucket] && bucket > last) {
+				last = bucket;
+			}
+		}
+	}
+	
+	for(uint32_t bucket = 0; bucket <= last; bucket++) {
+		if(bucket == 0) {
+			kprintf("\t< %u", 1 << IRQSTAT_FIRST_SHIFT);
+		} else if(bucket == IRQSTAT_BUCKETS - 1) {
+			kprintf("\t>= %u", 1 << (IRQSTAT_FIRST_SHIFT + bucket - 1));
+		} else {
+			kprintf("\t%u", 1 << (IRQSTAT_FIRST_SHIFT + bucket - 1));
+		}
+		
+		for(uint32_t i = 0; i < num; i++) {
+			kprintf("\t%u", histograms[i].buckets[bucket]);
+		}
+		kprintf("\n");
+	}
+}
+
+#ifdef IRQ_TRACE
+
+/**
+ * \struct irqstat_cpu_t
+ * 
+ * \brief The sections with interrupts disabled on a CPU.
+ */
+typedef struct {
+	uint64_t start;					/**< The TSC as interrupts were disabled. 0 if not timing a section. */
+	uint32_t from;					/**< Where interrupts were disabled. */
+	uint32_t max_from;				/**< Where the longest section started. */
+	uint32_t max_to;				/**< Where the longest section ended. */
+	irqstat_histogram_t sections;	/**< The cycles of each section. */
+} __attribute__((aligned(PERCPU_ALIGN))) irqstat_cpu_t;
+
+static bool irqstat_started = false;				/**< Whether GS has the per-CPU segment, so the sections can be timed. */
+static irqstat_cpu_t irqstat_cpus[PERCPU_MAX_CPUS];	/**< The sections of each CPU, each on its own cache lines. */
+
+/**
+ * \brief Get the sections of the current CPU.
+ * 
+ * \return The sections. NULL if not started yet.
+ */
+static irqstat_cpu_t * irqstat_this_cpu(void) {
+	if(!irqstat_started) {
+		return NULL;
+	}
+	
+	uint32_t id = this_cpu_read(cpu_id);
+	return id < PERCPU_MAX_CPUS ? &irqstat_cpus[id] : NULL;
+}
+
+void irqstat_init(void) {
+	irqstat_started = true;
+}
+
+void irqstat_irqs_off(void) {
+	irqstat_cpu_t * cpu = irqstat_this_cpu();
+	if(!cpu) {
+		return;
+	}
+	
+	// Called from the function that disables interrupts, so that is where the section starts
+	cpu->start = cpu_rdtsc();
+	cpu->from = (uint32_t) __builtin_return_address(0);
+}
+
+void irqstat_irqs_on(void) {
+	irqstat_cpu_t * cpu = irqstat_this_cpu();
+	if(!cpu || !cpu->start) {
+		return;
+	}
+	
+	uint64_t cycles = cpu_rdtsc() - cpu->start;
+	cpu->start = 0;
+	
+	if(cycles > cpu->sections.max) {
+		cpu->max_from = cpu->from;
+		cpu->max_to = (uint32_t) __builtin_return_address(0);
+	}
+	irqstat_add(&cpu->sections, cycles);
+}
+
+void irqstat_irq_entry(void) {
+	irqstat_cpu_t * cpu = irqstat_this_cpu();
+	if(cpu) {
+		cpu->start = 0;
+	}
+}
+
+/**
+ * \brief Print an address with the symbol it is in.
+ * 
+ * \param [in] addr The address.
+ */
+static void irqstat_print_symbol(uint32_t addr) {
+	uint32_t offset = 0;
+	const char * name = ksym_lookup(addr, &offset);
+	kprintf("0x%08X %s+0x%X", addr, name ? name : "?", offset);
+}
+
+/**
+ * \brief Print the longest section with interrupts disabled on each CPU that has one, and the
+ * histogram of the sections.
+ */
+static void irqstat_dump_sections(void) {
+	for(uint32_t i = 0; i < PERCPU_MAX_CPUS; i++) {
+		irqstat_cpu_t * cpu = &irqstat_cpus[i];
+		if(!cpu->sections.max) {
+			continue;
+		}
+		
+		kprintf("CPU %u: Longest with interrupts disabled %u cycles, from ", i, cpu->sections.max);
+		irqstat_print_symbol(cpu->max_from);
+		kprintf(" to ");
+		irqstat_print_symbol(cpu->max_to);
+		kprintf("\n\tCycles\tSections\n");
+		irqstat_print_buckets(&cpu->sections, 1);
+	}
+}
+
+#else
+
+/**
+ * \brief The sections with interrupts disabled aren't timed without IRQ_TRACE.
+ */
+static void irqstat_dump_sections(void) {
+	kprintf("Interrupts disabled tracing is disabled, build the kernel with IRQ_TRACE=1\n");
+}
+
+#endif /* IRQ_TRACE */
+
+void irqstat_dump(void) {
+	for(uint32_t vector = 0; vector < IRQSTAT_VECTORS; vector++) {
+		irqstat_vector_t * stats = &irqstat_vectors[vector];
+		if(!stats->count) {
+			continue;
+		}
+		
+		if(vector < ISR_TOTAL) {
+			kprintf("Exception %u", vector);
+		} else {
+			kprintf("IRQ %u", vector - ISR_TOTAL);
+		}
+		kprintf(": %u times, max latency %u, max duration %u cycles\n", stats->count, stats->latency.max, stats->duration.max);
+		
+		kprintf("\tCycles\tLatency\tDuration\n");
+		irqstat_histogram_t histograms[2] = {stats->latency, stats->duration};
+		irqstat_print_buckets(histograms, 2);
+	}
+	
+	irqstat_dump_sections();
+}
@@ -6,24 +6,37 @@
 #include <stdint.h>
 #include <stdnoreturn.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <vga.h>
 #include <tty.h>
 #include <boot.h>
 #include <gdt.h>
+#include <percpu.h>
+#include <cpu_features.h>
+#include <fpu.h>
 #include <idt.h>
 #include <isr.h>
 #include <irq.h>
 #include <interrupt.h>
 #include <pit.h>
+#include <clock.h>
 #include <keyboard.h>
 #include <panic.h>
 #include <rtc.h>
+#include <cmos.h>
 #include <speaker.h>
 #include <pmm.h>
 #include <paging.h>
 #include <floppy.h>
 #include <kernel_task.h>
+#include <thread.h>
+#include <acpi.h>
+#include <smp.h>
+#include <lapic.h>
+#include <hpet.h>
+#include <irqstat.h>
+#include <syscall.h>
 
 #if !defined(__i386__)
 #error "This needs to be compiled with a ix86-elf compiler"
@@ -112,14 +125,33 @@ noreturn void kernel_main(void) {
 	
 	gdt_init();
 	
+	// Before any IRQ, as the IRQ handler uses the per-CPU counters
+	percpu_init(0);
+	
+	// Now GS is set up, the sections with interrupts disabled can be timed per-CPU
+	irqstat_init();
+	
 	idt_init();
 	
 	isr_init();
 	
+	cpu_features_init();
+	
+	fpu_init();
+	
+	// Now the FPU is set up, pick the fastest memcpy and memset
+	string_init();
+	
 	irq_init();
 	
+	// The coroutines are run as deferred work, so this needs nothing else set up
+	async_init();
+	
 	pit_init();
 	
+	// Time the TSC on counter 2 of the PIT, so the monotonic clock can be read
+	clock_init();
+	
 	keyboard_init();
 	
 	interrupt_enable();
@@ -177,6 +209,28 @@ noreturn void kernel_main(void) {
 	
 	//paging_test();
 	
+	// From here the boot context is the kernel thread and the PIT preempts it
+	thread_init();
+	
+	// User processes enter the kernel with int 0x80 or SYSENTER
+	syscall_init();
+	
+	// Start the other CPUs, which needs the timers for the start up delays
+	acpi_init();
+	smp_init();
+	kprintf("%u CPUs online\n", smp_get_cpu_count());
+	
+	// Move the IRQs from the PIC to the I/O APIC, now the local APIC is mapped
+	irq_enable_ioapic();
+	
+	// The HPET is a clock source that doesn't change rate, and can take the tick from the PIT
+	hpet_init();
+	
+	// Move the tick onto the local APIC timer, which is programmed without port I/O
+	lapic_timer_init();
+	
+	cmos_init();
+	
 	rtc_init();
 	
 	floppy_set_working_drive(0);
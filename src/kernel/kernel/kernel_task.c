@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #include <kernel_task.h>
 #include <tty.h>
@@ -8,174 +10,328 @@
 #include <floppy.h>
 #include <speaker.h>
 #include <keyboard.h>
-#include <pit.h>
+#include <clockevent.h>
+#include <clock.h>
+#include <arena.h>
+#include <panic.h>
+#include <alloc_trace.h>
+#include <thread.h>
+#include <cpu.h>
+#include <irq.h>
+#include <pic.h>
+#include <irqstat.h>
+#include <spinlock.h>
+#include <smp.h>
+#include <pmm.h>
+#include <cpu_features.h>
+#include <process.h>
+#include <syscall.h>
 
-static char prev_command_buffer[10][64] = {0};	/**<  */
-static int prev_command_buffer_end = 0;			/**<  */
-static int prev_command_buffer_index = 0;		/**<  */
+extern uint8_t _user_syscall_bench_start[];
+extern uint8_t _user_syscall_bench_end[];
+
+/**
+ * \struct history_entry_t
+ * 
+ * \brief A previous command in the command history. Stored in \ref history_arena.
+ */
+typedef struct history_entry {
+	struct history_entry * prev;	/**< The older command, NULL if the oldest. */
+	struct history_entry * next;	/**< The newer command, NULL if the newest. */
+	char command[];					/**< The NULL terminated command string. */
+} history_entry_t;
+
+/**
+ * \struct command_line_t
+ * 
+ * \brief The command line being typed. The buffer is allocated from a arena and grows when full.
+ */
+typedef struct {
+	char * buffer;					/**< The command string. All bytes after the string are NULL. */
+	uint32_t index;					/**< The position of the cursor in the buffer. */
+	uint32_t size;					/**< The size of the buffer in bytes including the NULL terminator. */
+	arena_t * arena;				/**< The arena the buffer is allocated from. */
+} command_line_t;
+
+/**
+ * \struct smp_bench_t
+ * 
+ * \brief The buffer the parallel memory fill benchmark splits between the CPUs.
+ */
+typedef struct {
+	uint8_t * buffer;				/**< The buffer to fill. */
+	uint32_t size;					/**< The size of the buffer in bytes. */
+	uint32_t num_cpus;				/**< The number of CPUs the buffer is split between. */
+} smp_bench_t;
+
+static arena_t * history_arena;				/**< The arena that holds all the previous commands. */
+static history_entry_t * history_oldest;	/**< The oldest command in the history. */
+static history_entry_t * history_newest;	/**< The newest command in the history. */
+static history_entry_t * history_index;		/**< The command being shown when scrolling the history, NULL if not scrolling. */
+static uint32_t history_count;				/**< The number of commands in the history. */
+static volatile bool sched_bench_running;	/**< Whether the busy thread of the scheduler benchmark should keep running. */
 
 static void display_time(void) {
 	static char * str_day[] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
 	rtc_date_time_t date;
-	tty_get_time(&date);
+	rtc_get_date_time(&date);
 	// DD-MM-YYYY hh:mm:ss
 	kprintf("%s %02d-%02d-%04d %02d:%02d:%02d\n", str_day[date.day_of_week], date.day, date.month, date.year, date.hour, date.minute, date.second);
 }
 
+/**
+ * \brief Add a command to the end of the history list in \p arena.
+ * 
+ * \param [in] arena The arena to allocate the history entry from.
+ * \param [in] cmd The command to add.
+ * 
+ * \return Whether there was enough memory to add the command.
+ */
+static bool history_append(arena_t * arena, const char * cmd) {
+	uint32_t len = strlen(cmd) + 1;
+	history_entry_t * entry = (history_entry_t *) arena_alloc(arena, sizeof(history_entry_t) + len);
+	if(!entry) {
+		return false;
+	}
+	
+	memcpy(entry->command, cmd, len);
+	entry->next = NULL;
+	entry->prev = history_newest;
+	
+	if(history_newest) {
+		history_newest->next = entry;
+	} else {
+		history_oldest = entry;
+	}
+	
+	history_newest = entry;
+	history_count++;
+	return true;
+}
+
+/**
+ * \brief Once the history is full, copy the newest half into a new arena and free the old arena in
+ * one go, so dropping old commands doesn't need a free per command.
+ */
+static void history_compact(void) {
+	arena_t * old_arena = history_arena;
+	history_entry_t * entry = history_oldest;
+	
+	arena_t * new_arena = arena_create(KERNEL_TASK_HISTORY_BLOCKS);
+	if(!new_arena) {
+		return;
+	}
+	
+	// Skip the oldest half
+	for(uint32_t i = 0; i < history_count - (KERNEL_TASK_HISTORY_MAX / 2); i++) {
+		entry = entry->next;
+	}
+	
+	history_oldest = NULL;
+	history_newest = NULL;
+	history_count = 0;
+	
+	for(; entry; entry = entry->next) {
+		history_append(new_arena, entry->command);
+	}
+	
+	history_arena = new_arena;
+	arena_destroy(old_arena);
+}
+
 static void add_command(char * cmd) {
-	memcpy(prev_command_buffer[prev_command_buffer_end], cmd, strlen(cmd) + 1);
-	prev_command_buffer_end = (prev_command_buffer_end + 1) % 10;
-	prev_command_buffer_index = prev_command_buffer_end;
+	history_index = NULL;
+	
+	if(cmd[0] == '\0' || !history_arena) {
+		return;
+	}
+	
+	if(history_count >= KERNEL_TASK_HISTORY_MAX) {
+		history_compact();
+	}
+	
+	history_append(history_arena, cmd);
 }
 
 static char * get_prev_cmd(void) {
-	int count = 10;
-	int save_index = prev_command_buffer_index;
-	if(prev_command_buffer_index == 0) {
-		prev_command_buffer_index = 10;
+	if(!history_index) {
+		history_index = history_newest;
+	} else if(history_index->prev) {
+		history_index = history_index->prev;
 	}
 	
-	prev_command_buffer_index--;
-	//save_index = prev_command_buffer_index;
+	return history_index ? history_index->command : "";
+}
+
+/**
+ * \brief Set up a new empty command line with the buffer allocated from \p arena.
+ * 
+ * \param [in] line The command line to set up.
+ * \param [in] arena The arena to allocate the buffer from.
+ */
+static void command_line_init(command_line_t * line, arena_t * arena) {
+	line->arena = arena;
+	line->index = 0;
+	line->size = KERNEL_TASK_COMMAND_SIZE;
+	line->buffer = (char *) arena_alloc(arena, line->size);
+	if(!line->buffer) {
+		panic("Unable to allocate the command buffer\n");
+	}
+	memset(line->buffer, 0, line->size);
+}
+
+/**
+ * \brief Make sure there is room for \p extra more characters in the command line. The buffer is
+ * doubled in size. The old buffer is left in the arena and is freed when the arena is reset.
+ * 
+ * \param [in] line The command line.
+ * \param [in] extra The number of characters about to be added.
+ * 
+ * \return Whether there is room.
+ */
+static bool command_line_reserve(command_line_t * line, uint32_t extra) {
+	uint32_t needed = strlen(line->buffer) + extra + 1;
+	if(needed <= line->size) {
+		return true;
+	}
 	
-	while((prev_command_buffer[prev_command_buffer_index][0] == '\0') && count > 0) {
-		if(prev_command_buffer_index == prev_command_buffer_end) {
-			prev_command_buffer_index = save_index;
-			return prev_command_buffer[prev_command_buffer_index];
-		}
-		
-		prev_command_buffer_index--;
-		if(prev_command_buffer_index == 0) {
-			prev_command_buffer_index = 10;
-		}
-		count--;
+	uint32_t new_size = line->size;
+	while(new_size < needed) {
+		new_size *= 2;
 	}
 	
-	if(prev_command_buffer_index == prev_command_buffer_end) {
-		prev_command_buffer_index = save_index;
-		return prev_command_buffer[prev_command_buffer_index];
+	char * new_buffer = (char *) arena_alloc(line->arena, new_size);
+	if(!new_buffer) {
+		return false;
 	}
 	
-	return prev_command_buffer[prev_command_buffer_index];
+	memset(new_buffer, 0, new_size);
+	memcpy(new_buffer, line->buffer, strlen(line->buffer));
+	line->buffer = new_buffer;
+	line->size = new_size;
+	return true;
 }
 
-static void zero_cmd_buffer(char * command_buffer, int * command_buffer_index) {
-	memset(command_buffer, 0, 64);
-	*command_buffer_index = 0;
+static void zero_cmd_buffer(command_line_t * line) {
+	memset(line->buffer, 0, line->size);
+	line->index = 0;
 }
 
-static void move_left(int * command_buffer_index) {
-	if(*command_buffer_index) {
+static void move_left(command_line_t * line) {
+	if(line->index) {
 		tty_move_cursor_left();
-		(*command_buffer_index)--;
+		line->index--;
 	}
 }
 
-static void move_right(char * command_buffer, int * command_buffer_index) {
-	if(command_buffer[*command_buffer_index] != '\0') {
+static void move_right(command_line_t * line) {
+	if(line->buffer[line->index] != '\0') {
 		tty_move_cursor_right();
-		(*command_buffer_index)++;
+		line->index++;
 	}
 }
 
-static void clear_line(char * command_buffer, int * command_buffer_index) {
-	//int temp = command_buffer_index;
-	
+static void clear_line(command_line_t * line) {
 	// Start from the end
-	for(unsigned int i = *command_buffer_index; i < strlen(command_buffer); i++) {
-		move_right(command_buffer, command_buffer_index);
-		(*command_buffer_index)--;
+	for(unsigned int i = line->index; i < strlen(line->buffer); i++) {
+		move_right(line);
+		line->index--;
 	}
 	
 	// Clear the line
-	for(unsigned int i = 0; i < strlen(command_buffer); i++) {
+	for(unsigned int i = 0; i < strlen(line->buffer); i++) {
 		kputchar('\b');
 		kputchar('\0');
 		kputchar('\b');
 	}
-	
-	// Move back to where started
-	//command_buffer_index = temp;
 }
 
-static void add_char_to_cmd(char c, char * command_buffer, int * command_buffer_index) {
-	// CHECK OVER FLOW
-	clear_line(command_buffer, command_buffer_index);
+static void add_char_to_cmd(char c, command_line_t * line) {
+	clear_line(line);
 	
 	if(c == '\b') {
-		if(*command_buffer_index) {
-			memmove(command_buffer + *command_buffer_index - 1, command_buffer + *command_buffer_index, strlen(command_buffer + *command_buffer_index));
+		if(line->index) {
+			memmove(line->buffer + line->index - 1, line->buffer + line->index, strlen(line->buffer + line->index));
 			
-			(*command_buffer_index)--;
+			line->index--;
 			
 			// Set last item to null
-			command_buffer[strlen(command_buffer) - 1] = '\0';
+			line->buffer[strlen(line->buffer) - 1] = '\0';
 		}
 		
 		goto print;
 	} else if(c == '\t') {
-		
-		if(*command_buffer_index + 4 > 62) {
+		if(!command_line_reserve(line, 4)) {
 			goto print;
 		}
 		
-		if(command_buffer[*command_buffer_index] != '\0') {
-			memmove(command_buffer + *command_buffer_index + 4, command_buffer + *command_buffer_index, strlen(command_buffer + *command_buffer_index));
+		if(line->buffer[line->index] != '\0') {
+			memmove(line->buffer + line->index + 4, line->buffer + line->index, strlen(line->buffer + line->index));
 		}
-		command_buffer[(*command_buffer_index)++] = ' ';
-		command_buffer[(*command_buffer_index)++] = ' ';
-		command_buffer[(*command_buffer_index)++] = ' ';
-		command_buffer[(*command_buffer_index)++] = ' ';
+		line->buffer[line->index++] = ' ';
+		line->buffer[line->index++] = ' ';
+		line->buffer[line->index++] = ' ';
+		line->buffer[line->index++] = ' ';
 		goto print;
 	}
 	
-	// if(*command_buffer_index + 1 > 62)
-	if(*command_buffer_index > 61) {
+	if(!command_line_reserve(line, 1)) {
 		goto print;
 	}
 	
 	// If half way into a word
-	if(command_buffer[*command_buffer_index] != '\0') {
+	if(line->buffer[line->index] != '\0') {
 		// Move all chars to right of the index one to the right
-		memmove(command_buffer + *command_buffer_index + 1, command_buffer + *command_buffer_index, strlen(command_buffer + *command_buffer_index));
+		memmove(line->buffer + line->index + 1, line->buffer + line->index, strlen(line->buffer + line->index));
 	}
 	
 	// Add the char
-	command_buffer[(*command_buffer_index)++] = c;
+	line->buffer[line->index++] = c;
 	
 	print:
 	
-	kprintf("%s", command_buffer);
+	kprintf("%s", line->buffer);
 	
-	for(unsigned int i = *command_buffer_index; i < strlen(command_buffer); i++) {
-		(*command_buffer_index)++;
-		move_left(command_buffer_index);
+	for(unsigned int i = line->index; i < strlen(line->buffer); i++) {
+		line->index++;
+		move_left(line);
 	}
 }
 
-static char * get_next_cmd(void) {
-	if(prev_command_buffer_index == prev_command_buffer_end) {
-		return prev_command_buffer[prev_command_buffer_index];
+/**
+ * \brief Replace the command line with \p cmd, used when scrolling through the history.
+ * 
+ * \param [in] line The command line.
+ * \param [in] cmd The command to show.
+ */
+static void set_cmd(command_line_t * line, const char * cmd) {
+	clear_line(line);
+	zero_cmd_buffer(line);
+	
+	if(!command_line_reserve(line, strlen(cmd))) {
+		return;
 	}
 	
-	if(prev_command_buffer_index == 10) {
-		prev_command_buffer_index = 0;
+	kprintf("%s", cmd);
+	for(unsigned int i = 0; i < strlen(cmd); i++) {
+		line->buffer[line->index++] = cmd[i];
+	}
+}
+
+static char * get_next_cmd(void) {
+	if(history_index) {
+		history_index = history_index->next;
 	}
 	
-	prev_command_buffer_index++;
-	return prev_command_buffer[prev_command_buffer_index];
+	return history_index ? history_index->command : "";
 }
 
-static void get_command(char * command_buffer) {
+static void get_command(command_line_t * line) {
 	char ch;
-	char * prev_cmd;
 	bool end_of_cmd = false;
 	char * help = "help";
 	
-	//char command_buffer[64] = {0};
-	int command_buffer_index = 0;
-	
-	while(command_buffer_index < 62 && !end_of_cmd) {
+	while(!end_of_cmd) {
 			// unsigned char key = get_key();
 			unsigned char key = wait_for_key_press();
 			switch (key) {
@@ -188,10 +344,10 @@ static void get_command(char * command_buffer) {
 					break;
 					
 				case KEYBOARD_KEY_F1:
-					zero_cmd_buffer(command_buffer, &command_buffer_index);
-					clear_line(command_buffer, &command_buffer_index);
-					for(int i = 0; i < 5; i++) {
-						add_char_to_cmd(help[i], command_buffer, &command_buffer_index);
+					zero_cmd_buffer(line);
+					clear_line(line);
+					for(unsigned int i = 0; i < strlen(help); i++) {
+						add_char_to_cmd(help[i], line);
 					}
 					end_of_cmd = true;
 					break;
@@ -305,51 +461,35 @@ static void get_command(char * command_buffer) {
 					break;
 					
 				case KEYBOARD_KEY_ARROW_UP:
-					clear_line(command_buffer, &command_buffer_index);
-					zero_cmd_buffer(command_buffer, &command_buffer_index);
-					
-					prev_cmd = get_prev_cmd();
-					
-					kprintf("%s", prev_cmd);
-					for(unsigned int i = 0; i < strlen(prev_cmd); i++) {
-						command_buffer[command_buffer_index++] = prev_cmd[i];
-					}
+					set_cmd(line, get_prev_cmd());
 					break;
 					
 				case KEYBOARD_KEY_ARROW_DOWN:
-					clear_line(command_buffer, &command_buffer_index);
-					zero_cmd_buffer(command_buffer, &command_buffer_index);
-					
-					prev_cmd = get_next_cmd();
-					
-					kprintf("%s", prev_cmd);
-					for(unsigned int i = 0; i < strlen(prev_cmd); i++) {
-						command_buffer[command_buffer_index++] = prev_cmd[i];
-					}
+					set_cmd(line, get_next_cmd());
 					break;
 					
 				case KEYBOARD_KEY_ARROW_LEFT:
-					move_left(&command_buffer_index);
+					move_left(line);
 					break;
 					
 				case KEYBOARD_KEY_ARROW_RIGHT:
-					move_right(command_buffer, &command_buffer_index);
+					move_right(line);
 					break;
 					
 				case KEYBOARD_KEY_BACKSPACE:
-					if (command_buffer_index > 0) {
-						add_char_to_cmd('\b', command_buffer, &command_buffer_index);
+					if (line->index > 0) {
+						add_char_to_cmd('\b', line);
 					}
 					break;
 					
 				case KEYBOARD_KEY_TAB:
-					add_char_to_cmd('\t', command_buffer, &command_buffer_index);
+					add_char_to_cmd('\t', line);
 					break;
 					
 				default:
 					ch = key_to_ascii(key);
 					if(ch) {
-						add_char_to_cmd(ch, command_buffer, &command_buffer_index);
+						add_char_to_cmd(ch, line);
 					}
 					break;
 			}
@@ -359,8 +499,195 @@ static void get_command(char * command_buffer) {
 		kputchar('\n');
 }
 
+/**
+ * \brief The busy thread for the scheduler benchmark. Uses the CPU until the benchmark finishes.
+ * 
+ * \param [in] arg Unused.
+ */
+static void sched_bench_busy(void * arg) {
+	(void) arg;
+	while(sched_bench_running) {
+		__asm__ __volatile__ ("pause");
+	}
+}
+
+/**
+ * \brief Measure the cycles from the tick waking this thread to it running, while running at
+ * \p priority.
+ * 
+ * \param [in] priority The priority to run at.
+ */
+static void sched_bench_round(uint8_t priority) {
+	uint32_t min = 0xFFFFFFFF;
+	uint32_t max = 0;
+	uint32_t total = 0;
+	
+	thread_set_priority(priority);
+	
+	for(uint32_t i = 0; i < KERNEL_TASK_SCHED_BENCH_SLEEPS; i++) {
+		thread_sleep(1);
+		uint32_t latency = (uint32_t) (cpu_rdtsc() - thread_current()->wake_tsc);
+		
+		if(latency < min) {
+			min = latency;
+		}
+		if(latency > max) {
+			max = latency;
+		}
+		total += latency;
+	}
+	
+	kprintf("Priority %u: min %u, avg %u, max %u cycles\n", priority, min, total / KERNEL_TASK_SCHED_BENCH_SLEEPS, max);
+}
+
+/**
+ * \brief Benchmark the scheduler wake up to run latency with a busy thread of normal priority.
+ * First with the shell at the same priority, so has to wait for the busy thread's time slice to
+ * end, then at the interactive priority, so it preempts the busy thread.
+ */
+static void sched_benchmark(void) {
+	sched_bench_running = true;
+	if(!thread_create("busy", sched_bench_busy, NULL, THREAD_PRIORITY_NORMAL)) {
+		kprintf("Unable to create the busy thread\n");
+		return;
+	}
+	
+	kprintf("Wake up to run latency over %u sleeps with a busy thread of priority %u:\n", KERNEL_TASK_SCHED_BENCH_SLEEPS, THREAD_PRIORITY_NORMAL);
+	sched_bench_round(THREAD_PRIORITY_NORMAL);
+	sched_bench_round(THREAD_PRIORITY_INTERACTIVE);
+	
+	// The busy thread exits the next time it runs
+	sched_bench_running = false;
+}
+
+/**
+ * \brief Fill this CPU's part of the benchmark buffer.
+ * 
+ * \param [in] cpu The CPU ID, which picks the part of the buffer.
+ * \param [in] arg The benchmark.
+ */
+static void smp_bench_fill(uint32_t cpu, void * arg) {
+	smp_bench_t * bench = (smp_bench_t *) arg;
+	uint32_t part = bench->size / bench->num_cpus;
+	
+	for(uint32_t i = 0; i < KERNEL_TASK_SMP_BENCH_ROUNDS; i++) {
+		memset(bench->buffer + cpu * part, (int) i, part);
+	}
+}
+
+/**
+ * \brief Time filling a buffer with 1 CPU up to all the online CPUs, each filling an equal part.
+ */
+static void smp_benchmark(void) {
+	smp_bench_t bench;
+	bench.size = KERNEL_TASK_SMP_BENCH_BLOCKS * PMM_BLOCK_SIZE;
+	bench.buffer = (uint8_t *) pmm_alloc_blocks(KERNEL_TASK_SMP_BENCH_BLOCKS);
+	if(!bench.buffer) {
+		kprintf("Unable to allocate the buffer\n");
+		return;
+	}
+	
+	kprintf("Filling %uKB %u times:\n", bench.size / 1024, KERNEL_TASK_SMP_BENCH_ROUNDS);
+	
+	uint32_t one_cpu = 0;
+	for(uint32_t num_cpus = 1; num_cpus <= smp_get_cpu_count(); num_cpus++) {
+		bench.num_cpus = num_cpus;
+		
+		uint64_t start = cpu_rdtsc();
+		smp_call(num_cpus, smp_bench_fill, &bench);
+		uint32_t cycles = (uint32_t) ((cpu_rdtsc() - start) >> 10);
+		
+		if(num_cpus == 1) {
+			one_cpu = cycles;
+		}
+		uint32_t speed_up = cycles ? one_cpu * 100 / cycles : 0;
+		kprintf("%u CPUs: %u Kcycles, %u.%02u times faster\n", num_cpus, cycles, speed_up / 100, speed_up % 100);
+	}
+	
+	pmm_free_blocks(bench.buffer, KERNEL_TASK_SMP_BENCH_BLOCKS);
+}
+
+/**
+ * \brief Print what the CPU supports and the memory routines picked for it.
+ */
+static void display_cpuinfo(void) {
+	cpu_features_dump();
+	kprintf("memcpy: %s, memmove: %s, memset: %s\n", string_get_variant("memcpy"), string_get_variant("memmove"), string_get_variant("memset"));
+}
+
+/**
+ * \brief Run the null system call benchmark in ring 3, which prints the cycles of entering the
+ * kernel with int 0x80 and with SYSENTER.
+ */
+static void syscall_benchmark(void) {
+	process_t process;
+	uint32_t size = _user_syscall_bench_end - _user_syscall_bench_start;
+	if(!process_create(&process, "syscallbench", _user_syscall_bench_start, size, syscall_has_sysenter())) {
+		kprintf("Unable to create the benchmark process\n");
+		return;
+	}
+	
+	if(!syscall_has_sysenter()) {
+		kprintf("No SYSENTER, only timing int 0x80\n");
+	}
+	
+	if(process_wait(&process) == PROCESS_EXIT_FAULT) {
+		kprintf("The benchmark process faulted\n");
+	}
+}
+
+/**
+ * \brief Print the interrupt controller, the entry and exit cost, the round trip of the timer IRQ,
+ * and the number of times each IRQ was raised with the average cycles of its handler and
+ * acknowledgement.
+ */
+static void display_irqs(void) {
+	uint32_t entry = irq_bench();
+	uint32_t round_trip = irq_round_trip(PIC_IRQ_TIMER);
+	
+	kprintf("Controller: %s\n", irq_get_chip_name());
+	kprintf("Entry and exit: %u cycles\n", entry);
+	kprintf("IRQ %u round trip: %u cycles\n", PIC_IRQ_TIMER, round_trip);
+	kprintf("IRQ\tCount\tHandler\tEOI (average cycles)\n");
+	for(uint8_t i = 0; i < IRQ_TOTAL; i++) {
+		uint32_t count = irq_get_count(i);
+		if(count) {
+			kprintf("%u\t%u\t%u\t%u\n", i, count, irq_get_handler_cycles(i), irq_get_eoi_cycles(i));
+		}
+	}
+}
+
+/**
+ * \brief Sleep for \ref KERNEL_TASK_IDLE_TEST_MS and print the number of timer IRQs and ticks.
+ * 
+ * \param [in] tickless Whether to stop the periodic tick while idle.
+ */
+static void idle_test_round(bool tickless) {
+	clockevent_set_tickless(tickless);
+	
+	uint32_t irqs = irq_get_count(0);
+	uint32_t ticks = clockevent_get_ticks();
+	
+	thread_sleep(KERNEL_TASK_IDLE_TEST_MS);
+	
+	kprintf("Tickless %s: %u timer IRQs, %u ticks\n", tickless ? "on" : "off", irq_get_count(0) - irqs, clockevent_get_ticks() - ticks);
+}
+
+/**
+ * \brief Compare the number of timer IRQs while idle with and without the tickless idle.
+ */
+static void idle_test(void) {
+	bool tickless = clockevent_get_tickless();
+	
+	kprintf("Sleeping for %ums with the periodic tick, then %ums tickless\n", KERNEL_TASK_IDLE_TEST_MS, KERNEL_TASK_IDLE_TEST_MS);
+	idle_test_round(false);
+	idle_test_round(true);
+	
+	clockevent_set_tickless(tickless);
+}
+
 void kernel_task(void) {
-	const int num_commands = 9;
+	const int num_commands = 22;
 	const char * list_of_commands[] = {
 		"help",
 		"hello",
@@ -370,19 +697,42 @@ void kernel_task(void) {
 		"uptime",
 		"clear",
 		"read",
-		"beep"
+		"beep",
+		"starwars",
+		"birthday",
+		"allocs",
+		"threads",
+		"schedbench",
+		"irqs",
+		"irqstat",
+		"idletest",
+		"locks",
+		"cpus",
+		"smpbench",
+		"cpuinfo",
+		"syscallbench"
 	};
 	
-	char command_buffer[64] = {0};
-	int command_buffer_index = 0;
+	// Each command runs in its own arena that is freed in one go when the command finishes
+	arena_t * command_arena = arena_create(KERNEL_TASK_ARENA_BLOCKS);
+	if(!command_arena) {
+		panic("Unable to create the command arena\n");
+	}
+	
+	history_arena = arena_create(KERNEL_TASK_HISTORY_BLOCKS);
+	
+	// The shell waits on the user, so wakes up ahead of background work
+	thread_set_priority(THREAD_PRIORITY_INTERACTIVE);
 	
 	kprintf("kernel task started\n");
 	
 	while(true) {
-		zero_cmd_buffer(command_buffer, &command_buffer_index);
+		command_line_t line;
+		command_line_init(&line, command_arena);
 		kprintf("terminal:>");
 		
-		get_command(command_buffer);
+		get_command(&line);
+		char * command_buffer = line.buffer;
 		
 		add_command(command_buffer);
 		
@@ -394,13 +744,15 @@ void kernel_task(void) {
 		} else if(strcmp(command_buffer, "hello") == 0) {
 			kprintf("Hello there\n");
 		} else if(strcmp(command_buffer, "uptime") == 0) {
-			unsigned int ticks = pit_get_ticks();
-			unsigned int freq = pit_get_frequency();
-			unsigned int sec = (ticks / freq) % 60;
-			unsigned int min = (ticks / (freq * 60)) % 60;
-			unsigned int hr = (ticks / (freq * 60 * 60)) % 24;
-			unsigned int day = (ticks / (freq * 60 * 60 * 24)) % 365;
-			kprintf("%u ticks: day:hr:min:sec %3d:%02d:%02d:%02d\n", ticks, day, hr, min, sec);
+			unsigned int ticks = clockevent_get_ticks();
+			uint64_t ns = clock_monotonic_ns();
+			unsigned int seconds = (unsigned int) cpu_div64(ns, CLOCK_NS_PER_SEC);
+			unsigned int ms = (unsigned int) cpu_div64(ns, CLOCK_NS_PER_SEC / 1000) % 1000;
+			unsigned int sec = seconds % 60;
+			unsigned int min = (seconds / 60) % 60;
+			unsigned int hr = (seconds / (60 * 60)) % 24;
+			unsigned int day = (seconds / (60 * 60 * 24)) % 365;
+			kprintf("%u ticks: day:hr:min:sec %3d:%02d:%02d:%02d.%03u\n", ticks, day, hr, min, sec, ms);
 		} else if(strcmp(command_buffer, "eg") == 0) {
 			kprintf("Soph is a butt\n");
 		} else if(strcmp(command_buffer, "time") == 0) {
@@ -420,10 +772,11 @@ void kernel_task(void) {
 			kprintf("    |    |    |   \n");
 		} else if(strcmp(command_buffer, "read") == 0) {
 			kprintf("Enter the logical bock address to read from: ");
-			char lba[64] = {0};
-			get_command(lba);
-			kprintf("string number get: %s\n", lba);
-			uint32_t lba_int = atoi(lba);
+			command_line_t lba;
+			command_line_init(&lba, command_arena);
+			get_command(&lba);
+			kprintf("string number get: %s\n", lba.buffer);
+			uint32_t lba_int = atoi(lba.buffer);
 			kprintf("lba number: %d\n", lba_int);
 			uint8_t * sector = floppy_read_sector(lba_int);
 			if(sector) {
@@ -439,13 +792,39 @@ void kernel_task(void) {
 			}
 		} else if(strcmp(command_buffer, "beep") == 0) {
 			beep(400, 150);
-			// speaker_happy_birthday();
-			// speaker_star_wars();
+		} else if(strcmp(command_buffer, "starwars") == 0) {
+			speaker_star_wars();
+		} else if(strcmp(command_buffer, "birthday") == 0) {
+			speaker_happy_birthday();
+		} else if(strcmp(command_buffer, "allocs") == 0) {
+			alloc_trace_dump();
+		} else if(strcmp(command_buffer, "threads") == 0) {
+			thread_dump();
+		} else if(strcmp(command_buffer, "schedbench") == 0) {
+			sched_benchmark();
+		} else if(strcmp(command_buffer, "irqs") == 0) {
+			display_irqs();
+		} else if(strcmp(command_buffer, "irqstat") == 0) {
+			irqstat_dump();
+		} else if(strcmp(command_buffer, "idletest") == 0) {
+			idle_test();
+		} else if(strcmp(command_buffer, "locks") == 0) {
+			spin_lock_dump();
+		} else if(strcmp(command_buffer, "cpus") == 0) {
+			smp_dump();
+		} else if(strcmp(command_buffer, "smpbench") == 0) {
+			smp_benchmark();
+		} else if(strcmp(command_buffer, "cpuinfo") == 0) {
+			display_cpuinfo();
+		} else if(strcmp(command_buffer, "syscallbench") == 0) {
+			syscall_benchmark();
 		} else {
 			if(command_buffer[0]) {
 				kprintf("%s: Command not found\n", command_buffer);
 			}
 		}
+		
+		arena_reset(command_arena);
 	}
 }
 
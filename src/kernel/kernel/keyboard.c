@@ -9,6 +9,9 @@
 #include <regs_t.h>
 #include <irq.h>
 #include <portio.h>
+#include <interrupt.h>
+#include <work.h>
+#include <wait.h>
 
 #include <stdbool.h>
 #include <stdio.h>
@@ -34,6 +37,9 @@ static volatile bool caps_lock_toggle;			/**< Is the caps lock on. */
 static volatile bool num_lock_toggle;			/**< Is the number lock on. */
 static volatile bool scroll_lock_toggle;			/**< Is the scroll lock on. */
 static volatile bool is_extended;				/**< Is the key being pressed part of the extended range of scan codes. */
+static wait_queue_t keyboard_wait;				/**< The threads waiting for a key press. */
+static async_event_t keyboard_event;			/**< Signalled on each key press for the coroutines waiting. */
+static work_t keyboard_lights_work;				/**< Sets the lights after a lock key, as too slow for the IRQ handler. */
 
 /**
  * \brief The key map of set 1 of scan codes.
@@ -478,6 +484,17 @@ static void keyboard_set_lights(bool scroll_lock, bool num_lock, bool caps_lock)
 	keyboard_encoder_send_command(data);
 }
 
+/**
+ * \brief The deferred work to set the keyboard lights to the current lock toggles. The keyboard
+ * controller is polled for each byte sent, so this is done outside of the IRQ handler.
+ * 
+ * \param [in] arg Unused.
+ */
+static void keyboard_update_lights(void * arg) {
+	(void) arg;
+	keyboard_set_lights(scroll_lock_toggle, num_lock_toggle, caps_lock_toggle);
+}
+
 /**
  * \brief The IRQ handler for the keyboard that reads the scan code from the keyboards buffer and
  * translates it into a key press or release. A held down key will generate repeated interrupts.
@@ -532,17 +549,17 @@ static void keyboard_handler(regs_t * regs) {
 		switch (key_pressed) {
 			case KEYBOARD_KEY_SCROLL_LOCK:
 				scroll_lock_toggle = !scroll_lock_toggle;
-				keyboard_set_lights(scroll_lock_toggle, num_lock_toggle, caps_lock_toggle);
+				work_queue(&keyboard_lights_work);
 				break;
 				
 			case KEYBOARD_KEY_NUM_LOCK:
 				num_lock_toggle = !num_lock_toggle;
-				keyboard_set_lights(scroll_lock_toggle, num_lock_toggle, caps_lock_toggle);
+				work_queue(&keyboard_lights_work);
 				break;
 				
 			case KEYBOARD_KEY_CAPS_LOCK:
 				caps_lock_toggle = !caps_lock_toggle;
-				keyboard_set_lights(scroll_lock_toggle, num_lock_toggle, caps_lock_toggle);
+				work_queue(&keyboard_lights_work);
 				break;
 				
 			case KEYBOARD_KEY_LEFT_SHIFT:
@@ -561,6 +578,8 @@ static void keyboard_handler(regs_t * regs) {
 				break;
 		}
 		last_key_press = key_pressed;
+		wake_up_one(&keyboard_wait);
+		async_event_signal(&keyboard_event);
 	}
 }
 
@@ -586,16 +605,20 @@ unsigned char get_last_key_press(void) {
 }
 
 unsigned char wait_for_key_press(void) {
+	uint32_t flags = interrupt_save();
 	while(last_key_press == KEYBOARD_KEY_UNKNOWN) {
-		__asm__ __volatile__ ("sti");
-		__asm__ __volatile__ ("hlt");
-		__asm__ __volatile__ ("cli");
+		wait_queue_sleep(&keyboard_wait);
 	}
 	unsigned char ret = last_key_press;
 	last_key_press = KEYBOARD_KEY_UNKNOWN;
+	interrupt_restore(flags);
 	return ret;
 }
 
+async_event_t * keyboard_get_event(void) {
+	return &keyboard_event;
+}
+
 void keyboard_init(void) {
 	// Installs 'keyboard_handler' to IRQ1
 	last_key_press = KEYBOARD_KEY_UNKNOWN;
@@ -612,5 +635,9 @@ void keyboard_init(void) {
 	
 	is_extended = false;
 	
+	wait_queue_init(&keyboard_wait);
+	async_event_init(&keyboard_event);
+	work_init(&keyboard_lights_work, keyboard_update_lights, NULL);
+	
 	irq_install_handler(PIC_IRQ_KEYBOARD, keyboard_handler);
 }
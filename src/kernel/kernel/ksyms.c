@@ -0,0 +1,32 @@
+#include <ksyms.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+extern const ksym_t ksyms_table[];		/**< The generated symbol table sorted by address. */
+extern const uint32_t ksyms_count;		/**< The number of symbols in \ref ksyms_table. */
+extern const uint8_t data[];			/**< The start of the data section from the linker script, so the end of the code. */
+
+const char * ksym_lookup(uint32_t addr, uint32_t * offset) {
+	if(ksyms_count == 0 || addr < ksyms_table[0].addr || addr >= (uint32_t) data) {
+		return NULL;
+	}
+	
+	// Binary search for the last symbol at or below addr
+	uint32_t low = 0;
+	uint32_t high = ksyms_count - 1;
+	while(low < high) {
+		uint32_t mid = (low + high + 1) / 2;
+		if(ksyms_table[mid].addr <= addr) {
+			low = mid;
+		} else {
+			high = mid - 1;
+		}
+	}
+	
+	if(offset) {
+		*offset = addr - ksyms_table[low].addr;
+	}
+	
+	return ksyms_table[low].name;
+}
@@ -0,0 +1,240 @@
+#include <lapic.h>
+#include <paging.h>
+#include <idt.h>
+#include <interrupt.h>
+#include <cpu.h>
+#include <cpu_features.h>
+#include <clockevent.h>
+#include <irq.h>
+#include <ioapic.h>
+#include <pic.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+extern void _lapic_ipi();
+extern void _lapic_spurious();
+
+static volatile uint32_t * lapic_regs = 0;		/**< The local APIC registers, identity mapped. */
+static uint8_t lapic_timer_vector;				/**< The vector the timer raises. */
+static bool lapic_timer_deadline;				/**< Whether the one shot uses the TSC-deadline mode. */
+static bool lapic_timer_armed;					/**< Whether a TSC-deadline one shot is set. */
+static uint64_t lapic_timer_tsc;				/**< The TSC value the TSC-deadline one shot ends at. */
+static uint32_t lapic_counts_per_tick;			/**< The counts of the timer in a tick. */
+static uint32_t lapic_cycles_per_tick;			/**< The TSC cycles in a tick. */
+
+/**
+ * \brief Read a local APIC register.
+ * 
+ * \param [in] reg The register offset.
+ * 
+ * \return The value of the register.
+ */
+static inline uint32_t lapic_read(uint32_t reg) {
+	return lapic_regs[reg / sizeof(uint32_t)];
+}
+
+/**
+ * \brief Write a local APIC register.
+ * 
+ * \param [in] reg The register offset.
+ * \param [in] value The value to write.
+ */
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+	lapic_regs[reg / sizeof(uint32_t)] = value;
+}
+
+/**
+ * \brief Send an IPI and wait for the local APIC to have sent it.
+ * 
+ * \param [in] apic_id The local APIC ID of the destination CPU.
+ * \param [in] command The low half of the interrupt command register.
+ */
+static void lapic_send_command(uint8_t apic_id, uint32_t command) {
+	// An IRQ handler sending an IPI in between the two writes would change the destination
+	uint32_t flags = interrupt_save();
+	
+	lapic_write(LAPIC_REG_ICR_HIGH, (uint32_t) apic_id << 24);
+	lapic_write(LAPIC_REG_ICR_LOW, command);
+	
+	while(lapic_read(LAPIC_REG_ICR_LOW) & LAPIC_ICR_PENDING) {
+		cpu_pause();
+	}
+	
+	interrupt_restore(flags);
+}
+
+/**
+ * \brief The handler for the IPI that wakes a CPU. Only needs to acknowledge it, as the CPU will
+ * look for work when it returns from the halt.
+ */
+void lapic_ipi_handler(void) {
+	lapic_send_eoi();
+}
+
+/**
+ * \brief Run the timer periodically.
+ * 
+ * \param [in] count The number of counts between each interrupt.
+ */
+static void lapic_timer_set_periodic(uint32_t count) {
+	// Changing out of the TSC-deadline mode disarms it
+	lapic_timer_armed = false;
+	lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_PERIODIC | lapic_timer_vector);
+	lapic_write(LAPIC_REG_TIMER_INITIAL, count);
+}
+
+/**
+ * \brief Interrupt once after a number of counts. In the TSC-deadline mode, the counts are
+ * converted to TSC cycles, and the deadline is set with one MSR write.
+ * 
+ * \param [in] count The number of counts until the interrupt.
+ */
+static void lapic_timer_set_oneshot(uint32_t count) {
+	if(!lapic_timer_deadline) {
+		lapic_write(LAPIC_REG_LVT_TIMER, lapic_timer_vector);
+		lapic_write(LAPIC_REG_TIMER_INITIAL, count);
+		return;
+	}
+	
+	lapic_timer_tsc = cpu_rdtsc() + cpu_div64_32((uint64_t) count * lapic_cycles_per_tick, lapic_counts_per_tick);
+	lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_TSC_DEADLINE | lapic_timer_vector);
+	
+	// The mode must be set before the deadline is written, or the write is ignored
+	__asm__ __volatile__ ("mfence" : : : "memory");
+	cpu_wrmsr(LAPIC_MSR_TSC_DEADLINE, lapic_timer_tsc);
+	lapic_timer_armed = true;
+}
+
+/**
+ * \brief Get the counts until the timer next interrupts.
+ * 
+ * \return The number of counts. 0 if a one shot has passed.
+ */
+static uint32_t lapic_timer_get_count(void) {
+	if(!lapic_timer_armed) {
+		return lapic_read(LAPIC_REG_TIMER_CURRENT);
+	}
+	
+	uint64_t now = cpu_rdtsc();
+	if(now >= lapic_timer_tsc) {
+		return 0;
+	}
+	
+	return cpu_div64_32((lapic_timer_tsc - now) * lapic_counts_per_tick, lapic_cycles_per_tick);
+}
+
+/**
+ * \brief Stop the timer.
+ */
+static void lapic_timer_stop(void) {
+	lapic_timer_armed = false;
+	lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+	lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+}
+
+/**
+ * \brief The timer of the boot CPU as a clock event device. Is programmed with MMIO writes, or one
+ * MSR write in the TSC-deadline mode, so is rated above the PIT.
+ */
+static clockevent_t lapic_clockevent = {
+	"LAPIC timer",
+	CLOCKEVENT_PERIODIC | CLOCKEVENT_ONESHOT,
+	200,
+	0,
+	0xFFFFFFFF,
+	lapic_timer_set_periodic,
+	lapic_timer_set_oneshot,
+	lapic_timer_get_count,
+	lapic_timer_stop,
+	NULL
+};
+
+void lapic_init(uint32_t address) {
+	vmm_map_device(address);
+	lapic_regs = (volatile uint32_t *) address;
+	
+	idt_open_interrupt_gate(LAPIC_IPI_VECTOR, (uint32_t) &_lapic_ipi);
+	idt_open_interrupt_gate(LAPIC_SPURIOUS_VECTOR, (uint32_t) &_lapic_spurious);
+}
+
+void lapic_enable(void) {
+	// Let all interrupts through
+	lapic_write(LAPIC_REG_TASK_PRIORITY, 0);
+	lapic_write(LAPIC_REG_SPURIOUS, LAPIC_SPURIOUS_ENABLE | LAPIC_SPURIOUS_VECTOR);
+}
+
+uint8_t lapic_get_id(void) {
+	return (uint8_t) (lapic_read(LAPIC_REG_ID) >> 24);
+}
+
+void lapic_send_eoi(void) {
+	lapic_write(LAPIC_REG_EOI, 0);
+}
+
+void lapic_send_ipi(uint8_t apic_id, uint8_t vector) {
+	lapic_send_command(apic_id, LAPIC_ICR_FIXED | LAPIC_ICR_ASSERT | vector);
+}
+
+void lapic_send_init(uint8_t apic_id) {
+	lapic_send_command(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_ASSERT | LAPIC_ICR_LEVEL);
+	
+	// Older CPUs need the INIT de-asserted
+	lapic_send_command(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL);
+}
+
+void lapic_send_startup(uint8_t apic_id, uint8_t page) {
+	lapic_send_command(apic_id, LAPIC_ICR_STARTUP | LAPIC_ICR_ASSERT | page);
+}
+
+bool lapic_timer_init(void) {
+	// Acknowledged through the local APIC as if it was IRQ 0, so needs the I/O APIC
+	if(!lapic_regs || !irq_has_ioapic()) {
+		return false;
+	}
+	
+	lapic_timer_vector = ioapic_get_vector(PIC_IRQ_TIMER);
+	lapic_timer_deadline = cpu_has(CPU_FEATURE_TSC_DEADLINE) && cpu_has(CPU_FEATURE_MSR);
+	
+	lapic_write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_1);
+	lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+	
+	// Start counting on a tick, so the count is over whole ticks
+	uint32_t tick = clockevent_get_ticks();
+	while(clockevent_get_ticks() == tick) {
+		cpu_pause();
+	}
+	
+	lapic_write(LAPIC_REG_TIMER_INITIAL, 0xFFFFFFFF);
+	uint64_t start = lapic_timer_deadline ? cpu_rdtsc() : 0;
+	
+	tick += 1 + LAPIC_TIMER_CALIBRATE_TICKS;
+	while((int32_t) (clockevent_get_ticks() - tick) < 0) {
+		cpu_pause();
+	}
+	
+	uint32_t counts = 0xFFFFFFFF - lapic_read(LAPIC_REG_TIMER_CURRENT);
+	uint64_t cycles = lapic_timer_deadline ? cpu_rdtsc() - start : 0;
+	lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+	
+	lapic_counts_per_tick = counts / LAPIC_TIMER_CALIBRATE_TICKS;
+	if(!lapic_counts_per_tick) {
+		return false;
+	}
+	
+	lapic_clockevent.frequency = lapic_counts_per_tick * CLOCKEVENT_HZ;
+	
+	if(lapic_timer_deadline) {
+		// Keep the one shot in TSC cycles within 32 bits
+		lapic_cycles_per_tick = cpu_div64_32(cycles, LAPIC_TIMER_CALIBRATE_TICKS);
+		lapic_clockevent.features |= CLOCKEVENT_DEADLINE;
+		lapic_clockevent.max_count = cpu_div64_32((uint64_t) 0xFFFFFFFF * lapic_counts_per_tick, lapic_cycles_per_tick);
+	}
+	
+	kprintf("LAPIC timer: %ukHz%s\n", lapic_counts_per_tick, lapic_timer_deadline ? ", TSC-deadline" : "");
+	
+	clockevent_register(&lapic_clockevent);
+	return true;
+}
@@ -0,0 +1,22 @@
+	[bits	32]
+	section	.text
+	
+	[extern	lapic_ipi_handler]
+
+;
+; Local APIC interrupts
+;
+
+; 240: The IPI that wakes a CPU
+global _lapic_ipi
+_lapic_ipi:
+	pusha
+	cld
+	call	lapic_ipi_handler
+	popa
+	iret
+
+; 255: Spurious interrupts don't need acknowledging
+global _lapic_spurious
+_lapic_spurious:
+	iret
@@ -10,6 +10,7 @@
 #include <string.h>
 
 static page_directory_t * current_dir = 0;			/**<  */
+static page_directory_t * kernel_dir = 0;			/**< The kernel's page directory, which every address space shares the tables of. */
 static uint32_t current_page_dir_base_register = 0;	/**< Current page directory base register */
 
 static void set_cr3(uint32_t addr) {
@@ -188,13 +189,13 @@ page_directory_t * vmm_get_directory() {
 }
 
 void vmm_flush_tlb_entry(uint32_t virtual_addr) {
-	__asm__ __volatile__ ("cli");
-	__asm__ __volatile__ ("invlpg	%0" : : "m" (virtual_addr) : "memory");
-	__asm__ __volatile__ ("sti");
+	// A single instruction so can't be interrupted part way, and mustn't turn interrupts on if the
+	// caller had them off
+	__asm__ __volatile__ ("invlpg	[%0]" : : "r" (virtual_addr) : "memory");
 }
 
 void vmm_map_page(void * physical_addr, void * virtual_addr) {
-	page_directory_t * p_dir = current_dir;
+	page_directory_t * p_dir = kernel_dir;
 	
 	pde_t * entry = &p_dir->tables[PAGE_DIRECTORY_INDEX((uint32_t) virtual_addr)];
 	
@@ -224,6 +225,127 @@ void vmm_map_page(void * physical_addr, void * virtual_addr) {
 	pte_add_flag(page, PTE_PRESENT | PTE_WRITEABLE); // This is faster
 }
 
+void vmm_map_range(uint32_t physical_addr, uint32_t length) {
+	// Identity map every page the range touches
+	uint32_t end = physical_addr + length;
+	for(uint32_t page = physical_addr & PTE_PAGE_FRAME; page < end; page += PMM_BLOCK_SIZE) {
+		vmm_map_page((void *) page, (void *) page);
+		vmm_flush_tlb_entry(page);
+	}
+}
+
+void vmm_map_device(uint32_t physical_addr) {
+	uint32_t page = physical_addr & PTE_PAGE_FRAME;
+	vmm_map_page((void *) page, (void *) page);
+	
+	// Device registers must not be cached
+	pde_t * entry = vmm_page_directory_lookup_entry(kernel_dir, page);
+	if(pde_is_present(*entry)) {
+		page_table_t * table = (page_table_t *) PAGE_GET_PHYSICAL_ADDRESS((uint32_t *) entry);
+		pte_add_flag(vmm_page_table_lookup_entry(table, page), PTE_NOT_CACHEABLE | PTE_WRITE_THOUGH);
+	}
+	vmm_flush_tlb_entry(page);
+}
+
+page_directory_t * vmm_get_kernel_directory(void) {
+	return kernel_dir;
+}
+
+page_directory_t * vmm_create_address_space(void) {
+	page_directory_t * dir = (page_directory_t *) pmm_alloc_block();
+	if(!dir) {
+		return NULL;
+	}
+	
+	// Share the kernel's tables, which ring 3 can't access. Tables the kernel adds later are only
+	// in the kernel's directory
+	memcpy(dir, kernel_dir, sizeof(page_directory_t));
+	
+	return dir;
+}
+
+bool vmm_map_user_page(page_directory_t * p_directory, void * physical_addr, void * virtual_addr) {
+	pde_t * entry = vmm_page_directory_lookup_entry(p_directory, (uint32_t) virtual_addr);
+	
+	if(!pde_is_present(*entry)) {
+		page_table_t * table = (page_table_t *) pmm_alloc_block();
+		if(!table) {
+			return false;
+		}
+		
+		memset(table, 0, sizeof(page_table_t));
+		
+		pde_add_flag(entry, PDE_PRESENT | PDE_WRITEABLE | PDE_USER_MODE);
+		pde_set_frame(entry, (uint32_t) table);
+	} else if(!pde_is_user(*entry)) {
+		// The table is the kernel's
+		return false;
+	}
+	
+	page_table_t * table = (page_table_t *) PAGE_GET_PHYSICAL_ADDRESS((uint32_t *) entry);
+	pte_t * page = vmm_page_table_lookup_entry(table, (uint32_t) virtual_addr);
+	
+	pte_set_frame(page, (uint32_t) physical_addr);
+	pte_add_flag(page, PTE_PRESENT | PTE_WRITEABLE | PTE_USER_MODE);
+	
+	return true;
+}
+
+bool vmm_is_user_range(page_directory_t * p_directory, uint32_t addr, uint32_t size) {
+	if(!size) {
+		return true;
+	}
+	
+	uint32_t last = addr + size - 1;
+	if(last < addr) {
+		return false;
+	}
+	
+	// Every page the range touches must be mapped for ring 3 in both the directory and the table
+	for(uint32_t page = addr & PTE_PAGE_FRAME; ; page += PMM_BLOCK_SIZE) {
+		pde_t * entry = vmm_page_directory_lookup_entry(p_directory, page);
+		if(!pde_is_present(*entry) || !pde_is_user(*entry)) {
+			return false;
+		}
+		
+		page_table_t * table = (page_table_t *) PAGE_GET_PHYSICAL_ADDRESS((uint32_t *) entry);
+		pte_t * pte = vmm_page_table_lookup_entry(table, page);
+		if(!pte_is_present(*pte) || !pte_is_user(*pte)) {
+			return false;
+		}
+		
+		if(page == (last & PTE_PAGE_FRAME)) {
+			return true;
+		}
+	}
+}
+
+void vmm_destroy_address_space(page_directory_t * p_directory) {
+	if(current_dir == p_directory) {
+		vmm_switch_page_directory(kernel_dir);
+	}
+	
+	// Only the user tables belong to the address space
+	for(uint32_t i = 0; i < 1024; i++) {
+		pde_t * entry = &p_directory->tables[i];
+		if(!pde_is_present(*entry) || !pde_is_user(*entry)) {
+			continue;
+		}
+		
+		page_table_t * table = (page_table_t *) PAGE_GET_PHYSICAL_ADDRESS((uint32_t *) entry);
+		for(uint32_t j = 0; j < 1024; j++) {
+			pte_t * page = &table->pages[j];
+			if(pte_is_present(*page)) {
+				pmm_free_block((void *) PAGE_GET_PHYSICAL_ADDRESS((uint32_t *) page));
+			}
+		}
+		
+		pmm_free_block(table);
+	}
+	
+	pmm_free_block(p_directory);
+}
+
 void paging_init(void) {
 	isr_install_handler(EXCEPTION_PAGE_FAULT, page_fault_handler);
 	
@@ -280,6 +402,7 @@ void paging_init(void) {
 	
 	current_page_dir_base_register = (uint32_t) &dir->tables;
 	
+	kernel_dir = dir;
 	vmm_switch_page_directory(dir);
 	
 	enable_paging();
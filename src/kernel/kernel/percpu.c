@@ -0,0 +1,32 @@
+#include <percpu.h>
+#include <gdt.h>
+#include <smp.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if SMP_MAX_CPUS > PERCPU_MAX_CPUS
+#error "Each CPU needs a per-CPU GDT entry"
+#endif
+
+static percpu_t percpu_areas[PERCPU_MAX_CPUS];	/**< The data of each CPU, each on its own cache lines. */
+
+void percpu_init(uint32_t cpu) {
+	percpu_t * area = &percpu_areas[cpu];
+	
+	memset(area, 0, sizeof(percpu_t));
+	area->self = area;
+	area->cpu_id = cpu;
+	
+	uint16_t selector = gdt_set_per_cpu(cpu, (uint32_t) area, sizeof(percpu_t));
+	__asm__ __volatile__ ("mov gs, %0" : : "r" (selector) : "memory");
+}
+
+percpu_t * percpu_get(uint32_t cpu) {
+	if(cpu >= PERCPU_MAX_CPUS) {
+		return NULL;
+	}
+	
+	return &percpu_areas[cpu];
+}
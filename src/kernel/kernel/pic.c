@@ -1,5 +1,20 @@
 #include <pic.h>
 
+static uint16_t pic_mask_shadow = 0xFFFF;	/**< The interrupt mask registers of both PIC's, bit n set if IRQ n is masked off. */
+
+/**
+ * \brief Write the half of the mask shadow that an IRQ is in to its PIC.
+ * 
+ * \param [in] irq The IRQ number.
+ */
+static void pic_write_mask(uint8_t irq) {
+	if(irq < 8) {
+		out_port_byte(PIC_INTERRUPT_MASK_REG_MASTER, (uint8_t) pic_mask_shadow);
+	} else {
+		out_port_byte(PIC_INTERRUPT_MASK_REG_SLAVE, (uint8_t) (pic_mask_shadow >> 8));
+	}
+}
+
 void pic_send_command_master(uint8_t cmd) {
 	out_port_byte(PIC_COMMAND_REG_MASTER, cmd);
 }
@@ -61,4 +76,33 @@ void pic_remap_irq(void) {
 	// Restore masks
 	pic_send_data_master(mask_m);
 	pic_send_data_slave(mask_s);
+	
+	// The masks are only read here, from then on only the shadow is read
+	pic_mask_shadow = (uint16_t) (mask_s << 8) | mask_m;
+}
+
+void pic_set_mask(uint8_t irq) {
+	// Reading the mask register is a slow port read, so only the shadow is read
+	pic_mask_shadow |= (uint16_t) (1 << irq);
+	pic_write_mask(irq);
+}
+
+void pic_clear_mask(uint8_t irq) {
+	pic_mask_shadow &= (uint16_t) ~(1 << irq);
+	pic_write_mask(irq);
+}
+
+uint16_t pic_get_mask(void) {
+	return pic_mask_shadow;
+}
+
+bool pic_is_level(uint8_t irq) {
+	(void) irq;
+	return false;
+}
+
+void pic_disable(void) {
+	pic_mask_shadow = 0xFFFF;
+	pic_send_data_master(0xFF);
+	pic_send_data_slave(0xFF);
 }
@@ -1,15 +1,14 @@
 #include <pit.h>
-#include <pic.h>
 #include <portio.h>
-#include <irq.h>
-#include <regs_t.h>
+#include <timer.h>
+#include <clockevent.h>
 
+#include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
 
-static volatile uint32_t pit_ticks;		/**< The number of tick that has passed when the PIT was initially set up. */
 static volatile uint32_t ram_ticks;		/**< The number of tick that has passed when the RAM timer was initially set up. */
 static volatile uint32_t speaker_ticks;	/**< The number of tick that has passed when the speaker timer was initially set up. */
-static uint16_t frequency;				/**< The frequency the PIT runs at. */
 
 /**
  * \brief Inline function to send a command to the PIT command register.
@@ -37,20 +36,88 @@ static void pit_send_data(uint8_t counter, uint8_t data) {
  * \param [in] counter The counter number to get the data from.
  * \return The data from the counter register.
  */
-/*static uint8_t pit_receive_data_counter(uint8_t counter) {
+static uint8_t pit_receive_data_counter(uint8_t counter) {
 	return in_port_byte(counter);
-}*/
+}
+
+/**
+ * \brief Latch and read the current count of counter 0.
+ * 
+ * \return The current count.
+ */
+static uint16_t pit_read_count(void) {
+	pit_send_command(PIT_OCW_SELECT_COUNTER_0 | PIT_OCW_READ_LOAD_LATCH);
+	uint8_t low = pit_receive_data_counter(PIT_REG_COUNTER_0);
+	uint8_t high = pit_receive_data_counter(PIT_REG_COUNTER_0);
+	return ((uint16_t) high << 8) | low;
+}
+
+/**
+ * \brief Load counter 0 with a mode and count.
+ * 
+ * \param [in] mode The mode of operation.
+ * \param [in] count The count to load.
+ */
+static void pit_load_counter_0(uint8_t mode, uint16_t count) {
+	pit_send_command(mode | PIT_OCW_READ_LOAD_DATA | PIT_OCW_SELECT_COUNTER_0);
+	pit_send_data(PIT_REG_COUNTER_0, count & 0xFF);
+	pit_send_data(PIT_REG_COUNTER_0, (count >> 8) & 0xFF);
+}
+
+/**
+ * \brief Run counter 0 in the rate generator mode. Unlike the square wave mode, the count goes
+ * down by one each clock, so can be read to find how much of a tick has passed.
+ * 
+ * \param [in] count The number of input clocks between each IRQ.
+ */
+static void pit_set_periodic(uint32_t count) {
+	pit_load_counter_0(PIT_OCW_MODE_RATE_GENERATOR | PIT_OCW_BINARY_COUNT_BINARY, (uint16_t) count);
+}
+
+/**
+ * \brief Run counter 0 in the terminal count mode, so raises the IRQ once.
+ * 
+ * \param [in] count The number of input clocks until the IRQ.
+ */
+static void pit_set_oneshot(uint32_t count) {
+	pit_load_counter_0(PIT_OCW_MODE_TERMINAL_COUNT | PIT_OCW_BINARY_COUNT_BINARY, (uint16_t) count);
+}
 
 /**
- * \brief The PIT handler that is called when the PIT creates an interrupt.
+ * \brief Get the current count of counter 0.
  * 
- * \param [in] regs The register of the CPU when the interrupt was called.
+ * \return The input clocks until the next IRQ.
  */
-static void pit_handler(regs_t * regs) {
-	(void) regs;		// Not using the registers
-	pit_ticks++;		// Increment tick count
+static uint32_t pit_get_count(void) {
+	return pit_read_count();
 }
 
+/**
+ * \brief Stop counter 0, once another device is the tick. The HPET can raise IRQ 0 on the same
+ * I/O APIC input, so the IRQ isn't masked. Loading the mode without a count stops the counter with
+ * its output low.
+ */
+static void pit_stop(void) {
+	pit_send_command(PIT_OCW_MODE_TERMINAL_COUNT | PIT_OCW_READ_LOAD_DATA | PIT_OCW_SELECT_COUNTER_0);
+}
+
+/**
+ * \brief Counter 0 as a clock event device. Is always there, so is the tick until a better device
+ * is registered.
+ */
+static clockevent_t pit_clockevent = {
+	"PIT",
+	CLOCKEVENT_PERIODIC | CLOCKEVENT_ONESHOT,
+	100,
+	PIT_INPUT_FREQUENCY,
+	0xFFFF,
+	pit_set_periodic,
+	pit_set_oneshot,
+	pit_get_count,
+	pit_stop,
+	NULL
+};
+
 /**
  * \todo Return error code if fail.
  */
@@ -71,8 +138,7 @@ void pit_setup_counter(uint16_t freq, uint8_t counter, uint8_t mode) {
 		return;
 	}
 	
-	uint16_t divisor = 1193180 / freq;
-	frequency = freq;
+	uint16_t divisor = PIT_INPUT_FREQUENCY / freq;
 	
 	uint8_t cmd = 0;
 	cmd |= mode;
@@ -86,40 +152,35 @@ void pit_setup_counter(uint16_t freq, uint8_t counter, uint8_t mode) {
 	pit_send_data(port, (divisor >> 8) & 0xff);		// Set the upper half
 	
 	// Reset the tick counter
-	if(counter == PIT_OCW_SELECT_COUNTER_0) {
-		pit_ticks = 0;
-	} else if (counter == PIT_OCW_SELECT_COUNTER_1) {
+	if (counter == PIT_OCW_SELECT_COUNTER_1) {
 		ram_ticks = 0;
 	} else if (counter == PIT_OCW_SELECT_COUNTER_2) {
 		speaker_ticks = 0;
 	}
 }
 
-uint32_t pit_get_ticks(void) {
-	return pit_ticks;
+void pit_wait(uint32_t milliseconds) {
+	// Sleep so other threads can run while waiting
+	sleep_ms(milliseconds);
 }
 
-uint16_t pit_get_frequency(void) {
-	return frequency;
+void pit_counter_2_start(uint16_t count) {
+	// Counting starts when the gate goes high, so load the count with it low
+	uint8_t gate = in_port_byte(PIT_REG_COUNTER_2_GATE) & ~(PIT_COUNTER_2_GATE | PIT_COUNTER_2_SPEAKER);
+	out_port_byte(PIT_REG_COUNTER_2_GATE, gate);
+	
+	pit_send_command(PIT_OCW_SELECT_COUNTER_2 | PIT_OCW_READ_LOAD_DATA | PIT_OCW_MODE_TERMINAL_COUNT | PIT_OCW_BINARY_COUNT_BINARY);
+	pit_send_data(PIT_REG_COUNTER_2, count & 0xFF);
+	pit_send_data(PIT_REG_COUNTER_2, (count >> 8) & 0xFF);
+	
+	out_port_byte(PIT_REG_COUNTER_2_GATE, gate | PIT_COUNTER_2_GATE);
 }
 
-void pit_wait(uint32_t milliseconds) {
-	/**
-	 * \todo Have a check so not to over flow.
-	 */
-	uint32_t eticks = pit_ticks + milliseconds;
-	while(pit_ticks < eticks) {
-		__asm__ __volatile__ ("sti");
-		__asm__ __volatile__ ("hlt");
-		__asm__ __volatile__ ("cli");
-	}
+bool pit_counter_2_done(void) {
+	return in_port_byte(PIT_REG_COUNTER_2_GATE) & PIT_COUNTER_2_OUTPUT;
 }
 
 void pit_init(void) {
-	// Set up counter 0 at 1000hz in a square wave mode counting in binary
-	frequency = 1000;
-	pit_setup_counter(frequency, PIT_OCW_SELECT_COUNTER_0, PIT_OCW_MODE_SQUARE_WAVE_GENERATOR | PIT_OCW_BINARY_COUNT_BINARY);
-	
-	// Installs 'pit_handler' to IRQ0 (PIC_IRQ_TIMER)
-	irq_install_handler(PIC_IRQ_TIMER, pit_handler);
+	// Counter 0 is the tick until a better device is registered
+	clockevent_register(&pit_clockevent);
 }
@@ -1,4 +1,6 @@
 #include <pmm.h>
+#include <alloc_trace.h>
+#include <spinlock.h>
 
 #include <string.h>
 #include <stdio.h>
@@ -12,6 +14,7 @@ static uint32_t max_blocks;						/**< This is the total number of blocks that ca
 static uint32_t * memory_bit_map;				/**< This is the pointer to the bit map structure for showing what blocks have been allocated and are in use. */
 static uint32_t memory_bitmap_block_offset;		/**< The number block that the memory bitmap is located at. */
 static uint32_t memory_bitmap_block_size;		/**< The number of blocks the the memory bitmap takes up. */
+static spinlock_t pmm_lock;						/**< Protects the bit map and used block count. */
 
 /**
  * \brief Set a bit in the memory bitmap to say that it has been allocated.
@@ -121,28 +124,30 @@ uint32_t pmm_get_free_blocks(void) {
 }
 
 void * pmm_alloc_block(void) {
-	if(pmm_get_free_blocks() <= 0) {
-		return NULL;		// No more memory
-	}
+	uint32_t flags = spin_lock_irqsave(&pmm_lock);
 	
 	uint32_t frame;
-	if(!get_first_free_block(&frame)) {
+	if(pmm_get_free_blocks() <= 0 || !get_first_free_block(&frame)) {
+		spin_unlock_irqrestore(&pmm_lock, flags);
 		return NULL;		// No more memory
 	}
 	
 	set_map_bit(frame);
 	used_blocks++;
 	
-	return (void *) (frame * PMM_BLOCK_SIZE);
+	void * ptr = (void *) (frame * PMM_BLOCK_SIZE);
+	alloc_trace_alloc(__builtin_return_address(0), ptr, PMM_BLOCK_SIZE);
+	
+	spin_unlock_irqrestore(&pmm_lock, flags);
+	return ptr;
 }
 
 void * pmm_alloc_blocks(uint32_t num_blocks) {
-	if(pmm_get_free_blocks() <= num_blocks) {
-		return NULL;		// Not enough memory
-	}
+	uint32_t flags = spin_lock_irqsave(&pmm_lock);
 	
 	uint32_t frame;
-	if(!get_first_free_blocks(&frame, num_blocks)) {
+	if(pmm_get_free_blocks() <= num_blocks || !get_first_free_blocks(&frame, num_blocks)) {
+		spin_unlock_irqrestore(&pmm_lock, flags);
 		return NULL;		// Not enough memory
 	}
 	
@@ -152,24 +157,40 @@ void * pmm_alloc_blocks(uint32_t num_blocks) {
 	
 	used_blocks += num_blocks;
 	
-	return (void *) (frame * PMM_BLOCK_SIZE);
+	void * ptr = (void *) (frame * PMM_BLOCK_SIZE);
+	alloc_trace_alloc(__builtin_return_address(0), ptr, PMM_BLOCK_SIZE * num_blocks);
+	
+	spin_unlock_irqrestore(&pmm_lock, flags);
+	return ptr;
 }
 
 void pmm_free_block(void * ptr) {
 	uint32_t frame = (uint32_t) ptr / PMM_BLOCK_SIZE;
 	
+	uint32_t flags = spin_lock_irqsave(&pmm_lock);
+	
 	unset_map_bit(frame);
 	used_blocks--;
+	
+	alloc_trace_free(ptr);
+	
+	spin_unlock_irqrestore(&pmm_lock, flags);
 }
 
 void pmm_free_blocks(void * ptr, uint32_t num_blocks) {
 	uint32_t frame = (uint32_t) ptr / PMM_BLOCK_SIZE;
 	
+	uint32_t flags = spin_lock_irqsave(&pmm_lock);
+	
 	for(uint32_t i = 0; i < num_blocks; i++) {
 		unset_map_bit(frame + i);
 	}
 	
 	used_blocks -= num_blocks;
+	
+	alloc_trace_free(ptr);
+	
+	spin_unlock_irqrestore(&pmm_lock, flags);
 }
 
 void pmm_init_region(uint32_t base, uint32_t length) {
@@ -213,6 +234,8 @@ void pmm_uninit_region(uint32_t base, uint32_t length) {
 }
 
 void pmm_init(uint32_t mem_size, uint32_t * bit_map) {
+	spin_lock_init(&pmm_lock, "pmm");
+	
 	total_memory_size = mem_size;
 	memory_bit_map = bit_map;
 	memory_bitmap_block_offset = (uint32_t) bit_map / PMM_BLOCK_SIZE;
@@ -0,0 +1,166 @@
+#include <process.h>
+#include <thread.h>
+#include <paging.h>
+#include <gdt.h>
+#include <pmm.h>
+#include <wait.h>
+#include <interrupt.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * \brief Enter ring 3 with interrupts enabled. Interrupts must be disabled, as the kernel's GS is
+ * replaced before the return.
+ * 
+ * \param [in] eip Where to start running.
+ * \param [in] esp The user stack.
+ * \param [in] eax The value in EAX.
+ */
+extern noreturn void _user_enter(uint32_t eip, uint32_t esp, uint32_t eax);
+
+/**
+ * \brief The thread of a process, which takes on the address space and enters ring 3.
+ * 
+ * \param [in] arg The process.
+ */
+static void process_start(void * arg) {
+	process_t * process = (process_t *) arg;
+	thread_t * thread = thread_current();
+	
+	// Nothing can switch thread between taking on the address space and entering ring 3
+	interrupt_disable();
+	thread->process = process;
+	process_switch(thread);
+	
+	_user_enter(PROCESS_USER_BASE, PROCESS_USER_END, process->arg);
+}
+
+/**
+ * \brief Allocate a page, copy part of the code into it and map it into the process.
+ * 
+ * \param [in] directory The page directory of the process.
+ * \param [in] virtual_addr The user address of the page.
+ * \param [in] data What to copy to the start of the page, the rest is zeroed. Can be NULL.
+ * \param [in] size The number of bytes to copy.
+ * 
+ * \return Whether the page was mapped.
+ */
+static bool process_map_page(page_directory_t * directory, uint32_t virtual_addr, const void * data, uint32_t size) {
+	void * page = pmm_alloc_block();
+	if(!page) {
+		return false;
+	}
+	
+	memset(page, 0, PMM_BLOCK_SIZE);
+	if(data) {
+		memcpy(page, data, size);
+	}
+	
+	if(!vmm_map_user_page(directory, page, (void *) virtual_addr)) {
+		pmm_free_block(page);
+		return false;
+	}
+	
+	return true;
+}
+
+bool process_create(process_t * process, const char * name, const void * code, uint32_t size, uint32_t arg) {
+	uint32_t code_blocks = (size + PMM_BLOCK_SIZE - 1) / PMM_BLOCK_SIZE;
+	if(code_blocks + PROCESS_STACK_BLOCKS > (PROCESS_USER_END - PROCESS_USER_BASE) / PMM_BLOCK_SIZE) {
+		return false;
+	}
+	
+	process->directory = vmm_create_address_space();
+	if(!process->directory) {
+		return false;
+	}
+	
+	for(uint32_t i = 0; i < code_blocks; i++) {
+		uint32_t offset = i * PMM_BLOCK_SIZE;
+		uint32_t length = size - offset < PMM_BLOCK_SIZE ? size - offset : PMM_BLOCK_SIZE;
+		if(!process_map_page(process->directory, PROCESS_USER_BASE + offset, (const uint8_t *) code + offset, length)) {
+			vmm_destroy_address_space(process->directory);
+			return false;
+		}
+	}
+	
+	for(uint32_t i = 1; i <= PROCESS_STACK_BLOCKS; i++) {
+		if(!process_map_page(process->directory, PROCESS_USER_END - i * PMM_BLOCK_SIZE, NULL, 0)) {
+			vmm_destroy_address_space(process->directory);
+			return false;
+		}
+	}
+	
+	process->arg = arg;
+	process->exit_code = 0;
+	completion_init(&process->exited);
+	
+	process->thread = thread_create(name, process_start, process, THREAD_PRIORITY_NORMAL);
+	if(!process->thread) {
+		vmm_destroy_address_space(process->directory);
+		return false;
+	}
+	
+	return true;
+}
+
+uint32_t process_wait(process_t * process) {
+	wait_for_completion(&process->exited);
+	
+	// The thread switched back to the kernel's page directory before completing
+	vmm_destroy_address_space(process->directory);
+	process->directory = NULL;
+	
+	return process->exit_code;
+}
+
+noreturn void process_exit(uint32_t code) {
+	interrupt_disable();
+	
+	thread_t * thread = thread_current();
+	process_t * process = thread->process;
+	
+	// The waiter frees the address space, so stop using it first
+	thread->process = NULL;
+	vmm_switch_page_directory(vmm_get_kernel_directory());
+	
+	process->exit_code = code;
+	complete_all(&process->exited);
+	
+	thread_exit();
+}
+
+noreturn void process_fault(regs_t * regs, const char * msg) {
+	kprintf("Process %s: %s at 0x%08X (error code: 0x%X)\n", thread_current()->name, msg, regs->eip, regs->error_code);
+	process_exit(PROCESS_EXIT_FAULT);
+}
+
+void process_switch(thread_t * next) {
+	page_directory_t * directory = vmm_get_kernel_directory();
+	
+	if(next->process) {
+		directory = next->process->directory;
+		
+		// Ring 3 enters the kernel on the top of the thread's own stack
+		gdt_set_kernel_stack((uint32_t) next->stack + THREAD_STACK_BLOCKS * PMM_BLOCK_SIZE);
+	}
+	
+	// Loading CR3 flushes the TLB, so only when the address space changes
+	if(vmm_get_directory() != directory) {
+		vmm_switch_page_directory(directory);
+	}
+}
+
+bool process_is_user_range(uint32_t addr, uint32_t size) {
+	if(addr < PROCESS_USER_BASE || addr > PROCESS_USER_END || size > PROCESS_USER_END - addr) {
+		return false;
+	}
+	
+	// Only the code and the stack are mapped, so the kernel would fault on the gap between them
+	process_t * process = thread_current()->process;
+	return process && vmm_is_user_range(process->directory, addr, size);
+}
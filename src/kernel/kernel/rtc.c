@@ -6,12 +6,22 @@
 #include <tty.h>
 #include <pic.h>
 #include <cmos.h>
+#include <work.h>
+#include <async.h>
+#include <thread.h>
+#include <timekeeping.h>
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
 
 static bool daylight_savings;	/**< Whether the clock (in UK) is 1 hour ahead. */
 
+static uint32_t rtc_updates = 0;	/**< The number of updates since the wall clock was last set from the RTC. */
+static async_event_t rtc_event;		/**< Signalled each time the RTC updates, once a second. */
+static async_t rtc_clock_task;		/**< Redraws the time on the screen, as reading the RTC and printing are too slow for the IRQ handler. */
+
 static uint8_t century_reg = 0;	/**< The register location for returning the century. As some CMOS chips don't support the
 									century register, and accessing it could lead to undefined results. The CMOS will set this if
 									there is a century register, else it will stay zero. So check this value, and if not zero, then
@@ -32,6 +42,19 @@ static uint8_t get_update_in_progress_flag(void) {
 	return (cmos_read(CMOS_REG_STATUS_A) & 0x80);
 }
 
+/**
+ * \brief Wait until the RTC has finished updating the date and time. The update takes under 2ms,
+ * so a thread sleeps a tick at a time so other threads can run. The deferred work and the boot code
+ * can't sleep, so spin instead.
+ */
+static void rtc_wait_update(void) {
+	while(get_update_in_progress_flag()) {
+		if(thread_current() && !work_in_progress()) {
+			thread_sleep(1);
+		}
+	}
+}
+
 /**
  * \brief Calculate the day of the week from the supplied date.
  * 
@@ -41,8 +64,8 @@ static uint8_t get_update_in_progress_flag(void) {
  */
 static rtc_date_time_t * day_of_week(rtc_date_time_t * date) {
 	static const int t[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
-	date->year -= date->month < 3;
-	date->day_of_week = (date->year + date->year/4 - date->year/100 + date->year/400 + t[date->month-1] + date->day) % 7;
+	uint16_t year = date->year - (date->month < 3);
+	date->day_of_week = (year + year/4 - year/100 + year/400 + t[date->month-1] + date->day) % 7;
 	return date;
 }
 
@@ -55,71 +78,58 @@ static void human_clock_init(void) {
 	daylight_savings = true;
 }
 
-rtc_date_time_t * read_rtc(rtc_date_time_t * date, const bool hour_24h) {
-	uint8_t second;
-	uint8_t minute;
-	uint8_t hour;
-	uint8_t day;
-	uint8_t month;
-	uint16_t year;
-	uint8_t century;
-	
-	uint8_t last_second;
-	uint8_t last_minute;
-	uint8_t last_hour;
-	uint8_t last_day;
-	uint8_t last_month;
-	uint16_t last_year;
-	uint8_t last_century;
-	
-	uint8_t reg_B;
-	
-	if(!date) {
-		return NULL;
-	}
-	
-	while(get_update_in_progress_flag());
-	
-	second = cmos_read(CMOS_REG_SECOND);
-	minute = cmos_read(CMOS_REG_MINUTE);
-	hour = cmos_read(CMOS_REG_HOUR);
-	day = cmos_read(CMOS_REG_DAY);
-	month = cmos_read(CMOS_REG_MONTH);
-	year = cmos_read(CMOS_REG_YEAR);
+/**
+ * \brief Read the date and time registers once, without converting them. The RTC may be part way
+ * through an update.
+ * 
+ * \param [out] date The date and time as read from the registers.
+ */
+static void rtc_read_registers(rtc_date_time_t * date) {
+	date->second = cmos_read(CMOS_REG_SECOND);
+	date->minute = cmos_read(CMOS_REG_MINUTE);
+	date->hour = cmos_read(CMOS_REG_HOUR);
+	date->day = cmos_read(CMOS_REG_DAY);
+	date->month = cmos_read(CMOS_REG_MONTH);
+	date->year = cmos_read(CMOS_REG_YEAR);
 	
 	if(century_reg) {
-		century = cmos_read(century_reg);
+		date->century = cmos_read(century_reg);
 	} else {
-		century = -1;
+		date->century = -1;
 	}
+}
+
+/**
+ * \brief Get whether two reads of the registers are the same.
+ * 
+ * \param [in] d1 The first read.
+ * \param [in] d2 The second read.
+ * 
+ * \return Whether all the registers are the same.
+ */
+static bool rtc_same_registers(const rtc_date_time_t * d1, const rtc_date_time_t * d2) {
+	return d1->second == d2->second && d1->minute == d2->minute && d1->hour == d2->hour && d1->day == d2->day && d1->month == d2->month && d1->year == d2->year && d1->century == d2->century;
+}
+
+/**
+ * \brief Convert the registers as read from the RTC into the date and time.
+ * 
+ * \param [in] date The registers, converted in place.
+ * \param [in] hour_24h Whether the time is to be in 24hr format or 12hr format.
+ * \param [in] daylight Whether to add the daylight savings hour.
+ * 
+ * \return The pointer to the date structure.
+ */
+static rtc_date_time_t * rtc_convert(rtc_date_time_t * date, const bool hour_24h, const bool daylight) {
+	uint8_t second = date->second;
+	uint8_t minute = date->minute;
+	uint8_t hour = date->hour;
+	uint8_t day = date->day;
+	uint8_t month = date->month;
+	uint16_t year = date->year;
+	uint8_t century = date->century;
 	
-	// Read the registers twice and check if they are the same so to avoid inconsistent values due to RTC updates
-	do {
-		last_second = second;
-		last_minute = minute;
-		last_hour = hour;
-		last_day = day;
-		last_month = month;
-		last_year = year;
-		last_century = century;
-		
-		while(get_update_in_progress_flag());
-		
-		second = cmos_read(CMOS_REG_SECOND);
-		minute = cmos_read(CMOS_REG_MINUTE);
-		hour = cmos_read(CMOS_REG_HOUR);
-		day = cmos_read(CMOS_REG_DAY);
-		month = cmos_read(CMOS_REG_MONTH);
-		year = cmos_read(CMOS_REG_YEAR);
-		
-		if(century_reg) {
-			century = cmos_read(century_reg);
-		} else {
-			century = -1;
-		}
-	} while ((last_second != second) || (last_minute != minute) || (last_hour != hour) || (last_day != day) || (last_month != month) || (last_year != year) || (last_century != century));
-	
-	reg_B = cmos_read(CMOS_REG_STATUS_B);
+	uint8_t reg_B = cmos_read(CMOS_REG_STATUS_B);
 	
 	// Convert BCD to binary if necessary
 	if(!(reg_B & 0x04)) {
@@ -139,7 +149,7 @@ rtc_date_time_t * read_rtc(rtc_date_time_t * date, const bool hour_24h) {
 		hour = ((hour & 0x7F) + 12) % 24;
 	} // Else 12 hour
 	
-	if(daylight_savings && hour_24h) {
+	if(daylight && hour_24h) {
 		if(hour == 23) {
 			hour = 0;
 		} else {
@@ -165,6 +175,103 @@ rtc_date_time_t * read_rtc(rtc_date_time_t * date, const bool hour_24h) {
 	return day_of_week(date);
 }
 
+/**
+ * \brief Read the date and time registers, waiting for any update to finish. The registers are
+ * read twice and checked that they are the same, to avoid inconsistent values due to RTC updates.
+ * 
+ * \param [out] date The date and time as read from the registers.
+ */
+static void rtc_read_stable(rtc_date_time_t * date) {
+	rtc_date_time_t last;
+	
+	rtc_wait_update();
+	rtc_read_registers(date);
+	
+	do {
+		last = *date;
+		rtc_wait_update();
+		rtc_read_registers(date);
+	} while(!rtc_same_registers(&last, date));
+}
+
+rtc_date_time_t * read_rtc(rtc_date_time_t * date, const bool hour_24h) {
+	if(!date) {
+		return NULL;
+	}
+	
+	rtc_read_stable(date);
+	return rtc_convert(date, hour_24h, daylight_savings);
+}
+
+/**
+ * \brief Convert the date and time from the RTC to the number of seconds since 1970. The RTC is
+ * kept in UTC, so it must have been converted without the daylight savings hour.
+ * 
+ * \param [in] date The date and time in 24hr format.
+ * 
+ * \return The number of seconds since 1970.
+ */
+static time_t rtc_to_time(const rtc_date_time_t * date) {
+	struct tm tm = {
+		.tm_sec = date->second,
+		.tm_min = date->minute,
+		.tm_hour = date->hour,
+		.tm_mday = date->day,
+		.tm_mon = date->month - 1,
+		.tm_year = date->year - 1900
+	};
+	
+	return mktime(&tm);
+}
+
+/**
+ * \brief Set the wall clock from the registers of the RTC.
+ * 
+ * \param [in] date The registers as read from the RTC, converted in place.
+ */
+static void rtc_sync(rtc_date_time_t * date) {
+	rtc_convert(date, true, false);
+	timekeeping_sync(rtc_to_time(date));
+}
+
+int32_t rtc_get_utc_offset(void) {
+	return daylight_savings ? 3600 : 0;
+}
+
+/**
+ * \brief Split a wall clock time into the local date and time.
+ * 
+ * \param [in] now The number of seconds since 1970 in UTC.
+ * \param [out] date The local date and time.
+ * 
+ * \return The pointer to the date structure.
+ */
+static rtc_date_time_t * rtc_split_time(time_t now, rtc_date_time_t * date) {
+	// Adding the offset before splitting up the date carries the hour into the day, month and year
+	now += rtc_get_utc_offset();
+	struct tm tm;
+	gmtime_r(&now, &tm);
+	
+	date->second = tm.tm_sec;
+	date->minute = tm.tm_min;
+	date->hour = tm.tm_hour;
+	date->day = tm.tm_mday;
+	date->month = tm.tm_mon + 1;
+	date->year = tm.tm_year + 1900;
+	date->century = date->year / 100;
+	date->day_of_week = tm.tm_wday;
+	
+	return date;
+}
+
+rtc_date_time_t * rtc_get_date_time(rtc_date_time_t * date) {
+	if(!date) {
+		return NULL;
+	}
+	
+	return rtc_split_time(time(NULL), date);
+}
+
 rtc_date_time_t * zero_date_time(rtc_date_time_t * d1) {
 	if (d1 == NULL) {
 		return NULL;
@@ -202,43 +309,83 @@ rtc_date_time_t * copy_date_time(rtc_date_time_t * d1, rtc_date_time_t * d2) {
 void set_rate(uint8_t rate) {
 	rate &= 0x0F;			// Rate must be above 2 and not over 15, so mask out the upper bits
 	
-	interrupt_disable();
-	uint8_t prev = cmos_read(CMOS_ENABLE_NMI | CMOS_REG_STATUS_A);
-	cmos_write(CMOS_ENABLE_NMI | CMOS_REG_STATUS_A, (prev & 0xF0) | rate);
-	interrupt_enable();
+	cmos_modify(CMOS_ENABLE_NMI | CMOS_REG_STATUS_A, 0x0F, rate);
+}
+
+/**
+ * \brief The coroutine that redraws the time on the screen each second, after the RTC interrupt
+ * has updated it.
+ * 
+ * \param [in] task The coroutine.
+ * 
+ * \return Never finishes.
+ */
+static async_status_t rtc_clock(async_t * task) {
+	ASYNC_BEGIN(task);
+	
+	while(true) {
+		ASYNC_WAIT_EVENT(task, &rtc_event);
+		
+		// Woken just after the RTC went on to the next second, which the wall clock can have drifted
+		// a little either side of, so round to the nearest second
+		rtc_date_time_t date;
+		tty_set_time(rtc_split_time(timekeeping_get_time_nearest(), &date));
+		tty_set_display_time();
+	}
+	
+	ASYNC_END(task);
 }
 
 /**
- * \brief The RTC handler that is called when the RTC creates an interrupt.
+ * \brief The RTC handler that is called when the RTC creates an interrupt. Every
+ * \ref RTC_RESYNC_SECONDS the wall clock is set from the RTC again. This is the only place it is set
+ * on a second boundary. Once the RTC has finished updating, the registers won't change for a
+ * second, so are read once without waiting.
  * 
  * \param [in] regs The register of the CPU when the interrupt was called.
  */
 static void rtc_handler(regs_t * regs) {
 	(void) regs;
-	/**
-	 * \todo May change to update internal time and have get time function and other function poll this.
-	 */
-	tty_set_display_time();
 	
-	// Need to read the status register C so the next interrupt can be issued.
-	cmos_read(CMOS_REG_STATUS_C);
+	// Need to read the status register C so the next interrupt can be issued. It also says which
+	// interrupt this was
+	uint8_t status = cmos_read(CMOS_REG_STATUS_C);
+	
+	if(status & RTC_STATUS_C_UPDATE_ENDED) {
+		if(++rtc_updates >= RTC_RESYNC_SECONDS) {
+			rtc_date_time_t date;
+			rtc_read_registers(&date);
+			rtc_sync(&date);
+			rtc_updates = 0;
+		}
+		
+		async_event_signal(&rtc_event);
+	}
 }
 
 void rtc_init(void) {
 	human_clock_init();
 	
-	// Install the handler for the real time clock
-	irq_install_handler(PIC_IRQ_CMOS_REALT_TIME_CLOCK, rtc_handler);
+	// Set the wall clock, so it can be read before the first interrupt. This is part way through a
+	// second, so the first update-ended interrupt sets it again on the second boundary
+	rtc_date_time_t date;
+	rtc_read_stable(&date);
+	rtc_sync(&date);
+	rtc_updates = RTC_RESYNC_SECONDS;
+	
+	async_event_init(&rtc_event);
+	async_start(&rtc_clock_task, rtc_clock, NULL);
 	
-	// Set the rate of interrupts to every half a second.
-	set_rate(15);
+	// Draw the time straight away, which isn't on a second boundary so isn't rounded
+	tty_set_time(rtc_get_date_time(&date));
+	tty_set_display_time();
 	
-	// Disable interrupts
-	interrupt_disable();
+	// Install the handler for the real time clock
+	irq_install_handler(PIC_IRQ_CMOS_REALT_TIME_CLOCK, rtc_handler);
 	
-	uint8_t prev = cmos_read(CMOS_ENABLE_NMI | CMOS_REG_STATUS_B);
-	cmos_write(CMOS_ENABLE_NMI | CMOS_REG_STATUS_B, prev | 0x40);
+	// Turn on the interrupt after each update, instead of the periodic interrupt
+	cmos_modify(CMOS_ENABLE_NMI | CMOS_REG_STATUS_B, RTC_STATUS_B_PERIODIC, RTC_STATUS_B_UPDATE_ENDED);
 	
-	// Re-enable interrupts
-	interrupt_enable();
+	// Clear any interrupt that was already raised, so the next one is
+	cmos_read(CMOS_REG_STATUS_C);
 }
@@ -0,0 +1,254 @@
+#include <smp.h>
+#include <acpi.h>
+#include <lapic.h>
+#include <idt.h>
+#include <percpu.h>
+#include <fpu.h>
+#include <pmm.h>
+#include <timer.h>
+#include <wait.h>
+#include <interrupt.h>
+#include <cpu.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdnoreturn.h>
+#include <string.h>
+#include <stdio.h>
+
+extern uint8_t _smp_trampoline_start[];
+extern uint8_t _smp_trampoline_gdt_ptr[];
+extern uint8_t _smp_trampoline_end[];
+
+uint32_t smp_ap_cr3;						/**< The page directory for the starting CPU, read by the trampoline. */
+uint32_t smp_ap_stack;						/**< The top of the stack for the starting CPU, read by the trampoline. */
+
+static cpu_t * volatile smp_ap_cpu;			/**< The CPU being started. */
+static cpu_t cpus[SMP_MAX_CPUS];			/**< The data for each online CPU. */
+static uint32_t cpu_count = 1;				/**< The number of online CPUs. */
+static semaphore_t smp_call_lock;			/**< Only one thread can give the CPUs work at a time. */
+
+/**
+ * \brief The idle loop of an application processor. Halts until woken by an IPI, then runs the
+ * function from \ref smp_call if it has one.
+ * 
+ * \param [in] cpu The CPU running the loop.
+ */
+static noreturn void smp_idle(cpu_t * cpu) {
+	while(1) {
+		interrupt_disable();
+		
+		smp_func_t func = __atomic_load_n(&cpu->func, __ATOMIC_ACQUIRE);
+		if(func) {
+			cpu->func = NULL;
+			interrupt_enable();
+			
+			func(cpu->id, cpu->arg);
+			cpu->calls++;
+			__atomic_store_n(&cpu->done, true, __ATOMIC_RELEASE);
+			continue;
+		}
+		
+		// Interrupts aren't taken until after the hlt, so can't miss the wake up
+		__asm__ __volatile__ ("sti");
+		__asm__ __volatile__ ("hlt");
+		cpu->wakeups++;
+	}
+}
+
+/**
+ * \brief The first C function an application processor runs, from the trampoline with paging on
+ * and the stack set up.
+ */
+noreturn void smp_ap_main(void) {
+	cpu_t * cpu = smp_ap_cpu;
+	
+	// The trampoline loaded the flat data segment into GS
+	percpu_init(cpu->id);
+	idt_load_cpu();
+	fpu_init_cpu();
+	lapic_enable();
+	
+	// Tell the boot CPU it can start the next one
+	__atomic_store_n(&cpu->online, true, __ATOMIC_RELEASE);
+	
+	smp_idle(cpu);
+}
+
+/**
+ * \brief Wait for a CPU being started to come online.
+ * 
+ * \param [in] cpu The CPU.
+ * \param [in] milliseconds The longest time to wait.
+ * 
+ * \return Whether the CPU came online.
+ */
+static bool smp_wait_online(cpu_t * cpu, uint32_t milliseconds) {
+	for(uint32_t i = 0; i < milliseconds; i++) {
+		if(__atomic_load_n(&cpu->online, __ATOMIC_ACQUIRE)) {
+			return true;
+		}
+		sleep_ms(1);
+	}
+	return __atomic_load_n(&cpu->online, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * \brief Start an application processor with INIT-SIPI-SIPI.
+ * 
+ * \param [in] apic_id The local APIC ID of the CPU.
+ * \param [in] trampoline The page below 1MB the trampoline was copied to.
+ * 
+ * \return Whether the CPU came online.
+ */
+static bool smp_start_cpu(uint8_t apic_id, uint8_t * trampoline) {
+	cpu_t * cpu = &cpus[cpu_count];
+	
+	void * stack = pmm_alloc_blocks(SMP_STACK_BLOCKS);
+	if(!stack) {
+		return false;
+	}
+	
+	cpu->id = cpu_count;
+	cpu->apic_id = apic_id;
+	cpu->online = false;
+	cpu->stack = stack;
+	cpu->func = NULL;
+	cpu->arg = NULL;
+	cpu->done = true;
+	cpu->calls = 0;
+	cpu->wakeups = 0;
+	
+	smp_ap_cpu = cpu;
+	smp_ap_stack = (uint32_t) stack + SMP_STACK_BLOCKS * PMM_BLOCK_SIZE;
+	
+	lapic_send_init(apic_id);
+	sleep_ms(10);
+	
+	// The second startup IPI is only needed if the first was missed
+	uint8_t page = (uint8_t) ((uint32_t) trampoline / PMM_BLOCK_SIZE);
+	lapic_send_startup(apic_id, page);
+	if(!smp_wait_online(cpu, 1)) {
+		lapic_send_startup(apic_id, page);
+		if(!smp_wait_online(cpu, SMP_START_TIMEOUT)) {
+			// The CPU could still answer the startup IPI late, and run on the freed stack as the
+			// next CPU's slot. Put it back to waiting for a startup IPI before freeing anything
+			lapic_send_init(apic_id);
+			cpu->online = false;
+			pmm_free_blocks(stack, SMP_STACK_BLOCKS);
+			cpu->stack = NULL;
+			return false;
+		}
+	}
+	
+	cpu_count++;
+	return true;
+}
+
+void smp_init(void) {
+	semaphore_init(&smp_call_lock, 1);
+	
+	cpus[0].id = 0;
+	cpus[0].online = true;
+	cpus[0].done = true;
+	
+	uint32_t num_cpus = acpi_get_cpu_count();
+	uint32_t lapic_address = acpi_get_lapic_address();
+	if(num_cpus == 0 || !lapic_address) {
+		kprintf("SMP: No MADT, only using the boot CPU\n");
+		return;
+	}
+	
+	lapic_init(lapic_address);
+	lapic_enable();
+	cpus[0].apic_id = lapic_get_id();
+	
+	if(num_cpus == 1) {
+		return;
+	}
+	
+	// The startup IPI can only start a CPU at a page below 1MB, which the low blocks are
+	uint8_t * trampoline = (uint8_t *) pmm_alloc_block();
+	if(!trampoline || (uint32_t) trampoline >= 0x100000) {
+		kprintf("SMP: No memory below 1MB for the trampoline\n");
+		if(trampoline) {
+			pmm_free_block(trampoline);
+		}
+		return;
+	}
+	
+	memcpy(trampoline, _smp_trampoline_start, _smp_trampoline_end - _smp_trampoline_start);
+	
+	// The trampoline loads the same GDT, and the CPUs use the same page directory
+	uint8_t * gdt_ptr = trampoline + (_smp_trampoline_gdt_ptr - _smp_trampoline_start);
+	__asm__ __volatile__ ("sgdt [%0]" : : "r" (gdt_ptr) : "memory");
+	__asm__ __volatile__ ("mov %0, cr3" : "=r" (smp_ap_cr3));
+	
+	for(uint32_t i = 0; i < num_cpus && cpu_count < SMP_MAX_CPUS; i++) {
+		uint8_t apic_id = acpi_get_lapic_id(i);
+		if(apic_id == cpus[0].apic_id) {
+			continue;
+		}
+		
+		if(!smp_start_cpu(apic_id, trampoline)) {
+			kprintf("SMP: CPU with APIC ID %u didn't start\n", apic_id);
+		}
+	}
+	
+	// All the CPUs are past the trampoline
+	pmm_free_block(trampoline);
+}
+
+uint32_t smp_get_cpu_count(void) {
+	return cpu_count;
+}
+
+cpu_t * smp_get_cpu(uint32_t id) {
+	if(id >= cpu_count) {
+		return NULL;
+	}
+	
+	return &cpus[id];
+}
+
+uint32_t smp_get_cpu_id(void) {
+	return this_cpu_read(cpu_id);
+}
+
+void smp_call(uint32_t num_cpus, smp_func_t func, void * arg) {
+	if(num_cpus > cpu_count) {
+		num_cpus = cpu_count;
+	}
+	
+	semaphore_down(&smp_call_lock);
+	
+	for(uint32_t i = 1; i < num_cpus; i++) {
+		cpus[i].done = false;
+		cpus[i].arg = arg;
+		__atomic_store_n(&cpus[i].func, func, __ATOMIC_RELEASE);
+		lapic_send_ipi(cpus[i].apic_id, LAPIC_IPI_VECTOR);
+	}
+	
+	// The boot CPU does its share too
+	if(num_cpus > 0) {
+		func(0, arg);
+		cpus[0].calls++;
+	}
+	
+	for(uint32_t i = 1; i < num_cpus; i++) {
+		while(!__atomic_load_n(&cpus[i].done, __ATOMIC_ACQUIRE)) {
+			cpu_pause();
+		}
+	}
+	
+	semaphore_up(&smp_call_lock);
+}
+
+void smp_dump(void) {
+	kprintf("CPU\tAPIC ID\tCalls\tWakeups\n");
+	for(uint32_t i = 0; i < cpu_count; i++) {
+		kprintf("%u\t%u\t%u\t%u\n", cpus[i].id, cpus[i].apic_id, cpus[i].calls, cpus[i].wakeups);
+	}
+	kprintf("%u CPUs online\n", cpu_count);
+}
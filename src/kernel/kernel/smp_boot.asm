@@ -0,0 +1,61 @@
+	[bits	16]
+	section	.text
+	
+	[extern	smp_ap_cr3]
+	[extern	smp_ap_stack]
+	[extern	smp_ap_main]
+
+;
+; The application processors start here in real mode, at the start of the page given in the startup
+; IPI. This part is copied to a page below 1MB, so only uses offsets from the start.
+;
+global _smp_trampoline_start
+_smp_trampoline_start:
+	cli
+	cld
+	mov		ax, cs
+	mov		ds, ax
+	
+	; Load the kernel GDT that the boot CPU stored below
+	o32 lgdt	[_smp_trampoline_gdt_ptr - _smp_trampoline_start]
+	
+	; Turn on protected mode
+	mov		eax, cr0
+	or		eax, 1
+	mov		cr0, eax
+	
+	; The kernel is identity mapped, so can jump straight to it
+	jmp		dword 0x08:_smp_ap_protected
+	
+	align	4
+global _smp_trampoline_gdt_ptr
+_smp_trampoline_gdt_ptr:
+	dw		0
+	dd		0
+global _smp_trampoline_end
+_smp_trampoline_end:
+
+	[bits	32]
+
+_smp_ap_protected:
+	mov		ax, 0x10
+	mov		ds, ax
+	mov		es, ax
+	mov		fs, ax
+	mov		gs, ax
+	mov		ss, ax
+	
+	; Use the same page directory as the boot CPU. The INIT leaves the caches off, so turn them on
+	mov		eax, [smp_ap_cr3]
+	mov		cr3, eax
+	mov		eax, cr0
+	and		eax, 0x9FFFFFFF
+	or		eax, 0x80000000
+	mov		cr0, eax
+	
+	mov		esp, [smp_ap_stack]
+	call	smp_ap_main
+.halt:
+	cli
+	hlt
+	jmp		.halt
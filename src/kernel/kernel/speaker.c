@@ -1,8 +1,82 @@
 #include <speaker.h>
 #include <portio.h>
 #include <pit.h>
+#include <async.h>
 
 #include <stdint.h>
+#include <stddef.h>
+
+/**
+ * \struct speaker_note_t
+ * 
+ * \brief A note of a song.
+ */
+typedef struct {
+	uint16_t frequency;		/**< The frequency of the note. */
+	uint16_t duration;		/**< How long the note plays for in milliseconds. */
+	uint16_t pause;			/**< The silence after the note in milliseconds. */
+} speaker_note_t;
+
+/**
+ * \brief The notes of the star wars song.
+ */
+static const speaker_note_t star_wars[] = {
+	{ 440, 500, 250 },
+	{ 440, 500, 250 },
+	{ 440, 500, 250 },
+	{ 349, 350, 250 },
+	{ 523, 150, 250 },
+	{ 440, 500, 250 },
+	{ 349, 350, 250 },
+	{ 523, 150, 250 },
+	{ 440, 1000, 250 },
+	{ 659, 500, 250 },
+	{ 659, 500, 250 },
+	{ 659, 500, 250 },
+	{ 698, 350, 250 },
+	{ 523, 150, 250 },
+	{ 415, 500, 250 },
+	{ 349, 350, 250 },
+	{ 523, 150, 250 },
+	{ 440, 1000, 0 }
+};
+
+/**
+ * \brief The notes of the happy birthday song.
+ */
+static const speaker_note_t happy_birthday[] = {
+	{ 264, 125, 250 },
+	{ 264, 125, 125 },
+	{ 297, 500, 125 },
+	{ 264, 500, 125 },
+	{ 352, 500, 125 },
+	{ 330, 1000, 250 },
+	{ 264, 125, 250 },
+	{ 264, 125, 125 },
+	{ 297, 500, 125 },
+	{ 264, 500, 125 },
+	{ 396, 500, 125 },
+	{ 352, 1000, 250 },
+	{ 264, 125, 250 },
+	{ 264, 125, 125 },
+	{ 264, 500, 125 },
+	{ 440, 500, 125 },
+	{ 352, 250, 125 },
+	{ 352, 125, 125 },
+	{ 330, 500, 125 },
+	{ 297, 1000, 250 },
+	{ 466, 125, 250 },
+	{ 466, 125, 125 },
+	{ 440, 500, 125 },
+	{ 352, 500, 125 },
+	{ 396, 500, 125 },
+	{ 352, 1000, 0 }
+};
+
+static async_t speaker_task;						/**< The coroutine playing the song. */
+static const speaker_note_t * speaker_song = NULL;	/**< The song being played. */
+static uint32_t speaker_song_length = 0;			/**< The number of notes in \ref speaker_song. */
+static uint32_t speaker_note = 0;					/**< The note being played, kept here as the coroutine has no stack. */
 
 /**
  * \todo Return error code from PIT
@@ -21,96 +95,51 @@ static void speaker_stop(void) {
 	out_port_byte(SPEAKER_PORT_ADDRESS, temp);
 }
 
+/**
+ * \brief Play the notes of \ref speaker_song one after the other, sleeping while each plays so the
+ * shell isn't blocked.
+ * 
+ * \param [in] task The coroutine.
+ * 
+ * \return Whether the song is still playing.
+ */
+static async_status_t speaker_play(async_t * task) {
+	ASYNC_BEGIN(task);
+	
+	for(speaker_note = 0; speaker_note < speaker_song_length; speaker_note++) {
+		speaker_start(speaker_song[speaker_note].frequency);
+		ASYNC_SLEEP(task, speaker_song[speaker_note].duration);
+		speaker_stop();
+		
+		if(speaker_song[speaker_note].pause) {
+			ASYNC_SLEEP(task, speaker_song[speaker_note].pause);
+		}
+	}
+	
+	ASYNC_END(task);
+}
+
+/**
+ * \brief Start playing a song, stopping any song already playing.
+ * 
+ * \param [in] song The notes.
+ * \param [in] length The number of notes.
+ */
+static void speaker_play_song(const speaker_note_t * song, uint32_t length) {
+	async_cancel(&speaker_task);
+	speaker_stop();
+	
+	speaker_song = song;
+	speaker_song_length = length;
+	async_start(&speaker_task, speaker_play, NULL);
+}
+
 void speaker_star_wars(void) {
-	beep(440,500);
-	pit_wait(250);
-	beep(440,500);
-	pit_wait(250);
-	beep(440,500);
-	pit_wait(250);
-	beep(349,350);
-	pit_wait(250);
-	beep(523,150);
-	pit_wait(250);
-	beep(440,500);
-	pit_wait(250);
-	beep(349,350);
-	pit_wait(250);
-	beep(523,150);
-	pit_wait(250);
-	beep(440,1000);
-	pit_wait(250);
-	beep(659,500);
-	pit_wait(250);
-	beep(659,500);
-	pit_wait(250);
-	beep(659,500);
-	pit_wait(250);
-	beep(698,350);
-	pit_wait(250);
-	beep(523,150);
-	pit_wait(250);
-	beep(415,500);
-	pit_wait(250);
-	beep(349,350);
-	pit_wait(250);
-	beep(523,150);
-	pit_wait(250);
-	beep(440,1000);
+	speaker_play_song(star_wars, sizeof(star_wars) / sizeof(star_wars[0]));
 }
 
 void speaker_happy_birthday(void) {
-	beep(264, 125);
-	pit_wait(250);
-	beep(264, 125);
-	pit_wait(125);
-	beep(297, 500);
-	pit_wait(125);
-	beep(264, 500);
-	pit_wait(125);
-	beep(352, 500);
-	pit_wait(125);
-	beep(330, 1000);
-	pit_wait(250);
-	beep(264, 125);
-	pit_wait(250);
-	beep(264, 125);
-	pit_wait(125);
-	beep(297, 500);
-	pit_wait(125);
-	beep(264, 500);
-	pit_wait(125);
-	beep(396, 500);
-	pit_wait(125);
-	beep(352, 1000);
-	pit_wait(250);
-	beep(264, 125);
-	pit_wait(250);
-	beep(264, 125);
-	pit_wait(125);
-	beep(264, 500);
-	pit_wait(125);
-	beep(440, 500);
-	pit_wait(125);
-	beep(352, 250);
-	pit_wait(125);
-	beep(352, 125);
-	pit_wait(125);
-	beep(330, 500);
-	pit_wait(125);
-	beep(297, 1000);
-	pit_wait(250);
-	beep(466, 125);
-	pit_wait(250);
-	beep(466, 125);
-	pit_wait(125);
-	beep(440, 500);
-	pit_wait(125);
-	beep(352, 500);
-	pit_wait(125);
-	beep(396, 500);
-	pit_wait(125);
-	beep(352, 1000);
+	speaker_play_song(happy_birthday, sizeof(happy_birthday) / sizeof(happy_birthday[0]));
 }
 
 void beep(uint32_t frequency, uint32_t play_duration) {
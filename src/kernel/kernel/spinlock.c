@@ -0,0 +1,123 @@
+#include <spinlock.h>
+#include <interrupt.h>
+#include <cpu.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+static spinlock_t * spin_locks = NULL;		/**< The list of all the locks for the statistics. */
+
+/**
+ * \brief Record the lock as taken. Called with the lock held.
+ * 
+ * \param [in] lock The lock that was taken.
+ * \param [in] contended Whether had to wait for the lock.
+ */
+static void spin_lock_acquired(spinlock_t * lock, bool contended) {
+	lock->acquisitions++;
+	if(contended) {
+		lock->contentions++;
+	}
+	lock->acquired_tsc = cpu_rdtsc();
+}
+
+/**
+ * \brief Cap a cycle count to fit in 32 bits for printing.
+ * 
+ * \param [in] cycles The number of cycles.
+ * 
+ * \return The number of cycles, or 0xFFFFFFFF if too large.
+ */
+static uint32_t spin_lock_cycles(uint64_t cycles) {
+	return cycles > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) cycles;
+}
+
+/**
+ * \brief Get the average number of cycles a lock was held for. Scales both down until the total
+ * fits in 32 bits, as there is no 64 bit division without libgcc.
+ * 
+ * \param [in] lock The lock.
+ * 
+ * \return The average number of cycles.
+ */
+static uint32_t spin_lock_average(spinlock_t * lock) {
+	uint64_t total = lock->hold_cycles;
+	uint32_t count = lock->acquisitions;
+	while(total > 0xFFFFFFFF) {
+		total >>= 1;
+		count >>= 1;
+	}
+	return count ? (uint32_t) total / count : 0;
+}
+
+void spin_lock_init(spinlock_t * lock, const char * name) {
+	lock->next_ticket = 0;
+	lock->owner = 0;
+	lock->name = name;
+	lock->acquisitions = 0;
+	lock->contentions = 0;
+	lock->hold_cycles = 0;
+	lock->max_hold_cycles = 0;
+	lock->acquired_tsc = 0;
+	
+	uint32_t flags = interrupt_save();
+	lock->next = spin_locks;
+	spin_locks = lock;
+	interrupt_restore(flags);
+}
+
+void spin_lock(spinlock_t * lock) {
+	uint16_t ticket = __atomic_fetch_add(&lock->next_ticket, 1, __ATOMIC_RELAXED);
+	
+	bool contended = false;
+	while(__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket) {
+		contended = true;
+		cpu_pause();
+	}
+	
+	spin_lock_acquired(lock, contended);
+}
+
+bool spin_trylock(spinlock_t * lock) {
+	uint16_t owner = __atomic_load_n(&lock->owner, __ATOMIC_RELAXED);
+	uint16_t ticket = owner;
+	
+	// Only take a ticket if it would be served straight away
+	if(!__atomic_compare_exchange_n(&lock->next_ticket, &ticket, (uint16_t) (owner + 1), false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		return false;
+	}
+	
+	spin_lock_acquired(lock, false);
+	return true;
+}
+
+void spin_unlock(spinlock_t * lock) {
+	uint64_t held = cpu_rdtsc() - lock->acquired_tsc;
+	lock->hold_cycles += held;
+	if(held > lock->max_hold_cycles) {
+		lock->max_hold_cycles = held;
+	}
+	
+	__atomic_store_n(&lock->owner, (uint16_t) (lock->owner + 1), __ATOMIC_RELEASE);
+}
+
+uint32_t spin_lock_irqsave(spinlock_t * lock) {
+	uint32_t flags = interrupt_save();
+	spin_lock(lock);
+	return flags;
+}
+
+void spin_unlock_irqrestore(spinlock_t * lock, uint32_t flags) {
+	spin_unlock(lock);
+	interrupt_restore(flags);
+}
+
+void spin_lock_dump(void) {
+	kprintf("Taken\t\tWaited\tAvg held\tMax held\tName\n");
+	for(spinlock_t * lock = spin_locks; lock; lock = lock->next) {
+		kprintf("%u\t\t%u\t%u\t\t%u\t\t%s\n", lock->acquisitions, lock->contentions, spin_lock_average(lock), spin_lock_cycles(lock->max_hold_cycles), lock->name);
+	}
+	kprintf("Held times are in CPU cycles\n");
+}
@@ -0,0 +1,109 @@
+#include <syscall.h>
+#include <process.h>
+#include <idt.h>
+#include <gdt.h>
+#include <cpu.h>
+#include <cpu_features.h>
+#include <tty.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * \brief The entry of int 0x80 from ring 3.
+ */
+extern void _syscall_int(void);
+
+/**
+ * \brief The entry of SYSENTER from ring 3.
+ */
+extern void _syscall_sysenter(void);
+
+static bool has_sysenter = false;	/**< Whether the SYSENTER MSRs are set up. */
+
+/**
+ * \brief Do nothing.
+ * 
+ * \param [in] arg1 Unused.
+ * \param [in] arg2 Unused.
+ * \param [in] arg3 Unused.
+ * 
+ * \return 0.
+ */
+static uint32_t syscall_null(uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+	(void) arg1;
+	(void) arg2;
+	(void) arg3;
+	return 0;
+}
+
+/**
+ * \brief End the process.
+ * 
+ * \param [in] arg1 The exit code.
+ * \param [in] arg2 Unused.
+ * \param [in] arg3 Unused.
+ * 
+ * \return Doesn't return.
+ */
+static uint32_t syscall_exit(uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+	(void) arg2;
+	(void) arg3;
+	process_exit(arg1);
+}
+
+/**
+ * \brief Write a buffer of the process to the terminal.
+ * 
+ * \param [in] arg1 The buffer.
+ * \param [in] arg2 The size of the buffer in bytes.
+ * \param [in] arg3 Unused.
+ * 
+ * \return The number of bytes written. \ref SYSCALL_ERROR if the buffer isn't the process's.
+ */
+static uint32_t syscall_write(uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+	(void) arg3;
+	
+	if(!process_is_user_range(arg1, arg2)) {
+		return SYSCALL_ERROR;
+	}
+	
+	tty_write((const char *) arg1, arg2);
+	return arg2;
+}
+
+/**
+ * \brief The system calls by number.
+ */
+static const syscall_t syscall_table[SYSCALLS] = {
+	[SYSCALL_NULL] = syscall_null,
+	[SYSCALL_EXIT] = syscall_exit,
+	[SYSCALL_WRITE] = syscall_write
+};
+
+void syscall_init(void) {
+	idt_open_user_gate(SYSCALL_VECTOR, (uint32_t) &_syscall_int);
+	
+	has_sysenter = cpu_has(CPU_FEATURE_SEP) && cpu_has(CPU_FEATURE_MSR);
+	if(has_sysenter) {
+		// The stack is read from the TSS, as it changes with each thread
+		cpu_wrmsr(SYSCALL_MSR_SYSENTER_CS, GDT_KERNEL_CODE_OFFSET);
+		cpu_wrmsr(SYSCALL_MSR_SYSENTER_ESP, gdt_get_kernel_stack_address());
+		cpu_wrmsr(SYSCALL_MSR_SYSENTER_EIP, (uint32_t) &_syscall_sysenter);
+	}
+	
+	kprintf("Syscalls: int 0x%X%s\n", SYSCALL_VECTOR, has_sysenter ? ", SYSENTER" : "");
+}
+
+bool syscall_has_sysenter(void) {
+	return has_sysenter;
+}
+
+uint32_t syscall_dispatch(uint32_t number, uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+	if(number >= SYSCALLS) {
+		return SYSCALL_ERROR;
+	}
+	
+	return syscall_table[number](arg1, arg2, arg3);
+}
@@ -0,0 +1,107 @@
+	[bits	32]
+	section	.text
+	
+	[extern	syscall_dispatch]
+
+;
+; System call entries from ring 3. ring 3 runs with GS null, so GS is loaded with the boot CPU's
+; per-CPU segment, as only the boot CPU runs user threads. Interrupts stay off until then.
+;
+
+; 128: int 0x80
+global _syscall_int
+_syscall_int:
+	push	ds
+	push	es
+	push	gs
+	push	ecx
+	push	edx
+	
+	mov		cx, 0x10			; The kernel data segment
+	mov		ds, cx
+	mov		es, cx
+	mov		cx, 0x30			; The boot CPU's per-CPU segment
+	mov		gs, cx
+	cld
+	sti
+	
+	push	edi
+	push	esi
+	push	ebx
+	push	eax
+	call	syscall_dispatch	; The result is left in EAX
+	add		esp, 16
+	
+	; Interrupts in the kernel expect the kernel's GS
+	cli
+	pop		edx
+	pop		ecx
+	pop		gs
+	pop		es
+	pop		ds
+	iret
+
+; SYSENTER. The SYSENTER_ESP MSR points at ESP0 of the TSS, the top of the kernel stack of the
+; current thread. The user return address is in EDX and the user stack in ECX, for SYSEXIT.
+global _syscall_sysenter
+_syscall_sysenter:
+	mov		esp, [esp]
+	push	ecx
+	push	edx
+	push	ds
+	push	es
+	push	gs
+	
+	mov		cx, 0x10			; The kernel data segment
+	mov		ds, cx
+	mov		es, cx
+	mov		cx, 0x30			; The boot CPU's per-CPU segment
+	mov		gs, cx
+	cld
+	sti
+	
+	push	edi
+	push	esi
+	push	ebx
+	push	eax
+	call	syscall_dispatch	; The result is left in EAX
+	add		esp, 16
+	
+	cli
+	pop		gs
+	pop		es
+	pop		ds
+	pop		edx
+	pop		ecx
+	sti							; Takes effect after SYSEXIT, so no interrupt comes in between
+	sysexit
+
+; Enter ring 3 for the first time. Interrupts must be disabled.
+; void _user_enter(uint32_t eip, uint32_t esp, uint32_t eax)
+global _user_enter
+_user_enter:
+	mov		ecx, [esp + 4]
+	mov		edx, [esp + 8]
+	mov		eax, [esp + 12]
+	
+	mov		bx, 0x23			; The user data segment with RPL 3
+	mov		ds, bx
+	mov		es, bx
+	mov		fs, bx
+	xor		bx, bx
+	mov		gs, bx
+	
+	push	dword 0x23			; SS
+	push	edx					; ESP
+	push	dword 0x202			; EFLAGS with interrupts enabled
+	push	dword 0x1B			; CS, the user code segment with RPL 3
+	push	ecx					; EIP
+	
+	; Don't leak kernel values to ring 3
+	xor		ebx, ebx
+	xor		ecx, ecx
+	xor		edx, edx
+	xor		esi, esi
+	xor		edi, edi
+	xor		ebp, ebp
+	iret
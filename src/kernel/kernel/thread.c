@@ -0,0 +1,458 @@
+#include <thread.h>
+#include <interrupt.h>
+#include <pmm.h>
+#include <clockevent.h>
+#include <panic.h>
+#include <cpu.h>
+#include <timer.h>
+#include <work.h>
+#include <process.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * \brief Save the callee saved registers and stack pointer of the current thread into
+ * \p old_esp and switch to the stack \p new_esp.
+ * 
+ * \param [out] old_esp Where to save the stack pointer of the current thread.
+ * \param [in] new_esp The saved stack pointer of the thread to switch to.
+ */
+extern void _thread_switch(uint32_t * old_esp, uint32_t new_esp);
+
+static thread_t threads[THREAD_MAX];		/**< All the threads. */
+static thread_t * current_thread = NULL;	/**< The running thread. NULL until \ref thread_init. */
+static thread_t * idle_thread = NULL;		/**< The thread run when no other thread is ready. Never in the run queue. */
+static thread_t * run_queue_head[THREAD_PRIORITIES];	/**< The first thread in the run queue of each priority, the next to run. */
+static thread_t * run_queue_tail[THREAD_PRIORITIES];	/**< The last thread in the run queue of each priority. */
+static uint32_t ready_bitmap = 0;			/**< Bit n is set if the run queue of priority n isn't empty. */
+static thread_t * dead_thread = NULL;		/**< A thread that has exited and needs its stack freeing. */
+static volatile bool need_resched = false;	/**< Whether to switch thread at the end of the IRQ. */
+static uint32_t next_id = 0;				/**< The ID for the next thread created. */
+
+/**
+ * \brief Add a thread to the end of the run queue for its priority. Interrupts must be disabled.
+ * 
+ * \param [in] thread The thread to add.
+ */
+static void thread_enqueue(thread_t * thread) {
+	uint8_t priority = thread->priority;
+	thread->next = NULL;
+	
+	if(run_queue_tail[priority]) {
+		run_queue_tail[priority]->next = thread;
+	} else {
+		run_queue_head[priority] = thread;
+	}
+	
+	run_queue_tail[priority] = thread;
+	ready_bitmap |= 1 << priority;
+}
+
+/**
+ * \brief Take the first thread from the highest priority run queue that isn't empty. Interrupts
+ * must be disabled.
+ * 
+ * \return The next thread to run. NULL if all the run queues are empty.
+ */
+static thread_t * thread_dequeue(void) {
+	if(!ready_bitmap) {
+		return NULL;
+	}
+	
+	uint32_t priority = cpu_bsf(ready_bitmap);
+	thread_t * thread = run_queue_head[priority];
+	
+	run_queue_head[priority] = thread->next;
+	if(!run_queue_head[priority]) {
+		run_queue_tail[priority] = NULL;
+		ready_bitmap &= ~(1 << priority);
+	}
+	thread->next = NULL;
+	
+	return thread;
+}
+
+/**
+ * \brief Get whether a thread should preempt the running thread. Interrupts must be disabled.
+ * 
+ * \param [in] thread The thread that was made ready.
+ * 
+ * \return Whether \p thread has a higher priority than the running thread.
+ */
+static bool thread_should_preempt(thread_t * thread) {
+	return current_thread && (current_thread == idle_thread || thread->priority < current_thread->priority);
+}
+
+/**
+ * \brief Make a thread ready and mark that a switch is needed if it should preempt the running
+ * thread. Interrupts must be disabled.
+ * 
+ * \param [in] thread The thread that was woken.
+ */
+static void thread_wake(thread_t * thread) {
+	thread->state = THREAD_READY;
+	thread->wake_tsc = cpu_rdtsc();
+	thread_enqueue(thread);
+	
+	if(thread_should_preempt(thread)) {
+		need_resched = true;
+	}
+}
+
+/**
+ * \brief Free the stack of a thread that has exited. Called after every switch as a thread can't
+ * free the stack it is running on.
+ */
+static void thread_reap(void) {
+	if(dead_thread) {
+		pmm_free_blocks(dead_thread->stack, THREAD_STACK_BLOCKS);
+		dead_thread->stack = NULL;
+		dead_thread->state = THREAD_UNUSED;
+		dead_thread = NULL;
+	}
+}
+
+/**
+ * \brief Pick the highest priority thread and switch to it. The current thread is put on the back
+ * of its run queue if it is still running, so it only keeps running if no other thread of the same
+ * or higher priority is ready. Interrupts must be disabled.
+ */
+static void thread_schedule(void) {
+	thread_t * prev = current_thread;
+	
+	need_resched = false;
+	
+	if(prev->state == THREAD_RUNNING && prev != idle_thread) {
+		prev->state = THREAD_READY;
+		thread_enqueue(prev);
+	}
+	
+	thread_t * next = thread_dequeue();
+	if(!next) {
+		next = idle_thread;
+	}
+	
+	next->state = THREAD_RUNNING;
+	next->time_slice = THREAD_TIME_SLICE;
+	
+	if(next == prev) {
+		return;
+	}
+	
+	next->switches++;
+	current_thread = next;
+	fpu_switch(next);
+	process_switch(next);
+	_thread_switch(&prev->esp, next->esp);
+	
+	// Running as prev again
+	thread_reap();
+}
+
+/**
+ * \brief The first function a new thread runs, from the return of \ref _thread_switch.
+ */
+static void thread_start(void) {
+	thread_reap();
+	interrupt_enable();
+	
+	current_thread->entry(current_thread->arg);
+	
+	thread_exit();
+}
+
+/**
+ * \brief The idle thread. Runs any deferred work, then stops the periodic tick until the next timer
+ * is due and halts until the next interrupt, which switches to a thread if one was woken.
+ * 
+ * \param [in] arg Unused.
+ */
+static void thread_idle(void * arg) {
+	(void) arg;
+	
+	while(1) {
+		interrupt_disable();
+		
+		// Work queued outside of an IRQ is otherwise left until the next IRQ
+		if(work_pending()) {
+			work_run();
+			thread_preempt();
+			interrupt_enable();
+			continue;
+		}
+		
+		clockevent_idle_enter(timer_ticks_to_next());
+		
+		// Interrupts aren't taken until after the hlt, so can't miss the wake up
+		__asm__ __volatile__ ("sti");
+		__asm__ __volatile__ ("hlt");
+	}
+}
+
+/**
+ * \brief Copy the name of a thread, truncating it to fit.
+ * 
+ * \param [in] thread The thread to name.
+ * \param [in] name The name.
+ */
+static void thread_set_name(thread_t * thread, const char * name) {
+	uint32_t i = 0;
+	for(; name[i] && i < THREAD_NAME_SIZE - 1; i++) {
+		thread->name[i] = name[i];
+	}
+	thread->name[i] = '\0';
+}
+
+/**
+ * \brief Allocate a thread with a stack set up to start at \ref thread_start. Interrupts must be
+ * disabled.
+ * 
+ * \param [in] name The name of the thread.
+ * \param [in] entry The function the thread runs.
+ * \param [in] arg The argument to \p entry.
+ * \param [in] priority The priority of the thread.
+ * 
+ * \return The thread. NULL if there are no free threads or no memory for the stack.
+ */
+static thread_t * thread_alloc(const char * name, thread_entry_t entry, void * arg, uint8_t priority) {
+	thread_t * thread = NULL;
+	for(uint32_t i = 0; i < THREAD_MAX; i++) {
+		if(threads[i].state == THREAD_UNUSED) {
+			thread = &threads[i];
+			break;
+		}
+	}
+	
+	if(!thread) {
+		return NULL;
+	}
+	
+	void * stack = pmm_alloc_blocks(THREAD_STACK_BLOCKS);
+	if(!stack) {
+		return NULL;
+	}
+	
+	// Set up the stack as if _thread_switch switched away from the start of thread_start
+	uint32_t * sp = (uint32_t *) ((uint8_t *) stack + THREAD_STACK_BLOCKS * PMM_BLOCK_SIZE);
+	*--sp = 0;							// Return address of thread_start, never used
+	*--sp = (uint32_t) thread_start;	// Return address of _thread_switch
+	*--sp = 0;							// ebp
+	*--sp = 0;							// ebx
+	*--sp = 0;							// esi
+	*--sp = 0;							// edi
+	
+	thread->esp = (uint32_t) sp;
+	thread->id = next_id++;
+	thread->state = THREAD_READY;
+	thread->stack = stack;
+	thread->entry = entry;
+	thread->arg = arg;
+	thread->time_slice = THREAD_TIME_SLICE;
+	thread->run_ticks = 0;
+	thread->switches = 0;
+	thread->priority = priority < THREAD_PRIORITIES ? priority : THREAD_PRIORITIES - 1;
+	thread->wake_tsc = 0;
+	thread->next = NULL;
+	thread->wait_next = NULL;
+	thread->fpu_used = false;
+	thread->process = NULL;
+	
+	thread_set_name(thread, name);
+	
+	return thread;
+}
+
+void thread_init(void) {
+	interrupt_disable();
+	
+	thread_t * boot = &threads[0];
+	boot->id = next_id++;
+	boot->state = THREAD_RUNNING;
+	boot->stack = NULL;
+	boot->time_slice = THREAD_TIME_SLICE;
+	boot->priority = THREAD_PRIORITY_NORMAL;
+	
+	thread_set_name(boot, "kernel");
+	
+	idle_thread = thread_alloc("idle", thread_idle, NULL, THREAD_PRIORITIES - 1);
+	if(!idle_thread) {
+		panic("Unable to create the idle thread\n");
+	}
+	
+	current_thread = boot;
+	
+	interrupt_enable();
+}
+
+thread_t * thread_create(const char * name, thread_entry_t entry, void * arg, uint8_t priority) {
+	uint32_t flags = interrupt_save();
+	
+	thread_t * thread = thread_alloc(name, entry, arg, priority);
+	if(thread) {
+		thread_wake(thread);
+		if(need_resched && (flags & INTERRUPT_FLAG) && !work_in_progress()) {
+			thread_schedule();
+		}
+	}
+	
+	interrupt_restore(flags);
+	
+	return thread;
+}
+
+noreturn void thread_exit(void) {
+	interrupt_disable();
+	
+	current_thread->state = THREAD_DEAD;
+	dead_thread = current_thread;
+	fpu_thread_exit(current_thread);
+	thread_schedule();
+	
+	panic("Thread %u was run after exiting\n", current_thread->id);
+	__builtin_unreachable();
+}
+
+thread_t * thread_current(void) {
+	return current_thread;
+}
+
+void thread_set_priority(uint8_t priority) {
+	if(!current_thread) {
+		return;
+	}
+	
+	uint32_t flags = interrupt_save();
+	
+	current_thread->priority = priority < THREAD_PRIORITIES ? priority : THREAD_PRIORITIES - 1;
+	
+	// Switch if lowered below a ready thread
+	if(ready_bitmap && cpu_bsf(ready_bitmap) < current_thread->priority) {
+		thread_schedule();
+	}
+	
+	interrupt_restore(flags);
+}
+
+void thread_yield(void) {
+	if(!current_thread) {
+		return;
+	}
+	
+	uint32_t flags = interrupt_save();
+	
+	thread_schedule();
+	
+	interrupt_restore(flags);
+}
+
+void thread_block(void) {
+	if(!current_thread) {
+		// No threads yet, so wait for the next interrupt
+		__asm__ __volatile__ ("sti");
+		__asm__ __volatile__ ("hlt");
+		__asm__ __volatile__ ("cli");
+		return;
+	}
+	
+	current_thread->state = THREAD_BLOCKED;
+	thread_schedule();
+}
+
+void thread_unblock(thread_t * thread) {
+	if(!thread || thread->state != THREAD_BLOCKED) {
+		return;
+	}
+	
+	uint32_t flags = interrupt_save();
+	
+	thread_wake(thread);
+	
+	// IRQ handlers run with interrupts disabled and switch at the end of the IRQ instead, as does
+	// the deferred work
+	if(need_resched && (flags & INTERRUPT_FLAG) && !work_in_progress()) {
+		thread_schedule();
+	}
+	
+	interrupt_restore(flags);
+}
+
+/**
+ * \brief The timer callback that wakes a sleeping thread.
+ * 
+ * \param [in] arg The thread to wake.
+ */
+static void thread_sleep_timeout(void * arg) {
+	thread_t * thread = (thread_t *) arg;
+	
+	if(thread->state == THREAD_SLEEPING) {
+		thread_wake(thread);
+	}
+}
+
+void thread_sleep(uint32_t ticks) {
+	uint32_t flags = interrupt_save();
+	
+	if(!current_thread) {
+		// No threads yet, so wait for each tick
+		uint32_t wake_tick = clockevent_get_ticks() + ticks;
+		while((int32_t) (clockevent_get_ticks() - wake_tick) < 0) {
+			__asm__ __volatile__ ("sti");
+			__asm__ __volatile__ ("hlt");
+			__asm__ __volatile__ ("cli");
+		}
+	} else {
+		timer_t timer;
+		timer_init(&timer);
+		timer_add(&timer, clockevent_get_ticks() + ticks, thread_sleep_timeout, current_thread);
+		
+		current_thread->state = THREAD_SLEEPING;
+		thread_schedule();
+	}
+	
+	interrupt_restore(flags);
+}
+
+void thread_tick(void) {
+	if(!current_thread) {
+		return;
+	}
+	
+	current_thread->run_ticks++;
+	
+	if(current_thread != idle_thread && current_thread->time_slice > 0) {
+		current_thread->time_slice--;
+		if(current_thread->time_slice == 0) {
+			need_resched = true;
+		}
+	}
+}
+
+void thread_preempt(void) {
+	if(current_thread && need_resched) {
+		thread_schedule();
+	}
+}
+
+void thread_dump(void) {
+	static const char * str_state[] = {
+		"Unused",
+		"Ready",
+		"Running",
+		"Blocked",
+		"Sleeping",
+		"Dead"
+	};
+	
+	kprintf("ID\tState\t\tPrio\tTicks\tSwitches\tName\n");
+	for(uint32_t i = 0; i < THREAD_MAX; i++) {
+		thread_t * thread = &threads[i];
+		if(thread->state == THREAD_UNUSED) {
+			continue;
+		}
+		
+		kprintf("%u\t%s\t\t%u\t%u\t%u\t\t%s\n", thread->id, str_state[thread->state], thread->priority, thread->run_ticks, thread->switches, thread->name);
+	}
+}
@@ -0,0 +1,28 @@
+	[bits	32]
+	
+	section	.text
+
+; Switches from the current thread to another by swapping stacks.
+; void _thread_switch(uint32_t * old_esp, uint32_t new_esp)
+global _thread_switch
+_thread_switch:
+	; Get where to save the old stack pointer into EAX, and the new stack pointer into EDX.
+	mov		eax, [esp + 4]
+	mov		edx, [esp + 8]
+	
+	; Save the callee saved registers on the old stack.
+	push	ebp
+	push	ebx
+	push	esi
+	push	edi
+	
+	; Swap the stacks.
+	mov		[eax], esp
+	mov		esp, edx
+	
+	; Restore the callee saved registers from the new stack and return into the new thread.
+	pop		edi
+	pop		esi
+	pop		ebx
+	pop		ebp
+	ret
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include <timekeeping.h>
+#include <clock.h>
+#include <cpu.h>
+#include <interrupt.h>
+
+#include <stdint.h>
+
+static uint32_t timekeeping_base = 0;		/**< The wall clock at \ref timekeeping_base_ns. */
+static uint64_t timekeeping_base_ns = 0;	/**< The monotonic clock when the wall clock was set. */
+
+void timekeeping_sync(uint32_t seconds) {
+	uint32_t flags = interrupt_save();
+	timekeeping_base = seconds;
+	timekeeping_base_ns = clock_monotonic_ns();
+	interrupt_restore(flags);
+}
+
+/**
+ * \brief Get the wall clock, with a time added before dropping the part of a second.
+ * 
+ * \param [in] bias_ns The number of nanoseconds to add.
+ * 
+ * \return The number of seconds since 1970 in UTC.
+ */
+static uint32_t timekeeping_get_time_bias(uint32_t bias_ns) {
+	// The RTC interrupt can set the base, so read both in one go
+	uint32_t flags = interrupt_save();
+	uint32_t base = timekeeping_base;
+	uint64_t base_ns = timekeeping_base_ns;
+	interrupt_restore(flags);
+	
+	return base + (uint32_t) cpu_div64(clock_monotonic_ns() - base_ns + bias_ns, CLOCK_NS_PER_SEC);
+}
+
+uint32_t timekeeping_get_time(void) {
+	return timekeeping_get_time_bias(0);
+}
+
+uint32_t timekeeping_get_time_nearest(void) {
+	return timekeeping_get_time_bias(CLOCK_NS_PER_SEC / 2);
+}
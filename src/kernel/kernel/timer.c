@@ -0,0 +1,216 @@
+#include <timer.h>
+#include <interrupt.h>
+#include <clockevent.h>
+#include <thread.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * \brief The mask for the index into a level of the wheel.
+ */
+#define TIMER_WHEEL_MASK		(TIMER_WHEEL_SLOTS - 1)
+
+/**
+ * \brief The number of ticks the whole wheel covers.
+ */
+#define TIMER_WHEEL_RANGE		(1u << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+static timer_t * timer_wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];	/**< The lists of timers in each slot of each level. */
+static timer_t * timer_expired;			/**< The timers being run by \ref timer_run. */
+static uint32_t timer_ticks = 0;		/**< The next tick the wheel is to process. */
+static uint32_t timer_count = 0;		/**< The number of pending timers. */
+
+/**
+ * \brief Add a timer to the front of a list.
+ * 
+ * \param [in] head The list to add to.
+ * \param [in] timer The timer to add.
+ */
+static void timer_link(timer_t ** head, timer_t * timer) {
+	timer->head = head;
+	timer->prev = NULL;
+	timer->next = *head;
+	if(*head) {
+		(*head)->prev = timer;
+	}
+	*head = timer;
+}
+
+/**
+ * \brief Put a timer into the slot for its expiry tick. Interrupts must be disabled.
+ * 
+ * \param [in] timer The timer to insert.
+ */
+static void timer_insert(timer_t * timer) {
+	uint32_t expires = timer->expires;
+	int32_t delta = (int32_t) (expires - timer_ticks);
+	
+	// Already passed, so expire on the next tick processed
+	if(delta < 0) {
+		expires = timer_ticks;
+		delta = 0;
+	}
+	
+	// Too far away, so put in the last slot and re-insert when it gets there
+	if((uint32_t) delta >= TIMER_WHEEL_RANGE) {
+		expires = timer_ticks + TIMER_WHEEL_RANGE - 1;
+		delta = TIMER_WHEEL_RANGE - 1;
+	}
+	
+	uint32_t level = 0;
+	while((uint32_t) delta >= (1u << (TIMER_WHEEL_BITS * (level + 1)))) {
+		level++;
+	}
+	
+	uint32_t index = (expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+	timer_link(&timer_wheel[level][index], timer);
+}
+
+/**
+ * \brief Remove a timer from whichever list it is in. Interrupts must be disabled.
+ * 
+ * \param [in] timer The timer to remove.
+ */
+static void timer_unlink(timer_t * timer) {
+	if(timer->prev) {
+		timer->prev->next = timer->next;
+	} else {
+		*timer->head = timer->next;
+	}
+	
+	if(timer->next) {
+		timer->next->prev = timer->prev;
+	}
+	
+	timer->next = NULL;
+	timer->prev = NULL;
+	timer->head = NULL;
+}
+
+/**
+ * \brief Move all the timers in a slot of a higher level down into the levels below.
+ * 
+ * \param [in] level The level.
+ * \param [in] index The slot in the level.
+ * 
+ * \return The index of the slot.
+ */
+static uint32_t timer_cascade(uint32_t level, uint32_t index) {
+	timer_t * timer = timer_wheel[level][index];
+	timer_wheel[level][index] = NULL;
+	
+	while(timer) {
+		timer_t * next = timer->next;
+		timer_insert(timer);
+		timer = next;
+	}
+	
+	return index;
+}
+
+void timer_init(timer_t * timer) {
+	timer->next = NULL;
+	timer->prev = NULL;
+	timer->head = NULL;
+	timer->expires = 0;
+	timer->callback = NULL;
+	timer->arg = NULL;
+	timer->pending = false;
+}
+
+void timer_add(timer_t * timer, uint32_t deadline, timer_callback_t callback, void * arg) {
+	uint32_t flags = interrupt_save();
+	
+	if(timer->pending) {
+		timer_unlink(timer);
+		timer_count--;
+	}
+	
+	timer->expires = deadline;
+	timer->callback = callback;
+	timer->arg = arg;
+	timer->pending = true;
+	timer_insert(timer);
+	timer_count++;
+	
+	interrupt_restore(flags);
+}
+
+void timer_cancel(timer_t * timer) {
+	uint32_t flags = interrupt_save();
+	
+	if(timer->pending) {
+		timer_unlink(timer);
+		timer->pending = false;
+		timer_count--;
+	}
+	
+	interrupt_restore(flags);
+}
+
+bool timer_pending(timer_t * timer) {
+	return timer->pending;
+}
+
+uint32_t timer_ms_to_ticks(uint32_t milliseconds) {
+	// Split up so doesn't overflow for long times
+	return (milliseconds / 1000) * CLOCKEVENT_HZ + ((milliseconds % 1000) * CLOCKEVENT_HZ + 999) / 1000;
+}
+
+void sleep_ms(uint32_t milliseconds) {
+	thread_sleep(timer_ms_to_ticks(milliseconds));
+}
+
+uint32_t timer_ticks_to_next(void) {
+	if(!timer_count) {
+		return 0xFFFFFFFF;
+	}
+	
+	// Find the next used slot in level 0, stopping where level 1 moves down
+	uint32_t tick = timer_ticks;
+	for(uint32_t i = 0; i < TIMER_WHEEL_SLOTS; i++, tick++) {
+		if((tick & TIMER_WHEEL_MASK) == 0 || timer_wheel[0][tick & TIMER_WHEEL_MASK]) {
+			break;
+		}
+	}
+	
+	int32_t ticks = (int32_t) (tick - clockevent_get_ticks());
+	return ticks > 0 ? (uint32_t) ticks : 0;
+}
+
+void timer_run(void) {
+	uint32_t now = clockevent_get_ticks();
+	
+	while((int32_t) (now - timer_ticks) >= 0) {
+		uint32_t index = timer_ticks & TIMER_WHEEL_MASK;
+		
+		// Level 0 has wrapped round, so move down the next slot of level 1, and so on up
+		if(index == 0) {
+			for(uint32_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+				if(timer_cascade(level, (timer_ticks >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK) != 0) {
+					break;
+				}
+			}
+		}
+		
+		// Take the whole slot first, so a callback that adds a timer that has already passed gets
+		// it run on the next tick rather than in this loop
+		timer_expired = timer_wheel[0][index];
+		timer_wheel[0][index] = NULL;
+		for(timer_t * timer = timer_expired; timer; timer = timer->next) {
+			timer->head = &timer_expired;
+		}
+		timer_ticks++;
+		
+		while(timer_expired) {
+			timer_t * timer = timer_expired;
+			timer_unlink(timer);
+			timer->pending = false;
+			timer_count--;
+			
+			timer->callback(timer->arg);
+		}
+	}
+}
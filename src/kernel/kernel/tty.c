@@ -256,8 +256,6 @@ void tty_set_display_time(void) {
 	tty_column = 0;
 	tty_row = TTY_ROW_MIN - 1;
 	
-	read_rtc(&tty_time, true);
-	
 	kprintf("                         %s %02d-%02d-%04d %02d:%02d:%02d", str_day[tty_time.day_of_week], tty_time.day, tty_time.month, tty_time.year, tty_time.hour, tty_time.minute, tty_time.second);
 	
 	tty_column = column_temp;
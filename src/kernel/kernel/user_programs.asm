@@ -0,0 +1,114 @@
+	[bits	32]
+	section	.text
+
+SYSCALL_NULL	equ 0
+SYSCALL_EXIT	equ 1
+SYSCALL_WRITE	equ 2
+BENCH_ROUNDS	equ 10000
+
+;
+; Programs run in ring 3 by the kernel task. They are copied into a process, so only use offsets
+; from the start.
+;
+
+; The null system call benchmark. Times BENCH_ROUNDS null system calls with int 0x80, then with
+; SYSENTER if EAX is not zero, and prints the cycles of each.
+global _user_syscall_bench_start
+_user_syscall_bench_start:
+	; Find where the program was copied to
+	call	.base
+.base:
+	pop		ebx
+	sub		ebx, .base - _user_syscall_bench_start
+	push	eax					; [esp + 4]: whether SYSENTER can be used
+	push	ebx					; [esp]: the start of the program
+	
+	; int 0x80 keeps every register
+	rdtsc
+	mov		esi, eax
+	mov		edi, edx
+	mov		ebp, BENCH_ROUNDS
+.int_loop:
+	mov		eax, SYSCALL_NULL
+	int		0x80
+	dec		ebp
+	jnz		.int_loop
+	rdtsc
+	sub		eax, esi
+	sbb		edx, edi
+	mov		ebx, [esp]
+	add		ebx, .int_msg - _user_syscall_bench_start
+	mov		esi, .int_msg_end - .int_msg
+	call	.print_result
+	
+	cmp		dword [esp + 4], 0
+	je		.exit
+	
+	; SYSEXIT returns to EDX with the stack in ECX, so EDX stays the return address
+	rdtsc
+	mov		esi, eax
+	mov		edi, edx
+	mov		ebp, BENCH_ROUNDS
+	mov		edx, [esp]
+	add		edx, .sysenter_return - _user_syscall_bench_start
+.sysenter_loop:
+	mov		eax, SYSCALL_NULL
+	mov		ecx, esp
+	sysenter
+.sysenter_return:
+	dec		ebp
+	jnz		.sysenter_loop
+	rdtsc
+	sub		eax, esi
+	sbb		edx, edi
+	mov		ebx, [esp]
+	add		ebx, .sysenter_msg - _user_syscall_bench_start
+	mov		esi, .sysenter_msg_end - .sysenter_msg
+	call	.print_result
+	
+.exit:
+	mov		eax, SYSCALL_EXIT
+	xor		ebx, ebx
+	int		0x80
+
+; Print a label then the cycles of one round.
+; EDX:EAX is the cycles of all the rounds, EBX the label and ESI the length of the label.
+.print_result:
+	mov		ecx, BENCH_ROUNDS
+	div		ecx
+	push	eax
+	
+	mov		eax, SYSCALL_WRITE
+	int		0x80
+	
+	; Make the digits backwards from a new line at the end of the buffer
+	pop		eax
+	sub		esp, 12
+	lea		edi, [esp + 11]
+	mov		byte [edi], 10
+	mov		ecx, 10
+.digit:
+	xor		edx, edx
+	div		ecx
+	add		dl, '0'
+	dec		edi
+	mov		[edi], dl
+	test	eax, eax
+	jnz		.digit
+	
+	mov		ebx, edi
+	lea		esi, [esp + 12]
+	sub		esi, edi
+	mov		eax, SYSCALL_WRITE
+	int		0x80
+	add		esp, 12
+	ret
+
+.int_msg:
+	db		"int 0x80 cycles per null syscall: "
+.int_msg_end:
+.sysenter_msg:
+	db		"SYSENTER cycles per null syscall: "
+.sysenter_msg_end:
+global _user_syscall_bench_end
+_user_syscall_bench_end:
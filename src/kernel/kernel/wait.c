@@ -0,0 +1,172 @@
+#include <wait.h>
+#include <thread.h>
+#include <interrupt.h>
+#include <work.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * \brief Take the thread that has waited the longest off a wait queue. Interrupts must be disabled.
+ * 
+ * \param [in] queue The wait queue.
+ * 
+ * \return The thread. NULL if no threads are waiting.
+ */
+static thread_t * wait_queue_pop(wait_queue_t * queue) {
+	thread_t * thread = queue->head;
+	if(thread) {
+		queue->head = thread->wait_next;
+		if(!queue->head) {
+			queue->tail = NULL;
+		}
+		thread->wait_next = NULL;
+	}
+	return thread;
+}
+
+/**
+ * \brief Switch to a woken thread if it is a higher priority, unless called from an IRQ handler or
+ * the deferred work, which switch when they finish.
+ * 
+ * \param [in] flags The EFLAGS from before interrupts were disabled.
+ */
+static void wait_queue_preempt(uint32_t flags) {
+	if((flags & INTERRUPT_FLAG) && !work_in_progress()) {
+		thread_preempt();
+	}
+}
+
+void wait_queue_init(wait_queue_t * queue) {
+	queue->head = NULL;
+	queue->tail = NULL;
+}
+
+void wait_queue_sleep(wait_queue_t * queue) {
+	thread_t * thread = thread_current();
+	
+	// No threads yet, so thread_block waits for the next interrupt instead
+	if(thread) {
+		thread->wait_next = NULL;
+		if(queue->tail) {
+			queue->tail->wait_next = thread;
+		} else {
+			queue->head = thread;
+		}
+		queue->tail = thread;
+	}
+	
+	thread_block();
+}
+
+bool wake_up_one(wait_queue_t * queue) {
+	uint32_t flags = interrupt_save();
+	
+	thread_t * thread = wait_queue_pop(queue);
+	if(thread) {
+		thread_unblock(thread);
+		wait_queue_preempt(flags);
+	}
+	
+	interrupt_restore(flags);
+	return thread != NULL;
+}
+
+void wake_up_all(wait_queue_t * queue) {
+	uint32_t flags = interrupt_save();
+	
+	// Wake them all before switching, so the order they run in is only down to their priorities
+	thread_t * thread;
+	while((thread = wait_queue_pop(queue))) {
+		thread_unblock(thread);
+	}
+	wait_queue_preempt(flags);
+	
+	interrupt_restore(flags);
+}
+
+void completion_init(completion_t * completion) {
+	completion->done = 0;
+	wait_queue_init(&completion->waiters);
+}
+
+void reinit_completion(completion_t * completion) {
+	uint32_t flags = interrupt_save();
+	completion->done = 0;
+	interrupt_restore(flags);
+}
+
+void complete(completion_t * completion) {
+	uint32_t flags = interrupt_save();
+	
+	if(completion->done != COMPLETION_ALL) {
+		completion->done++;
+	}
+	wake_up_one(&completion->waiters);
+	wait_queue_preempt(flags);
+	
+	interrupt_restore(flags);
+}
+
+void complete_all(completion_t * completion) {
+	uint32_t flags = interrupt_save();
+	
+	completion->done = COMPLETION_ALL;
+	wake_up_all(&completion->waiters);
+	wait_queue_preempt(flags);
+	
+	interrupt_restore(flags);
+}
+
+void wait_for_completion(completion_t * completion) {
+	uint32_t flags = interrupt_save();
+	
+	while(!completion->done) {
+		wait_queue_sleep(&completion->waiters);
+	}
+	
+	if(completion->done != COMPLETION_ALL) {
+		completion->done--;
+	}
+	
+	interrupt_restore(flags);
+}
+
+void semaphore_init(semaphore_t * semaphore, int32_t count) {
+	semaphore->count = count;
+	wait_queue_init(&semaphore->waiters);
+}
+
+void semaphore_down(semaphore_t * semaphore) {
+	uint32_t flags = interrupt_save();
+	
+	while(semaphore->count <= 0) {
+		wait_queue_sleep(&semaphore->waiters);
+	}
+	semaphore->count--;
+	
+	interrupt_restore(flags);
+}
+
+bool semaphore_try_down(semaphore_t * semaphore) {
+	uint32_t flags = interrupt_save();
+	
+	bool taken = semaphore->count > 0;
+	if(taken) {
+		semaphore->count--;
+	}
+	
+	interrupt_restore(flags);
+	return taken;
+}
+
+void semaphore_up(semaphore_t * semaphore) {
+	uint32_t flags = interrupt_save();
+	
+	semaphore->count++;
+	wake_up_one(&semaphore->waiters);
+	wait_queue_preempt(flags);
+	
+	interrupt_restore(flags);
+}
@@ -0,0 +1,68 @@
+#include <work.h>
+#include <interrupt.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+static work_t * work_head = NULL;		/**< The first work in the queue. */
+static work_t * work_tail = NULL;		/**< The last work in the queue, so adding is O(1). */
+static bool work_running = false;		/**< Whether \ref work_run is draining the queue. */
+
+void work_init(work_t * work, work_func_t func, void * arg) {
+	work->next = NULL;
+	work->func = func;
+	work->arg = arg;
+	work->pending = false;
+}
+
+void work_queue(work_t * work) {
+	uint32_t flags = interrupt_save();
+	
+	if(!work->pending) {
+		work->pending = true;
+		work->next = NULL;
+		if(work_tail) {
+			work_tail->next = work;
+		} else {
+			work_head = work;
+		}
+		work_tail = work;
+	}
+	
+	interrupt_restore(flags);
+}
+
+bool work_pending(void) {
+	return work_head != NULL;
+}
+
+bool work_in_progress(void) {
+	return work_running;
+}
+
+void work_run(void) {
+	// An IRQ taken while running the work will get here again, so leave it to the outer one
+	if(work_running) {
+		return;
+	}
+	
+	work_running = true;
+	
+	while(work_head) {
+		work_t * work = work_head;
+		work_head = work->next;
+		if(!work_head) {
+			work_tail = NULL;
+		}
+		
+		// Clear before running so the work can be queued again while it runs
+		work->pending = false;
+		
+		interrupt_enable();
+		work->func(work->arg);
+		interrupt_disable();
+	}
+	
+	work_running = false;
+}
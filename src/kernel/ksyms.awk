@@ -0,0 +1,39 @@
+# Generate the kernel symbol table used by ksyms.c from a "ld -M" map file.
+#
+# Without emit set, prints "address name" for every global symbol in the .text output section.
+# With emit=1, reads those lines (sorted by address) and prints the C symbol table.
+
+BEGIN {
+	count = 0
+}
+
+emit != 1 && /^\./ {
+	in_text = ($1 == ".text")
+}
+
+emit != 1 && in_text && NF == 2 && $1 ~ /^0x[0-9a-fA-F]+$/ && $2 ~ /^[A-Za-z_][A-Za-z0-9_]*$/ {
+	print $1, $2
+}
+
+emit == 1 && NF == 2 {
+	addr[count] = $1
+	name[count] = $2
+	count++
+}
+
+END {
+	if(emit == 1) {
+		print "/* Generated by ksyms.awk from the kernel map, do not edit. */"
+		print "#include <ksyms.h>"
+		print "#include <stddef.h>"
+		print ""
+		print "const ksym_t ksyms_table[] = {"
+		for(i = 0; i < count; i++) {
+			printf("\t{ %s, \"%s\" },\n", addr[i], name[i])
+		}
+		print "\t{ 0, NULL }"
+		print "};"
+		print ""
+		printf("const uint32_t ksyms_count = %d;\n", count)
+	}
+}
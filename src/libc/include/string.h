@@ -74,6 +74,21 @@ size_t strlen(const char * restrict src);
  * 			If return value = 0 then it indicates s1 is equal to s2.\n
  */
 int strcmp(const char * s1, const char * s2);
+
+/**
+ * \brief Pick the fastest memcpy, memmove and memset the CPU can run, like an ifunc resolver. Only
+ * the kernel library has variants other than the scalar loops. Must be called after the CPU
+ * features and FPU are set up.
+ */
+void string_init(void);
+
+/**
+ * \brief Get the name of the variant a memory routine uses.
+ * 
+ * \param [in] func The routine, "memcpy", "memmove" or "memset".
+ * \return The name of the variant, such as "erms", "sse2" or "scalar". NULL if not a routine.
+ */
+const char * string_get_variant(const char * func);
 //char * strcpy(const char *, const char *);
 
 #ifdef __cplusplus
@@ -12,10 +12,10 @@ extern "C" {
 #endif
 
 /**
- * \brief This macro represents the number of processor clocks per second.
- * \todo Will need to be set correctly in the future.
+ * \brief This macro represents the number of processor clocks per second. The clock counts in
+ * microseconds.
  */
-#define CLOCKS_PER_SEC 1
+#define CLOCKS_PER_SEC 1000000
 
 /**
  * \brief The structure for holding all the value in the data and time.
@@ -42,6 +42,53 @@ typedef uint32_t clock_t;
  */
 typedef uint32_t time_t;
 
+/**
+ * \brief Get the processor time used. As there is one kernel, this is the time since boot.
+ * 
+ * \return The time in units of \ref CLOCKS_PER_SEC, wrapping round after about 71 minutes.
+ * (clock_t) -1 if there is no clock.
+ */
+clock_t clock(void);
+
+/**
+ * \brief Get the calendar time, the number of seconds since 00:00:00 UTC, 1 January 1970.
+ * 
+ * \param [out] timer If not NULL, also set to the time.
+ * 
+ * \return The time. (time_t) -1 if there is no clock.
+ */
+time_t time(time_t * timer);
+
+/**
+ * \brief Convert a calendar time to the date and time in UTC.
+ * 
+ * \param [in] timer The calendar time.
+ * 
+ * \return The date and time, in a static structure that the next call overwrites.
+ */
+struct tm * gmtime(const time_t * timer);
+
+/**
+ * \brief Convert a calendar time to the date and time in UTC, into a given structure so is safe
+ * to call from more than one thread.
+ * 
+ * \param [in] timer The calendar time.
+ * \param [out] result The date and time.
+ * 
+ * \return \p result.
+ */
+struct tm * gmtime_r(const time_t * timer, struct tm * result);
+
+/**
+ * \brief Convert a date and time to a calendar time. There are no time zones, so the date is in
+ * UTC. Fields out of their range carry into the next, and the day of the week and year are set.
+ * 
+ * \param [in] timeptr The date and time, normalised in place.
+ * 
+ * \return The calendar time. (time_t) -1 if the date is before 1970.
+ */
+time_t mktime(struct tm * timeptr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,28 @@
 #include <string.h>
 #include <stdint.h>
 
+#if defined(__is_libk)
+#include <cpu_features.h>
+#include <fpu.h>
+#endif
+
+/**
+ * \brief The smallest copy or fill worth saving the FPU registers for to use SSE.
+ */
+#define STRING_SSE2_MIN		512
+
+/**
+ * \struct string_variant_t
+ * 
+ * \brief An implementation of the memory routines for a CPU feature.
+ */
+typedef struct {
+	const char * name;											/**< The name of the variant. */
+	void * (*memcpy)(void * dest, const void * src, size_t n);	/**< The memcpy. */
+	void * (*memmove)(void * dest, const void * src, size_t n);	/**< The memmove. */
+	void * (*memset)(void * src, int c, size_t n);				/**< The memset. */
+} string_variant_t;
+
 int memcmp(const void * ptr1, const void * ptr2, size_t n) {
 	if(ptr1 == ptr2 || n == 0 || !ptr1 || !ptr2) {
 		return 0;
@@ -19,7 +41,16 @@ int memcmp(const void * ptr1, const void * ptr2, size_t n) {
 	return 0;
 }
 
-void * memcpy(void * dest, const void * src, const size_t n) {
+/**
+ * \brief Copy by words if the data is word aligned, else by bytes.
+ * 
+ * \param [in] dest The destination.
+ * \param [in] src The source.
+ * \param [in] n The number of bytes to copy.
+ * 
+ * \return The destination.
+ */
+static void * memcpy_scalar(void * dest, const void * src, const size_t n) {
 	// If the data is word aligned, then can copy by words
 	// Else copy by bytes
 	if(dest == src || n == 0 || !dest || !src) {
@@ -48,7 +79,17 @@ void * memcpy(void * dest, const void * src, const size_t n) {
 	return dest;
 }
 
-void * memmove(void * dest, const void * src, const size_t n) {
+/**
+ * \brief Copy by words if the data is word aligned, else by bytes, backwards if the destination is
+ * after the source.
+ * 
+ * \param [in] dest The destination.
+ * \param [in] src The source.
+ * \param [in] n The number of bytes to copy.
+ * 
+ * \return The destination.
+ */
+static void * memmove_scalar(void * dest, const void * src, const size_t n) {
 	// If the data is word aligned, then can copy by words
 	// Else copy by bytes
 	if(dest == src || n == 0 || !dest || !src) {
@@ -89,7 +130,16 @@ void * memmove(void * dest, const void * src, const size_t n) {
 	return dest;
 }
 
-void * memset(void * src, const int c, size_t n) {
+/**
+ * \brief Fill by bytes.
+ * 
+ * \param [in] src The memory to fill.
+ * \param [in] c The byte to fill with.
+ * \param [in] n The number of bytes to fill.
+ * 
+ * \return The memory filled.
+ */
+static void * memset_scalar(void * src, const int c, size_t n) {
 	unsigned char uc = (unsigned char) c;
 	unsigned char * ptr = (unsigned char *) src;
 	while(n--) {
@@ -98,6 +148,210 @@ void * memset(void * src, const int c, size_t n) {
 	return src;
 }
 
+#if defined(__is_libk)
+/**
+ * \brief Copy with REP MOVSB, which CPUs with ERMS run a cache line at a time.
+ * 
+ * \param [in] dest The destination.
+ * \param [in] src The source.
+ * \param [in] n The number of bytes to copy.
+ * 
+ * \return The destination.
+ */
+static void * memcpy_erms(void * dest, const void * src, const size_t n) {
+	void * d = dest;
+	size_t count = n;
+	__asm__ __volatile__ ("rep movsb" : "+D" (d), "+S" (src), "+c" (count) : : "memory");
+	return dest;
+}
+
+/**
+ * \brief Copy with REP MOVSB when copying forwards is safe, else the scalar copy. Backwards REP
+ * MOVSB isn't a fast string operation.
+ * 
+ * \param [in] dest The destination.
+ * \param [in] src The source.
+ * \param [in] n The number of bytes to copy.
+ * 
+ * \return The destination.
+ */
+static void * memmove_erms(void * dest, const void * src, const size_t n) {
+	if((uintptr_t) dest - (uintptr_t) src < n) {
+		return memmove_scalar(dest, src, n);
+	}
+	return memcpy_erms(dest, src, n);
+}
+
+/**
+ * \brief Fill with REP STOSB, which CPUs with ERMS run a cache line at a time.
+ * 
+ * \param [in] src The memory to fill.
+ * \param [in] c The byte to fill with.
+ * \param [in] n The number of bytes to fill.
+ * 
+ * \return The memory filled.
+ */
+static void * memset_erms(void * src, const int c, size_t n) {
+	void * d = src;
+	__asm__ __volatile__ ("rep stosb" : "+D" (d), "+c" (n) : "a" (c) : "memory");
+	return src;
+}
+
+/**
+ * \brief Copy 64 bytes at a time through the SSE registers. Small copies aren't worth saving the
+ * FPU registers for, so use the scalar copy. The kernel isn't compiled to use SSE, so the compiler
+ * never has anything in the registers.
+ * 
+ * \param [in] dest The destination.
+ * \param [in] src The source.
+ * \param [in] n The number of bytes to copy.
+ * 
+ * \return The destination.
+ */
+static void * memcpy_sse2(void * dest, const void * src, const size_t n) {
+	if(n < STRING_SSE2_MIN) {
+		return memcpy_scalar(dest, src, n);
+	}
+	
+	uint8_t * d = (uint8_t *) dest;
+	const uint8_t * s = (const uint8_t *) src;
+	size_t left = n;
+	
+	kernel_fpu_begin();
+	for(; left >= 64; left -= 64, d += 64, s += 64) {
+		__asm__ __volatile__ (
+			"movdqu xmm0, [%1]\n\t"
+			"movdqu xmm1, [%1 + 16]\n\t"
+			"movdqu xmm2, [%1 + 32]\n\t"
+			"movdqu xmm3, [%1 + 48]\n\t"
+			"movdqu [%0], xmm0\n\t"
+			"movdqu [%0 + 16], xmm1\n\t"
+			"movdqu [%0 + 32], xmm2\n\t"
+			"movdqu [%0 + 48], xmm3"
+			: : "r" (d), "r" (s) : "memory");
+	}
+	kernel_fpu_end();
+	
+	memcpy_scalar(d, s, left);
+	return dest;
+}
+
+/**
+ * \brief Copy through the SSE registers when copying forwards is safe, else the scalar copy.
+ * 
+ * \param [in] dest The destination.
+ * \param [in] src The source.
+ * \param [in] n The number of bytes to copy.
+ * 
+ * \return The destination.
+ */
+static void * memmove_sse2(void * dest, const void * src, const size_t n) {
+	// Each 64 bytes is read before it is written, so the source can be less than 64 bytes ahead
+	if((uintptr_t) dest - (uintptr_t) src < n) {
+		return memmove_scalar(dest, src, n);
+	}
+	return memcpy_sse2(dest, src, n);
+}
+
+/**
+ * \brief Fill 64 bytes at a time through the SSE registers. Small fills aren't worth saving the FPU
+ * registers for, so use the scalar fill.
+ * 
+ * \param [in] src The memory to fill.
+ * \param [in] c The byte to fill with.
+ * \param [in] n The number of bytes to fill.
+ * 
+ * \return The memory filled.
+ */
+static void * memset_sse2(void * src, const int c, size_t n) {
+	if(n < STRING_SSE2_MIN) {
+		return memset_scalar(src, c, n);
+	}
+	
+	uint8_t pattern[16] __attribute__((aligned(16)));
+	memset_scalar(pattern, c, sizeof(pattern));
+	
+	uint8_t * d = (uint8_t *) src;
+	
+	kernel_fpu_begin();
+	__asm__ __volatile__ ("movdqa xmm0, [%0]" : : "r" (pattern) : "memory");
+	for(; n >= 64; n -= 64, d += 64) {
+		__asm__ __volatile__ (
+			"movdqu [%0], xmm0\n\t"
+			"movdqu [%0 + 16], xmm0\n\t"
+			"movdqu [%0 + 32], xmm0\n\t"
+			"movdqu [%0 + 48], xmm0"
+			: : "r" (d) : "memory");
+	}
+	kernel_fpu_end();
+	
+	memset_scalar(d, c, n);
+	return src;
+}
+#endif /* __is_libk */
+
+/**
+ * \brief The implementations to pick from, the best last.
+ */
+static const string_variant_t string_variants[] = {
+	{ "scalar", memcpy_scalar, memmove_scalar, memset_scalar },
+#if defined(__is_libk)
+	{ "sse2", memcpy_sse2, memmove_sse2, memset_sse2 },
+	{ "erms", memcpy_erms, memmove_erms, memset_erms }
+#endif
+};
+
+static const string_variant_t * memcpy_variant = &string_variants[0];		/**< The variant memcpy uses. */
+static const string_variant_t * memmove_variant = &string_variants[0];	/**< The variant memmove uses. */
+static const string_variant_t * memset_variant = &string_variants[0];		/**< The variant memset uses. */
+
+void * memcpy(void * dest, const void * src, const size_t n) {
+	if(dest == src || n == 0 || !dest || !src) {
+		return dest;
+	}
+	
+	return memcpy_variant->memcpy(dest, src, n);
+}
+
+void * memmove(void * dest, const void * src, const size_t n) {
+	if(dest == src || n == 0 || !dest || !src) {
+		return dest;
+	}
+	
+	return memmove_variant->memmove(dest, src, n);
+}
+
+void * memset(void * src, const int c, size_t n) {
+	return memset_variant->memset(src, c, n);
+}
+
+void string_init(void) {
+#if defined(__is_libk)
+	// Like an ifunc resolver, pick the best each CPU can run once, so each call is one indirect jump
+	const string_variant_t * best = &string_variants[0];
+	if(cpu_has(CPU_FEATURE_ERMS)) {
+		best = &string_variants[2];
+	} else if(fpu_has_sse2()) {
+		best = &string_variants[1];
+	}
+	
+	memcpy_variant = best;
+	memmove_variant = best;
+	memset_variant = best;
+#endif
+}
+
+const char * string_get_variant(const char * func) {
+	if(strcmp(func, "memcpy") == 0) {
+		return memcpy_variant->name;
+	} else if(strcmp(func, "memmove") == 0) {
+		return memmove_variant->name;
+	} else if(strcmp(func, "memset") == 0) {
+		return memset_variant->name;
+	}
+	return NULL;
+}
+
 size_t strlen(const char * src) {
 	size_t len = 0;
 	
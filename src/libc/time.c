@@ -1 +1,140 @@
-#include <time.h>
\ No newline at end of file
+#include <time.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <clock.h>
+#include <cpu.h>
+#include <timekeeping.h>
+
+/**
+ * \brief The number of seconds in a day.
+ */
+#define SECONDS_PER_DAY		86400
+
+/**
+ * \brief The number of days in 400 years, after which the calendar repeats.
+ */
+#define DAYS_PER_ERA		146097
+
+/**
+ * \brief The number of days from 1 March of year 0 to 1 January 1970. Counting years from March
+ * puts the leap day at the end, so the days of the months don't depend on the year.
+ */
+#define DAYS_TO_EPOCH		719468
+
+/**
+ * \brief The number of days before each month in a year that isn't a leap year.
+ */
+static const int days_before_month[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+/**
+ * \brief Get whether a year is a leap year.
+ * 
+ * \param [in] year The year.
+ * 
+ * \return Whether it is a leap year.
+ */
+static bool is_leap_year(int year) {
+	return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+clock_t clock(void) {
+	return (clock_t) cpu_div64(clock_monotonic_ns(), CLOCK_NS_PER_SEC / CLOCKS_PER_SEC);
+}
+
+time_t time(time_t * timer) {
+	time_t now = timekeeping_get_time();
+	
+	if(timer) {
+		*timer = now;
+	}
+	
+	return now;
+}
+
+struct tm * gmtime_r(const time_t * timer, struct tm * result) {
+	if(!timer || !result) {
+		return NULL;
+	}
+	
+	uint32_t days = *timer / SECONDS_PER_DAY;
+	uint32_t seconds = *timer % SECONDS_PER_DAY;
+	
+	result->tm_hour = seconds / 3600;
+	result->tm_min = (seconds / 60) % 60;
+	result->tm_sec = seconds % 60;
+	
+	// 1 January 1970 was a Thursday
+	result->tm_wday = (days + 4) % 7;
+	
+	// Find the year of the 400 year era, then the day of that year, counting from March
+	uint32_t z = days + DAYS_TO_EPOCH;
+	uint32_t era = z / DAYS_PER_ERA;
+	uint32_t day_of_era = z - era * DAYS_PER_ERA;
+	uint32_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+	uint32_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+	uint32_t month = (5 * day_of_year + 2) / 153;
+	int year = (int) (year_of_era + era * 400);
+	
+	result->tm_mday = (int) (day_of_year - (153 * month + 2) / 5 + 1);
+	result->tm_mon = month < 10 ? (int) month + 2 : (int) month - 10;
+	
+	// January and February are at the end of the year counted from March
+	if(result->tm_mon < 2) {
+		year++;
+	}
+	
+	result->tm_year = year - 1900;
+	result->tm_yday = days_before_month[result->tm_mon] + result->tm_mday - 1;
+	if(result->tm_mon > 1 && is_leap_year(year)) {
+		result->tm_yday++;
+	}
+	result->tm_isdst = 0;
+	
+	return result;
+}
+
+struct tm * gmtime(const time_t * timer) {
+	static struct tm result;
+	return gmtime_r(timer, &result);
+}
+
+time_t mktime(struct tm * timeptr) {
+	if(!timeptr) {
+		return (time_t) -1;
+	}
+	
+	// Carry the months into the years, so the month is in range for the day count
+	int year = timeptr->tm_year + 1900 + timeptr->tm_mon / 12;
+	int month = timeptr->tm_mon % 12;
+	if(month < 0) {
+		month += 12;
+		year--;
+	}
+	
+	// Count from March, as in gmtime_r
+	if(month < 2) {
+		year--;
+	}
+	
+	if(year < 1969) {
+		return (time_t) -1;
+	}
+	
+	int era = year / 400;
+	int year_of_era = year - era * 400;
+	int day_of_year = (153 * (month > 1 ? month - 2 : month + 10) + 2) / 5 + timeptr->tm_mday - 1;
+	int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	int32_t days = era * DAYS_PER_ERA + day_of_era - DAYS_TO_EPOCH;
+	int32_t seconds = timeptr->tm_hour * 3600 + timeptr->tm_min * 60 + timeptr->tm_sec;
+	
+	// The other fields can carry into the days, so add up as signed then check
+	int64_t total = (int64_t) days * SECONDS_PER_DAY + seconds;
+	if(total < 0 || total > UINT32_MAX - 1) {
+		return (time_t) -1;
+	}
+	
+	time_t result = (time_t) total;
+	gmtime_r(&result, timeptr);
+	return result;
+}